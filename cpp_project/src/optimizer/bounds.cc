@@ -0,0 +1,148 @@
+#include "bounds.h"
+
+#include <absl/types/span.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "utils/logging.h"
+
+namespace optimizer {
+
+namespace {
+
+// Folds x back into [lower, upper] by mirroring it at the bounds. Only called
+// for x outside the bounds.
+double Reflect(double x, double lower, double upper) {
+  if (std::isinf(upper)) {
+    return 2 * lower - x;
+  }
+  if (std::isinf(lower)) {
+    return 2 * upper - x;
+  }
+  const double width = upper - lower;
+  if (width == 0) {
+    return lower;
+  }
+  // Mirroring at both bounds repeats with a period of twice the width.
+  double y = std::fmod(x - lower, 2 * width);
+  if (y < 0) {
+    y += 2 * width;
+  }
+  const double reflected = lower + (y <= width ? y : 2 * width - y);
+  // Rounding may land just outside the bounds.
+  return std::min(std::max(reflected, lower), upper);
+}
+
+}  // namespace
+
+Bounds::Bounds(std::vector<double> lower, std::vector<double> upper,
+               BoundHandling handling)
+    : lower_(std::move(lower)), upper_(std::move(upper)), handling_(handling) {
+  SPDLOG_CHECK(lower_.size() == upper_.size(),
+               fmt::format("Bounds must have the same size: lower.size()={}, "
+                           "upper.size()={}",
+                           lower_.size(), upper_.size()));
+  for (size_t j = 0; j < n_dims(); ++j) {
+    SPDLOG_CHECK(lower_[j] <= upper_[j],
+                 fmt::format("Lower bound {} is larger than upper bound {} in "
+                             "dimension {}.",
+                             lower_[j], upper_[j], j));
+  }
+}
+
+void Bounds::Enforce(absl::Span<double> points) const {
+  const size_t n_dims = this->n_dims();
+  const double* lower = lower_.data();
+  const double* upper = upper_.data();
+  switch (handling_) {
+    case BoundHandling::kClamp:
+      for (size_t offset = 0; offset < points.size(); offset += n_dims) {
+        double* x = points.data() + offset;
+        for (size_t j = 0; j < n_dims; ++j) {
+          x[j] = std::min(std::max(x[j], lower[j]), upper[j]);
+        }
+      }
+      break;
+    case BoundHandling::kReflect:
+      for (size_t offset = 0; offset < points.size(); offset += n_dims) {
+        double* x = points.data() + offset;
+        for (size_t j = 0; j < n_dims; ++j) {
+          if (x[j] < lower[j] || upper[j] < x[j]) {
+            x[j] = Reflect(x[j], lower[j], upper[j]);
+          }
+        }
+      }
+      break;
+    case BoundHandling::kTransform:
+      break;
+  }
+}
+
+void Bounds::ToBounded(absl::Span<const double> points,
+                       absl::Span<double> bounded) const {
+  SPDLOG_CHECK(points.size() == bounded.size(),
+               fmt::format("Expected {} coordinates but got {}.",
+                           points.size(), bounded.size()));
+  if (!transforms()) {
+    std::copy(points.begin(), points.end(), bounded.begin());
+    return;
+  }
+
+  const size_t n_dims = this->n_dims();
+  for (size_t offset = 0; offset < points.size(); offset += n_dims) {
+    const double* z = points.data() + offset;
+    double* x = bounded.data() + offset;
+    for (size_t j = 0; j < n_dims; ++j) {
+      const double lower = lower_[j];
+      const double upper = upper_[j];
+      if (std::isfinite(lower) && std::isfinite(upper)) {
+        x[j] = lower + (upper - lower) * (std::sin(z[j]) + 1) / 2;
+      } else if (std::isfinite(lower)) {
+        x[j] = lower - 1 + std::sqrt(z[j] * z[j] + 1);
+      } else if (std::isfinite(upper)) {
+        x[j] = upper + 1 - std::sqrt(z[j] * z[j] + 1);
+      } else {
+        x[j] = z[j];
+      }
+    }
+  }
+}
+
+void Bounds::FromBounded(absl::Span<const double> bounded,
+                         absl::Span<double> points) const {
+  SPDLOG_CHECK(points.size() == bounded.size(),
+               fmt::format("Expected {} coordinates but got {}.",
+                           bounded.size(), points.size()));
+  const size_t n_dims = this->n_dims();
+  for (size_t offset = 0; offset < bounded.size(); offset += n_dims) {
+    const double* x = bounded.data() + offset;
+    double* z = points.data() + offset;
+    for (size_t j = 0; j < n_dims; ++j) {
+      const double lower = lower_[j];
+      const double upper = upper_[j];
+      const double clamped = std::min(std::max(x[j], lower), upper);
+      if (!transforms()) {
+        z[j] = clamped;
+      } else if (std::isfinite(lower) && std::isfinite(upper)) {
+        const double width = upper - lower;
+        const double s = width == 0 ? 0 : 2 * (clamped - lower) / width - 1;
+        z[j] = std::asin(std::min(std::max(s, -1.0), 1.0));
+      } else if (std::isfinite(lower)) {
+        const double d = clamped - lower + 1;
+        z[j] = std::sqrt(d * d - 1);
+      } else if (std::isfinite(upper)) {
+        const double d = upper - clamped + 1;
+        z[j] = std::sqrt(d * d - 1);
+      } else {
+        z[j] = clamped;
+      }
+    }
+  }
+}
+
+}  // namespace optimizer
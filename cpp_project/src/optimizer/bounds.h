@@ -0,0 +1,76 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <absl/types/span.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace optimizer {
+
+// How an optimizer keeps its points within the bounds.
+enum class BoundHandling {
+  // Moves every coordinate outside the bounds onto the nearest bound. Points
+  // far outside collapse onto the same face, so the simplex may lose a
+  // dimension and the same point may be evaluated several times.
+  kClamp,
+  // Mirrors every coordinate outside the bounds at the violated bound, folding
+  // it back into the bounds as often as needed. Distinct points stay
+  // distinct, except for points mirrored onto each other.
+  kReflect,
+  // Searches an unconstrained space whose points are mapped into the bounds
+  // before they are evaluated: x = l + (u - l) (sin(z) + 1) / 2 for two
+  // finite bounds, x = l - 1 + sqrt(z^2 + 1) for a lower bound only and
+  // x = u + 1 - sqrt(z^2 + 1) for an upper bound only. The tolerances and the
+  // stencil then apply to z instead of x.
+  kTransform,
+};
+
+// Per-dimension bounds lower[j] <= x[j] <= upper[j]. Infinite bounds leave a
+// dimension unbounded on that side. All operations work on a row-major matrix
+// of points with n_dims() columns, so they run as one loop over contiguous
+// memory that the compiler can vectorize.
+class Bounds {
+ public:
+  // Unbounded and without dimensions.
+  Bounds() = default;
+
+  // `lower` and `upper` must have the same size, and lower[j] <= upper[j] for
+  // every dimension j.
+  Bounds(std::vector<double> lower, std::vector<double> upper,
+         BoundHandling handling);
+
+  size_t n_dims() const { return lower_.size(); }
+  const std::vector<double>& lower() const { return lower_; }
+  const std::vector<double>& upper() const { return upper_; }
+  BoundHandling handling() const { return handling_; }
+
+  // True if the optimizer searches a transformed space, i.e. for
+  // BoundHandling::kTransform.
+  bool transforms() const { return handling_ == BoundHandling::kTransform; }
+
+  // Moves the coordinates of `points` outside the bounds back into the
+  // bounds by clamping or reflecting them. Does nothing for kTransform,
+  // whose search space is unconstrained.
+  void Enforce(absl::Span<double> points) const;
+
+  // Maps `points` of the search space to the bounded points written to
+  // `bounded`, which must have the same size. Copies the points unless the
+  // bounds transform.
+  void ToBounded(absl::Span<const double> points,
+                 absl::Span<double> bounded) const;
+
+  // Maps `bounded` to points of the search space written to `points`, the
+  // inverse of ToBounded. Coordinates outside the bounds are clamped first.
+  void FromBounded(absl::Span<const double> bounded,
+                   absl::Span<double> points) const;
+
+ private:
+  std::vector<double> lower_;
+  std::vector<double> upper_;
+  BoundHandling handling_ = BoundHandling::kClamp;
+};
+
+}  // namespace optimizer
+
+#endif  // BOUNDS_H
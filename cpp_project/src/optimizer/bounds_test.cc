@@ -0,0 +1,90 @@
+#include "bounds.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace optimizer {
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+TEST(BoundsTest, ClampsEveryRow) {
+  Bounds bounds({0, -kInf}, {1, 2}, BoundHandling::kClamp);
+  std::vector<double> points = {-1, 3, 0.5, -5, 2, 1};
+  bounds.Enforce(absl::MakeSpan(points));
+  EXPECT_EQ(points, std::vector<double>({0, 2, 0.5, -5, 1, 1}));
+}
+
+TEST(BoundsTest, ReflectsIntoBounds) {
+  Bounds bounds({0, -kInf, 1}, {1, 2, kInf}, BoundHandling::kReflect);
+  std::vector<double> points = {-0.25, 3, 0.5,  //
+                                1.25, -5, 1.5,  //
+                                3.5, 1, 2};
+  bounds.Enforce(absl::MakeSpan(points));
+  EXPECT_EQ(points, std::vector<double>({0.25, 1, 1.5,  //
+                                         0.75, -5, 1.5,  //
+                                         0.5, 1, 2}));
+
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> distribution(-100, 100);
+  Bounds box({-1, 2}, {1, 2.5}, BoundHandling::kReflect);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<double> x = {distribution(generator),
+                             distribution(generator)};
+    box.Enforce(absl::MakeSpan(x));
+    EXPECT_GE(x[0], -1);
+    EXPECT_LE(x[0], 1);
+    EXPECT_GE(x[1], 2);
+    EXPECT_LE(x[1], 2.5);
+  }
+}
+
+TEST(BoundsTest, TransformMapsIntoBoundsAndBack) {
+  Bounds bounds({0, -kInf, 1, -kInf}, {1, 2, kInf, kInf},
+                BoundHandling::kTransform);
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> distribution(-10, 10);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<double> z(4);
+    for (double& value : z) {
+      value = distribution(generator);
+    }
+    std::vector<double> x(4);
+    bounds.ToBounded(z, absl::MakeSpan(x));
+    EXPECT_GE(x[0], 0);
+    EXPECT_LE(x[0], 1);
+    EXPECT_LE(x[1], 2);
+    EXPECT_GE(x[2], 1);
+    EXPECT_EQ(x[3], z[3]);
+
+    // The inverse recovers x, though not z, whose transform is periodic or
+    // symmetric.
+    std::vector<double> inverse(4);
+    bounds.FromBounded(x, absl::MakeSpan(inverse));
+    std::vector<double> roundtrip(4);
+    bounds.ToBounded(inverse, absl::MakeSpan(roundtrip));
+    for (size_t j = 0; j < x.size(); ++j) {
+      EXPECT_NEAR(roundtrip[j], x[j], 1e-12 * (1 + std::abs(x[j])));
+    }
+  }
+
+  // Transformed bounds are never violated, so Enforce does nothing.
+  std::vector<double> z = {5, 5, -5, 5};
+  bounds.Enforce(absl::MakeSpan(z));
+  EXPECT_EQ(z, std::vector<double>({5, 5, -5, 5}));
+}
+
+TEST(BoundsTest, RejectsInvalidBounds) {
+  EXPECT_THROW(Bounds({0, 0}, {1}, BoundHandling::kClamp),
+               std::runtime_error);
+  EXPECT_THROW(Bounds({0, 2}, {1, 1}, BoundHandling::kClamp),
+               std::runtime_error);
+}
+
+}  // namespace
+}  // namespace optimizer
@@ -0,0 +1,174 @@
+#include "checkpoint.h"
+
+#include <absl/types/span.h>
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "utils/logging.h"
+
+namespace optimizer {
+
+namespace {
+
+constexpr size_t kMagicSize = 8;
+
+// Returns the directory that contains the file at `path`.
+std::string DirectoryOf(const std::string& path) {
+  const size_t slash = path.find_last_of('/');
+  if (slash == std::string::npos) {
+    return ".";
+  }
+  return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+}  // namespace
+
+CheckpointWriter::CheckpointWriter(std::string& buffer,
+                                   const char (&magic)[9], uint32_t version)
+    : buffer_(buffer) {
+  buffer_.clear();
+  Append(magic, kMagicSize);
+  Append(&version, sizeof(version));
+}
+
+void CheckpointWriter::WriteSize(size_t value) {
+  const uint64_t stored = value;
+  Append(&stored, sizeof(stored));
+}
+
+void CheckpointWriter::WriteDouble(double value) {
+  Append(&value, sizeof(value));
+}
+
+void CheckpointWriter::WriteSizes(absl::Span<const size_t> values) {
+  WriteSize(values.size());
+  for (size_t value : values) {
+    WriteSize(value);
+  }
+}
+
+void CheckpointWriter::WriteDoubles(absl::Span<const double> values) {
+  WriteSize(values.size());
+  Append(values.data(), values.size() * sizeof(double));
+}
+
+void CheckpointWriter::Append(const void* data, size_t size) {
+  buffer_.append(static_cast<const char*>(data), size);
+}
+
+CheckpointReader::CheckpointReader(absl::Span<const char> data,
+                                   const char (&magic)[9], uint32_t version)
+    : data_(data) {
+  char stored_magic[kMagicSize];
+  Extract(stored_magic, kMagicSize);
+  SPDLOG_CHECK(std::memcmp(stored_magic, magic, kMagicSize) == 0,
+               fmt::format("Not a {} checkpoint.", magic));
+  uint32_t stored_version = 0;
+  Extract(&stored_version, sizeof(stored_version));
+  SPDLOG_CHECK(stored_version == version,
+               fmt::format("Unsupported checkpoint version {}, expected {}.",
+                           stored_version, version));
+}
+
+size_t CheckpointReader::ReadSize() {
+  uint64_t value = 0;
+  Extract(&value, sizeof(value));
+  return value;
+}
+
+double CheckpointReader::ReadDouble() {
+  double value = 0;
+  Extract(&value, sizeof(value));
+  return value;
+}
+
+void CheckpointReader::ReadSizes(absl::Span<size_t> values) {
+  const size_t size = ReadSize();
+  SPDLOG_CHECK(size == values.size(),
+               fmt::format("Expected {} values in the checkpoint but got {}.",
+                           values.size(), size));
+  for (size_t& value : values) {
+    value = ReadSize();
+  }
+}
+
+void CheckpointReader::ReadDoubles(absl::Span<double> values) {
+  const size_t size = ReadSize();
+  SPDLOG_CHECK(size == values.size(),
+               fmt::format("Expected {} values in the checkpoint but got {}.",
+                           values.size(), size));
+  Extract(values.data(), values.size() * sizeof(double));
+}
+
+void CheckpointReader::Finish() const {
+  SPDLOG_CHECK(position_ == data_.size(),
+               fmt::format("{} unread bytes at the end of the checkpoint.",
+                           data_.size() - position_));
+}
+
+void CheckpointReader::Extract(void* data, size_t size) {
+  SPDLOG_CHECK(data_.size() - position_ >= size,
+               fmt::format("Checkpoint is truncated after {} bytes.",
+                           data_.size()));
+  std::memcpy(data, data_.data() + position_, size);
+  position_ += size;
+}
+
+void WriteCheckpointFile(const std::string& path, const std::string& data) {
+  const std::string temporary_path = path + ".tmp";
+  const int fd =
+      open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+           0644);
+  SPDLOG_CHECK(fd >= 0, fmt::format("Cannot open checkpoint file {}.",
+                                    temporary_path));
+  size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t n =
+        write(fd, data.data() + written, data.size() - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    written += static_cast<size_t>(n);
+  }
+  // Without fsync the rename can reach the disk before the data, and a crash
+  // leaves an empty or truncated checkpoint behind.
+  const bool synced = written == data.size() && fsync(fd) == 0;
+  close(fd);
+  SPDLOG_CHECK(synced, fmt::format("Cannot write checkpoint file {}.",
+                                   temporary_path));
+  SPDLOG_CHECK(std::rename(temporary_path.c_str(), path.c_str()) == 0,
+               fmt::format("Cannot rename {} to {}.", temporary_path, path));
+
+  // The rename itself is only durable once the directory is synced.
+  const std::string directory = DirectoryOf(path);
+  const int directory_fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  SPDLOG_CHECK(directory_fd >= 0,
+               fmt::format("Cannot open directory {}.", directory));
+  const bool directory_synced = fsync(directory_fd) == 0;
+  close(directory_fd);
+  SPDLOG_CHECK(directory_synced,
+               fmt::format("Cannot sync directory {}.", directory));
+}
+
+std::string ReadCheckpointFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  SPDLOG_CHECK(file.is_open(),
+               fmt::format("Cannot open checkpoint file {}.", path));
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+}  // namespace optimizer
@@ -0,0 +1,78 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <absl/types/span.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace optimizer {
+
+// Appends values to a flat binary checkpoint. Numbers are stored with their
+// in-memory representation, so doubles round-trip exactly, and a checkpoint
+// can only be read on a machine with the same byte order. The buffer keeps
+// its capacity between checkpoints, so writing a checkpoint of the same size
+// again does not allocate. Unlike JSON through nlohmann_json, which the
+// project also links, nothing is formatted as text, so a checkpoint is cheap
+// to write every few iterations.
+class CheckpointWriter {
+ public:
+  // Clears `buffer` and writes the header of a checkpoint of the given kind
+  // and version to it. The buffer must outlive the writer.
+  CheckpointWriter(std::string& buffer, const char (&magic)[9],
+                   uint32_t version);
+
+  void WriteSize(size_t value);
+  void WriteDouble(double value);
+
+  // Writes the size of `values` followed by its elements.
+  void WriteSizes(absl::Span<const size_t> values);
+  void WriteDoubles(absl::Span<const double> values);
+
+ private:
+  void Append(const void* data, size_t size);
+
+  std::string& buffer_;
+};
+
+// Reads the values of a checkpoint in the order they were written. Throws a
+// std::runtime_error if the checkpoint is truncated or does not match what is
+// read.
+class CheckpointReader {
+ public:
+  // Checks the header of `data` against `magic` and `version`. The data must
+  // outlive the reader.
+  CheckpointReader(absl::Span<const char> data, const char (&magic)[9],
+                   uint32_t version);
+
+  size_t ReadSize();
+  double ReadDouble();
+
+  // Reads a span written by WriteSizes or WriteDoubles into `values`, whose
+  // size must match the stored one.
+  void ReadSizes(absl::Span<size_t> values);
+  void ReadDoubles(absl::Span<double> values);
+
+  // Checks that every byte of the checkpoint was read.
+  void Finish() const;
+
+ private:
+  void Extract(void* data, size_t size);
+
+  absl::Span<const char> data_;
+  size_t position_ = 0;
+};
+
+// Writes `data` to `path` through a temporary file in the same directory that
+// is renamed onto `path`. The file is synced to disk before the rename and the
+// directory after it, so a crash or power loss leaves either the previous or
+// the new checkpoint, never a partial one.
+void WriteCheckpointFile(const std::string& path, const std::string& data);
+
+// Returns the content of the checkpoint file at `path`.
+std::string ReadCheckpointFile(const std::string& path);
+
+}  // namespace optimizer
+
+#endif  // CHECKPOINT_H
@@ -0,0 +1,79 @@
+#include "checkpoint.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace optimizer {
+namespace {
+
+constexpr char kMagic[9] = "TESTCKPT";
+
+TEST(CheckpointTest, RoundTripsValuesExactly) {
+  const std::vector<double> doubles = {
+      0.1, -0.0, std::numeric_limits<double>::denorm_min(),
+      std::numeric_limits<double>::infinity()};
+  const std::vector<size_t> sizes = {0, 7,
+                                     std::numeric_limits<size_t>::max()};
+  std::string buffer;
+  CheckpointWriter writer(buffer, kMagic, 3);
+  writer.WriteSize(42);
+  writer.WriteDouble(1.0 / 3);
+  writer.WriteDoubles(doubles);
+  writer.WriteSizes(sizes);
+
+  CheckpointReader reader(buffer, kMagic, 3);
+  EXPECT_EQ(reader.ReadSize(), 42);
+  EXPECT_EQ(reader.ReadDouble(), 1.0 / 3);
+  std::vector<double> read_doubles(doubles.size());
+  reader.ReadDoubles(absl::MakeSpan(read_doubles));
+  EXPECT_EQ(read_doubles, doubles);
+  EXPECT_TRUE(std::signbit(read_doubles[1]));
+  std::vector<size_t> read_sizes(sizes.size());
+  reader.ReadSizes(absl::MakeSpan(read_sizes));
+  EXPECT_EQ(read_sizes, sizes);
+  reader.Finish();
+}
+
+TEST(CheckpointTest, RejectsMismatchedCheckpoints) {
+  std::string buffer;
+  CheckpointWriter writer(buffer, kMagic, 1);
+  writer.WriteDoubles(std::vector<double>{1, 2});
+
+  EXPECT_THROW(CheckpointReader(buffer, "OTHERKND", 1), std::runtime_error);
+  EXPECT_THROW(CheckpointReader(buffer, kMagic, 2), std::runtime_error);
+
+  std::vector<double> values(3);
+  CheckpointReader wrong_size(buffer, kMagic, 1);
+  EXPECT_THROW(wrong_size.ReadDoubles(absl::MakeSpan(values)),
+               std::runtime_error);
+
+  CheckpointReader truncated(absl::MakeConstSpan(buffer).first(16), kMagic,
+                             1);
+  EXPECT_THROW(truncated.ReadSize(), std::runtime_error);
+
+  CheckpointReader unread(buffer, kMagic, 1);
+  EXPECT_THROW(unread.Finish(), std::runtime_error);
+}
+
+TEST(CheckpointTest, ReplacesFile) {
+  const std::string path = testing::TempDir() + "/checkpoint_test.bin";
+  WriteCheckpointFile(path, std::string("first\0", 6));
+  EXPECT_EQ(ReadCheckpointFile(path), std::string("first\0", 6));
+  WriteCheckpointFile(path, "second");
+  EXPECT_EQ(ReadCheckpointFile(path), "second");
+  std::remove(path.c_str());
+
+  EXPECT_THROW(ReadCheckpointFile(path), std::runtime_error);
+  EXPECT_THROW(WriteCheckpointFile(path + "/missing/directory", "data"),
+               std::runtime_error);
+}
+
+}  // namespace
+}  // namespace optimizer
@@ -0,0 +1,324 @@
+#include "cma_es.h"
+
+#include <absl/types/span.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/logging.h"
+#include "utils/math.h"
+
+namespace optimizer {
+
+namespace {
+
+// Computes the eigendecomposition A = V diag(eigenvalues) V^T of the
+// symmetric n x n row-major matrix `a` with the cyclic Jacobi method. The
+// eigenvectors are written to the columns of the row-major matrix
+// `eigenvectors`.
+void SymmetricEigen(std::vector<double> a, size_t n,
+                    std::vector<double>& eigenvalues,
+                    std::vector<double>& eigenvectors) {
+  std::vector<double>& v = eigenvectors;
+  v.assign(n * n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    v[i * n + i] = 1;
+  }
+
+  constexpr int kMaxSweeps = 50;
+  for (int sweep = 0; sweep < kMaxSweeps; ++sweep) {
+    double diagonal = 0;
+    double off_diagonal = 0;
+    for (size_t p = 0; p < n; ++p) {
+      diagonal += a[p * n + p] * a[p * n + p];
+      for (size_t q = p + 1; q < n; ++q) {
+        off_diagonal += a[p * n + q] * a[p * n + q];
+      }
+    }
+    if (off_diagonal <= 1e-30 * diagonal) {
+      break;
+    }
+
+    for (size_t p = 0; p < n; ++p) {
+      for (size_t q = p + 1; q < n; ++q) {
+        const double apq = a[p * n + q];
+        if (apq == 0) {
+          continue;
+        }
+        // Rotation by the angle that zeroes a[p][q].
+        const double theta = (a[q * n + q] - a[p * n + p]) / (2 * apq);
+        const double t = (theta >= 0 ? 1 : -1) /
+                         (std::abs(theta) + std::sqrt(theta * theta + 1));
+        const double c = 1 / std::sqrt(t * t + 1);
+        const double s = t * c;
+        for (size_t k = 0; k < n; ++k) {
+          const double akp = a[k * n + p];
+          const double akq = a[k * n + q];
+          a[k * n + p] = c * akp - s * akq;
+          a[k * n + q] = s * akp + c * akq;
+        }
+        for (size_t k = 0; k < n; ++k) {
+          const double apk = a[p * n + k];
+          const double aqk = a[q * n + k];
+          a[p * n + k] = c * apk - s * aqk;
+          a[q * n + k] = s * apk + c * aqk;
+        }
+        for (size_t k = 0; k < n; ++k) {
+          const double vkp = v[k * n + p];
+          const double vkq = v[k * n + q];
+          v[k * n + p] = c * vkp - s * vkq;
+          v[k * n + q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  eigenvalues.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    eigenvalues[i] = a[i * n + i];
+  }
+}
+
+}  // namespace
+
+std::vector<double> CmaEs::Minimize(const CallbackFunction& callback,
+                                    const std::vector<double>& initial_point) {
+  return Minimize(MakeBatchCallback(callback, num_threads), initial_point);
+}
+
+std::vector<double> CmaEs::Minimize(const BatchCallbackFunction& callback,
+                                    const std::vector<double>& initial_point) {
+  SPDLOG_CHECK(!initial_point.empty(), "Initial point vector cannot be empty.");
+  SPDLOG_CHECK(initial_step_size > 0,
+               fmt::format("initial_step_size must be positive: {}",
+                           initial_step_size));
+
+  iterations = 0;
+  fcalls = 0;
+  fun = std::numeric_limits<double>::infinity();
+  success = false;
+  status = "Optimization has not started yet.";
+
+  // Strategy parameters of the tutorial, Table 1.
+  const size_t n = initial_point.size();
+  const double nd = static_cast<double>(n);
+  const size_t lambda = population_size > 0
+                            ? population_size
+                            : 4 + static_cast<size_t>(3 * std::log(nd));
+  SPDLOG_CHECK(lambda >= 2,
+               fmt::format("population_size must be at least 2: {}", lambda));
+  const size_t mu = lambda / 2;
+  std::vector<double> weights(mu);
+  for (size_t i = 0; i < mu; ++i) {
+    weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+  }
+  const double weight_sum =
+      std::accumulate(weights.begin(), weights.end(), 0.0);
+  double weight_squares = 0;
+  for (double& w : weights) {
+    w /= weight_sum;
+    weight_squares += w * w;
+  }
+  const double mueff = 1 / weight_squares;
+
+  const double cc = (4 + mueff / nd) / (nd + 4 + 2 * mueff / nd);
+  const double cs = (mueff + 2) / (nd + mueff + 5);
+  const double c1 = 2 / ((nd + 1.3) * (nd + 1.3) + mueff);
+  const double cmu = std::min(
+      1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((nd + 2) * (nd + 2) + mueff));
+  const double damps =
+      1 + 2 * std::max(0.0, std::sqrt((mueff - 1) / (nd + 1)) - 1) + cs;
+  const double chi_n = std::sqrt(nd) * (1 - 1 / (4 * nd) + 1 / (21 * nd * nd));
+  // The eigendecomposition costs O(n^3), so like Hansen's reference code it is
+  // only updated once C has changed noticeably, after more than this many
+  // function calls. That is every O(n / mueff) generations.
+  const double eigen_interval = lambda / (c1 + cmu) / nd / 10;
+
+  // State of the search distribution N(mean, sigma^2 C), C = B D^2 B^T.
+  std::vector<double> mean = initial_point;
+  double sigma = initial_step_size;
+  std::vector<double> c(n * n, 0);
+  std::vector<double> b(n * n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    c[i * n + i] = 1;
+    b[i * n + i] = 1;
+  }
+  std::vector<double> d(n, 1);
+  std::vector<double> pc(n, 0);
+  std::vector<double> ps(n, 0);
+  size_t eigen_fcalls = 0;
+
+  std::vector<double> y(lambda * n);
+  std::vector<double> x(lambda * n);
+  std::vector<double> f(lambda);
+  std::vector<size_t> order(lambda);
+  std::vector<double> yw(n);
+  std::vector<double> temp(n);
+  std::vector<double> eigenvalues;
+  std::vector<double> best_x = initial_point;
+
+  std::mt19937_64 generator(seed);
+  std::normal_distribution<double> normal;
+
+  while (true) {
+    if (fcalls + lambda > maxfun) {
+      status = fmt::format("Optimizer did NOT converge. fcalls({}) + "
+                           "population_size({}) > maxfun({}), iterations: {}",
+                           fcalls, lambda, maxfun, iterations);
+      break;
+    }
+    if (iterations >= maxiter) {
+      status = fmt::format("Optimizer did NOT converge. iterations({}) >= "
+                           "maxiter({}), fcalls: {}",
+                           iterations, maxiter, fcalls);
+      break;
+    }
+    if (stop_requested && stop_requested()) {
+      status = fmt::format("Optimizer was stopped on request. fcalls: {}, "
+                           "iterations: {}",
+                           fcalls, iterations);
+      break;
+    }
+
+    // Samples x_k = mean + sigma * B D z_k with z_k ~ N(0, I).
+    for (size_t k = 0; k < lambda; ++k) {
+      for (size_t i = 0; i < n; ++i) {
+        temp[i] = d[i] * normal(generator);
+      }
+      double* yk = &y[k * n];
+      double* xk = &x[k * n];
+      for (size_t j = 0; j < n; ++j) {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+          sum += b[j * n + i] * temp[i];
+        }
+        yk[j] = sum;
+        xk[j] = mean[j] + sigma * sum;
+      }
+    }
+    callback(x, absl::MakeSpan(f));
+    fcalls += lambda;
+    iterations += 1;
+
+    // Only the mu best points need to be ranked.
+    utils::PartialArgsort(f, mu, absl::MakeSpan(order));
+    if (f[order[0]] < fun) {
+      fun = f[order[0]];
+      best_x.assign(&x[order[0] * n], &x[order[0] * n] + n);
+    }
+
+    // Moves the mean to the weighted average of the mu best points.
+    std::fill(yw.begin(), yw.end(), 0);
+    for (size_t i = 0; i < mu; ++i) {
+      const double* yi = &y[order[i] * n];
+      for (size_t j = 0; j < n; ++j) {
+        yw[j] += weights[i] * yi[j];
+      }
+    }
+    for (size_t j = 0; j < n; ++j) {
+      mean[j] += sigma * yw[j];
+    }
+
+    // Evolution path of sigma, ps += C^(-1/2) yw, with
+    // C^(-1/2) = B D^-1 B^T.
+    for (size_t i = 0; i < n; ++i) {
+      double sum = 0;
+      for (size_t j = 0; j < n; ++j) {
+        sum += b[j * n + i] * yw[j];
+      }
+      temp[i] = sum / d[i];
+    }
+    const double ps_factor = std::sqrt(cs * (2 - cs) * mueff);
+    double ps_norm = 0;
+    for (size_t j = 0; j < n; ++j) {
+      double sum = 0;
+      for (size_t i = 0; i < n; ++i) {
+        sum += b[j * n + i] * temp[i];
+      }
+      ps[j] = (1 - cs) * ps[j] + ps_factor * sum;
+      ps_norm += ps[j] * ps[j];
+    }
+    ps_norm = std::sqrt(ps_norm);
+
+    // Evolution path of C. It is stalled while ps is large, so that C does
+    // not grow too fast when sigma is too small.
+    const double ps_unbiased =
+        ps_norm / std::sqrt(1 - std::pow(1 - cs, 2.0 * iterations));
+    const double hsig = ps_unbiased / chi_n < 1.4 + 2 / (nd + 1) ? 1 : 0;
+    const double pc_factor = hsig * std::sqrt(cc * (2 - cc) * mueff);
+    for (size_t j = 0; j < n; ++j) {
+      pc[j] = (1 - cc) * pc[j] + pc_factor * yw[j];
+    }
+
+    // Rank-one and rank-mu update of C.
+    const double keep = 1 - c1 - cmu + c1 * (1 - hsig) * cc * (2 - cc);
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t k = 0; k <= j; ++k) {
+        double rank_mu = 0;
+        for (size_t i = 0; i < mu; ++i) {
+          const double* yi = &y[order[i] * n];
+          rank_mu += weights[i] * yi[j] * yi[k];
+        }
+        const double value =
+            keep * c[j * n + k] + c1 * pc[j] * pc[k] + cmu * rank_mu;
+        c[j * n + k] = value;
+        c[k * n + j] = value;
+      }
+    }
+
+    sigma *= std::exp(std::min(1.0, (cs / damps) * (ps_norm / chi_n - 1)));
+
+    if (static_cast<double>(fcalls - eigen_fcalls) > eigen_interval) {
+      eigen_fcalls = fcalls;
+      SymmetricEigen(c, n, eigenvalues, b);
+      for (size_t i = 0; i < n; ++i) {
+        d[i] = std::sqrt(std::max(eigenvalues[i],
+                                  std::numeric_limits<double>::min()));
+      }
+    }
+
+    if (fun <= ftarget) {
+      success = true;
+      status = fmt::format("Optimizer reached ftarget. f({}) <= ftarget({}), "
+                           "fcalls: {}, iterations: {}",
+                           fun, ftarget, fcalls, iterations);
+      break;
+    }
+
+    double max_variance = 0;
+    for (size_t i = 0; i < n; ++i) {
+      max_variance = std::max(max_variance, c[i * n + i]);
+    }
+    const bool meets_xatol = sigma * std::sqrt(max_variance) < xatol;
+    const bool meets_fatol =
+        *std::max_element(f.begin(), f.end()) - f[order[0]] < fatol;
+    if (meets_xatol || meets_fatol) {
+      success = true;
+      status = fmt::format("Optimizer converged. fcalls: {}, iterations: {}, "
+                           "meets_xatol: {}, meets_fatol: {}",
+                           fcalls, iterations, meets_xatol, meets_fatol);
+      break;
+    }
+  }
+
+  return best_x;
+}
+
+OptimizerResult CmaEs::result() const {
+  OptimizerResult result;
+  result.fun = fun;
+  result.iterations = iterations;
+  result.fcalls = fcalls;
+  result.success = success;
+  result.status = status;
+  return result;
+}
+
+}  // namespace optimizer
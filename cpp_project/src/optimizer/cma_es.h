@@ -0,0 +1,99 @@
+#ifndef CMA_ES_H
+#define CMA_ES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "optimizer/optimizer.h"
+
+namespace optimizer {
+
+// Covariance matrix adaptation evolution strategy, following Hansen, "The CMA
+// Evolution Strategy: A Tutorial" (2016). Every generation samples a
+// population of points from a multivariate normal distribution and moves the
+// distribution towards the better half of them. The whole population is sent
+// to the callback as one batch, so all its points can be evaluated in
+// parallel. For a given seed the result is deterministic and does not depend
+// on num_threads.
+class CmaEs : public Optimizer {
+ public:
+  CmaEs(const std::string& name = "CMA-ES") : name_(name) {};
+
+  std::vector<double> Minimize(
+      const CallbackFunction& callback,
+      const std::vector<double>& initial_point) override;
+
+  // Same as above, but every generation is sent to the callback as one
+  // batch.
+  std::vector<double> Minimize(
+      const BatchCallbackFunction& callback,
+      const std::vector<double>& initial_point) override;
+
+  std::string name() override { return name_; };
+
+  OptimizerResult result() const override;
+
+  // Initial standard deviation of the sampled points around the initial
+  // point, in every dimension. About a third of the distance to the minimum
+  // works well.
+  double initial_step_size = 0.5;
+
+  // Number of points per generation. With 0, 4 + floor(3 ln(n)) is used for
+  // n dimensions. Larger populations search more globally and use more
+  // threads per generation, at the cost of more function calls.
+  size_t population_size = 0;
+
+  // Seed of the random number generator that samples the points.
+  uint64_t seed = 1;
+
+  // The optimization converged once the step size times the largest standard
+  // deviation of the distribution is smaller than xatol, or the function
+  // values of a generation differ by less than fatol.
+  double xatol = 1e-4;
+  double fatol = 1e-4;
+
+  // Maximum number of function calls. A generation is only started if all of
+  // its points fit into the budget.
+  size_t maxfun = 10000;
+
+  // Maximum number of generations.
+  size_t maxiter = 1000;
+
+  // The optimization stops successfully once the best function value is at or
+  // below ftarget.
+  double ftarget = -std::numeric_limits<double>::infinity();
+
+  // If set, called once per generation. The optimization stops without
+  // success once it returns true.
+  std::function<bool()> stop_requested;
+
+  // Number of threads used to evaluate the points of a generation
+  // concurrently. Larger values than 1 require a thread-safe callback.
+  size_t num_threads = 1;
+
+  // Number of generations.
+  size_t iterations = 0;
+
+  // Number of function calls.
+  size_t fcalls = 0;
+
+  // Best function value found.
+  double fun = std::numeric_limits<double>::infinity();
+
+  // Specifies if the optimization has succeeded.
+  bool success = false;
+
+  // Get information about the convergence status of the optimizer.
+  std::string status;
+
+ private:
+  std::string name_;
+};
+
+}  // namespace optimizer
+
+#endif  // CMA_ES_H
@@ -0,0 +1,86 @@
+#include "cma_es.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "testing/test_functions.h"
+
+namespace optimizer {
+namespace {
+
+// Ellipsoid with condition number 1e6 whose axes are rotated away from the
+// coordinate axes, so that the search has to learn the covariance.
+double RotatedEllipsoid(const std::vector<double>& x) {
+  const size_t n = x.size();
+  double value = 0;
+  for (size_t i = 0; i < n; ++i) {
+    // Rotates by 45 degrees in the planes of the dimension pairs.
+    const size_t partner = i ^ 1;
+    const double yi = partner < n ? (i % 2 == 0 ? x[i] + x[partner]
+                                                : x[i] - x[partner]) /
+                                        std::sqrt(2.0)
+                                  : x[i];
+    value += std::pow(1e6, double(i) / double(n - 1)) * (yi - 1) * (yi - 1);
+  }
+  return value;
+}
+
+CmaEs MakeOptimizer() {
+  CmaEs optimizer;
+  optimizer.xatol = 1e-10;
+  optimizer.fatol = 1e-14;
+  optimizer.maxfun = 100000;
+  optimizer.maxiter = 100000;
+  return optimizer;
+}
+
+TEST(CmaEsTest, LearnsIllConditionedRotatedEllipsoid) {
+  CmaEs optimizer = MakeOptimizer();
+  optimizer.Minimize(RotatedEllipsoid, std::vector<double>(8, 0));
+  EXPECT_TRUE(optimizer.success) << optimizer.status;
+  EXPECT_LT(optimizer.fun, 1e-8);
+}
+
+TEST(CmaEsTest, MinimizesRosenbrock) {
+  auto rosenbrock = [](const std::vector<double>& x) {
+    return testing::Rosenbrock(x);
+  };
+  CmaEs optimizer = MakeOptimizer();
+  std::vector<double> x =
+      optimizer.Minimize(rosenbrock, std::vector<double>(10, 0));
+  EXPECT_LT(optimizer.fun, 1e-8) << optimizer.status;
+  for (double xi : x) {
+    EXPECT_NEAR(xi, 1, 1e-3);
+  }
+}
+
+TEST(CmaEsTest, SeedDeterminesSamples) {
+  CmaEs optimizer = MakeOptimizer();
+  optimizer.maxiter = 20;
+  std::vector<double> initial_point(5, 0);
+  std::vector<double> x = optimizer.Minimize(RotatedEllipsoid, initial_point);
+  EXPECT_EQ(optimizer.Minimize(RotatedEllipsoid, initial_point), x);
+
+  optimizer.seed = 2;
+  EXPECT_NE(optimizer.Minimize(RotatedEllipsoid, initial_point), x);
+}
+
+TEST(CmaEsTest, EvaluatesWholeGenerationsWithinBudget) {
+  CmaEs optimizer = MakeOptimizer();
+  optimizer.population_size = 12;
+  optimizer.maxfun = 100;
+  optimizer.Minimize(RotatedEllipsoid, std::vector<double>(5, 0));
+  EXPECT_FALSE(optimizer.success);
+  EXPECT_EQ(optimizer.fcalls, 96);
+  EXPECT_EQ(optimizer.iterations, 8);
+
+  optimizer.population_size = 1;
+  EXPECT_THROW(optimizer.Minimize(RotatedEllipsoid, {0, 0}),
+               std::runtime_error);
+}
+
+}  // namespace
+}  // namespace optimizer
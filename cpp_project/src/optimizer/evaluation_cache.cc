@@ -0,0 +1,88 @@
+#include "evaluation_cache.h"
+
+#include <absl/types/span.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+namespace optimizer {
+
+namespace {
+
+// Buckets reserved up front. A large capacity is rarely filled, so beyond this
+// the index grows as values are added.
+constexpr size_t kInitialBuckets = 1024;
+
+}  // namespace
+
+EvaluationCache::EvaluationCache(size_t capacity, double quantum)
+    : capacity_(capacity), quantum_(quantum) {
+  index_.reserve(std::min(capacity, kInitialBuckets));
+}
+
+size_t EvaluationCache::KeyHash::operator()(const Key& key) const {
+  size_t hash = key.size();
+  for (int64_t k : key) {
+    hash ^= std::hash<int64_t>()(k) + 0x9e3779b97f4a7c15ULL + (hash << 6) +
+            (hash >> 2);
+  }
+  return hash;
+}
+
+void EvaluationCache::MakeKey(absl::Span<const double> point) {
+  key_.resize(point.size());
+  for (size_t i = 0; i < point.size(); ++i) {
+    if (quantum_ > 0) {
+      key_[i] = std::llround(point[i] / quantum_);
+    } else {
+      // Adding 0 maps -0.0 to 0.0 so both share a key.
+      double x = point[i] + 0.0;
+      std::memcpy(&key_[i], &x, sizeof(x));
+    }
+  }
+}
+
+bool EvaluationCache::Lookup(absl::Span<const double> point, double& value) {
+  MakeKey(point);
+  auto it = index_.find(key_);
+  if (it == index_.end()) {
+    return false;
+  }
+
+  // Mark the entry as the most recently used one.
+  entries_.splice(entries_.begin(), entries_, it->second);
+  value = it->second->second;
+  return true;
+}
+
+void EvaluationCache::Insert(absl::Span<const double> point, double value) {
+  if (capacity_ == 0) {
+    return;
+  }
+
+  MakeKey(point);
+  auto it = index_.find(key_);
+  if (it != index_.end()) {
+    it->second->second = value;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+
+  if (index_.size() >= capacity_) {
+    // Reuse the least recently used entry for the new value.
+    index_.erase(entries_.back().first);
+    entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+    entries_.front().first = key_;
+    entries_.front().second = value;
+  } else {
+    entries_.emplace_front(key_, value);
+  }
+  index_.emplace(key_, entries_.begin());
+}
+
+}  // namespace optimizer
@@ -0,0 +1,61 @@
+#ifndef EVALUATION_CACHE_H
+#define EVALUATION_CACHE_H
+
+#include <absl/types/span.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace optimizer {
+
+// Least recently used cache of objective function values keyed on the
+// evaluated point.
+class EvaluationCache {
+ public:
+  // Creates a cache that holds at most `capacity` values. If `quantum` is 0,
+  // only points that are exactly equal share a value. Otherwise every
+  // coordinate is rounded to a multiple of `quantum` first, so points closer
+  // than `quantum` may share a value.
+  explicit EvaluationCache(size_t capacity, double quantum = 0);
+
+  // Returns true and writes the cached value of `point` to `value` if the
+  // point is in the cache.
+  bool Lookup(absl::Span<const double> point, double& value);
+
+  // Adds the value of `point` to the cache and evicts the least recently used
+  // value if the cache is full.
+  void Insert(absl::Span<const double> point, double value);
+
+  // Number of cached values.
+  size_t size() const { return index_.size(); }
+
+ private:
+  using Key = std::vector<int64_t>;
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  using Entry = std::pair<Key, double>;
+
+  // Writes the key of `point` to `key_`.
+  void MakeKey(absl::Span<const double> point);
+
+  size_t capacity_;
+  double quantum_;
+
+  // Entries ordered from most to least recently used.
+  std::list<Entry> entries_;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+
+  // Scratch key reused between calls.
+  Key key_;
+};
+
+}  // namespace optimizer
+
+#endif  // EVALUATION_CACHE_H
@@ -0,0 +1,69 @@
+#include "evaluation_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace optimizer {
+namespace {
+
+TEST(EvaluationCacheTest, ExactModeOnlyMatchesEqualPoints) {
+  EvaluationCache cache(10);
+  cache.Insert(std::vector<double>{1, 2}, 3);
+
+  double value = 0;
+  EXPECT_TRUE(cache.Lookup(std::vector<double>{1, 2}, value));
+  EXPECT_EQ(value, 3);
+  EXPECT_FALSE(cache.Lookup(std::vector<double>{1, 2 + 1e-15}, value));
+  EXPECT_FALSE(cache.Lookup(std::vector<double>{1, 2, 0}, value));
+}
+
+TEST(EvaluationCacheTest, NegativeZeroMatchesZero) {
+  EvaluationCache cache(10);
+  cache.Insert(std::vector<double>{0.0}, 1);
+
+  double value = 0;
+  EXPECT_TRUE(cache.Lookup(std::vector<double>{-0.0}, value));
+}
+
+TEST(EvaluationCacheTest, QuantizedModeMatchesNearbyPoints) {
+  EvaluationCache cache(10, /*quantum=*/1e-3);
+  cache.Insert(std::vector<double>{1, 2}, 3);
+
+  double value = 0;
+  EXPECT_TRUE(cache.Lookup(std::vector<double>{1.0001, 1.9999}, value));
+  EXPECT_EQ(value, 3);
+  EXPECT_FALSE(cache.Lookup(std::vector<double>{1.01, 2}, value));
+}
+
+// The index grows with the values, so a capacity that is never reached does
+// not allocate memory for it.
+TEST(EvaluationCacheTest, LargeCapacityIsNotAllocatedUpFront) {
+  EvaluationCache cache(size_t{1} << 40);
+  cache.Insert(std::vector<double>{1, 2}, 3);
+
+  double value = 0;
+  EXPECT_TRUE(cache.Lookup(std::vector<double>{1, 2}, value));
+  EXPECT_EQ(value, 3);
+}
+
+TEST(EvaluationCacheTest, EvictsLeastRecentlyUsedValue) {
+  EvaluationCache cache(2);
+  double value = 0;
+  cache.Insert(std::vector<double>{1}, 1);
+  cache.Insert(std::vector<double>{2}, 2);
+  // Using {1} makes {2} the least recently used value.
+  EXPECT_TRUE(cache.Lookup(std::vector<double>{1}, value));
+
+  cache.Insert(std::vector<double>{3}, 3);
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_TRUE(cache.Lookup(std::vector<double>{1}, value));
+  EXPECT_FALSE(cache.Lookup(std::vector<double>{2}, value));
+  EXPECT_TRUE(cache.Lookup(std::vector<double>{3}, value));
+  EXPECT_EQ(value, 3);
+}
+
+}  // namespace
+}  // namespace optimizer
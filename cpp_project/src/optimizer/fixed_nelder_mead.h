@@ -0,0 +1,483 @@
+#ifndef FIXED_NELDER_MEAD_H
+#define FIXED_NELDER_MEAD_H
+
+#include <absl/types/span.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <string>
+
+#include "optimizer/simplex.h"
+#include "utils/math.h"
+
+namespace optimizer {
+
+// Nelder-Mead optimizer for a search space whose dimension N is known at
+// compile time. The simplex is kept in std::arrays inside the optimizer, so
+// nothing is allocated on the heap and every loop over the dimensions has a
+// constant trip count that the compiler can unroll and vectorize. This mostly
+// pays off for cheap objectives, where the bookkeeping of ScipyNelderMead
+// dominates the run time.
+//
+// The algorithm, its options and its status messages are the same as the
+// serial mode of ScipyNelderMead, and for the same options both take
+// identical steps. Parallel evaluation and the evaluation cache are only
+// available in ScipyNelderMead, which remains the choice for dimensions that
+// are only known at run time.
+template <size_t N>
+class NelderMead {
+  static_assert(N > 0, "The search space needs at least one dimension.");
+
+ public:
+  using Point = std::array<double, N>;
+
+  NelderMead(const std::string& name = "Nelder Mead") : name_(name) {
+    stencile.fill(0.05);
+  };
+
+  // Minimizes `callback`, which is called as `double callback(const Point&)`.
+  // The callback is a template parameter so that cheap objectives can be
+  // inlined into the iteration.
+  template <typename Function>
+  Point Minimize(const Function& callback, const Point& initial_point);
+
+  std::string name() { return name_; };
+
+  // tolerance for movement in the input search space for detecting convergence.
+  double xatol = 1e-4;
+
+  // tolerance for movement in the output space for detecting convergence.
+  double fatol = 1e-4;
+
+  // Stencil value of each dimension used for making the initial simplex.
+  Point stencile;
+
+  // How the initial simplex is built. Every function call is counted in
+  // fcalls.
+  InitialSimplex initial_simplex = InitialSimplex::kLineSearch;
+
+  // Maximum number of function calls.
+  size_t maxfun = 100;
+
+  // Maximum number of iterations
+  size_t maxiter = 500;
+
+  // The optimization stops successfully once the best function value is at or
+  // below ftarget.
+  double ftarget = -std::numeric_limits<double>::infinity();
+
+  // If set, called once per iteration. The optimization stops without success
+  // once it returns true.
+  std::function<bool()> stop_requested;
+
+  // Number of iterations.
+  size_t iterations = 0;
+
+  // Number of function calls.
+  size_t fcalls = 0;
+
+  // Iterations between two full recomputations of the running sum of the
+  // simplex points. See ScipyNelderMead::centroid_resync_interval.
+  size_t centroid_resync_interval = 100;
+
+  // Parameters for updating simplex points.
+  double rho = 1;
+  double chi = 2;
+  double psi = 0.5;
+  double sigma = 0.5;
+
+  // If true, the parameters above are set from N. See
+  // ScipyNelderMead::adaptive.
+  bool adaptive = false;
+
+  // lower and upper bound of the search space for all dimensions.
+  double lower_bound = -std::numeric_limits<double>::infinity();
+  double upper_bound = std::numeric_limits<double>::infinity();
+
+  // Function value at the point returned by Minimize.
+  double fun = std::numeric_limits<double>::infinity();
+
+  // Specifies if the optimization has succeeded.
+  bool success = false;
+
+  // Get information about the convergence status of the optimizer.
+  std::string status;
+
+ private:
+  // Number of points in the simplex.
+  static constexpr size_t kSize = N + 1;
+
+  // Number of steps of each line search of InitialSimplex::kLineSearch and
+  // InitialSimplex::kBisection.
+  static constexpr int kLineSearchSteps = 20;
+  static constexpr int kBisectionSteps = 6;
+
+  // Point with rank k, where rank 0 is the best point.
+  Point& point(size_t k) { return points_[order_[k]]; }
+  double& value(size_t k) { return values_[order_[k]]; }
+
+  // Builds and evaluates the initial simplex like ScipyNelderMead, but the line
+  // searches of the dimensions run one after the other.
+  template <typename Function>
+  void MakeSimplex(const Function& callback, const Point& initial_point);
+
+  void RecomputeSum();
+
+  // Replaces the worst point and its value and updates point_sum_ in O(N).
+  void ReplaceWorst(const Point& x, double f);
+
+  // Ranks the points by function value, like Simplex::Sort().
+  void Sort();
+
+  // Same as Sort() if only the worst point changed since the last Sort().
+  void SortWorst();
+
+  // Moves the points into rank order.
+  void Compact();
+
+  void EnforceBounds(Point& x) const;
+
+  bool SimplexMeetsAbsoluteTolerance();
+
+  bool FunctionMeetsAbsoluteTolerance();
+
+  std::string name_;
+
+  // The simplex. Point k is stored in points_[order_[k]].
+  std::array<Point, kSize> points_;
+  std::array<double, kSize> values_;
+  std::array<size_t, kSize> order_;
+  Point point_sum_;
+};
+
+template <size_t N>
+template <typename Function>
+typename NelderMead<N>::Point NelderMead<N>::Minimize(
+    const Function& callback, const Point& initial_point) {
+  iterations = 0;
+  fcalls = 0;
+  fun = std::numeric_limits<double>::infinity();
+  success = false;
+  status = "Optimization has not started yet.";
+
+  // The parameters used by this run. The options are left untouched.
+  double reflection = rho;
+  double expansion = chi;
+  double contraction = psi;
+  double shrinkage = sigma;
+  if (adaptive) {
+    const double n = static_cast<double>(N);
+    reflection = 1;
+    expansion = 1 + 2 / n;
+    contraction = 0.75 - 1 / (2 * n);
+    shrinkage = 1 - 1 / n;
+  }
+
+  MakeSimplex(callback, initial_point);
+
+  // sort simplex so that the first point has the lowest function value.
+  Sort();
+
+  Point xbar;
+  Point xr;
+  Point xe;
+  Point xc;
+
+  while (true) {
+    if (fcalls > maxfun) {
+      success = false;
+      status = fmt::format(
+          "Optimizer did NOT converged. fcalls({}) > maxfun({}), "
+          "iterations: {}, "
+          "simplex_meets_xatol: {}, function_meets_fatol: {}",
+          fcalls, maxfun, iterations, SimplexMeetsAbsoluteTolerance(),
+          FunctionMeetsAbsoluteTolerance());
+      break;
+    }
+
+    if (iterations > maxiter) {
+      success = false;
+      status = fmt::format(
+          "Optimizer did NOT converged. iterations({}) > maxiter({}), "
+          "fcalls: {}, "
+          "simplex_meets_xatol: {}, function_meets_fatol: {}",
+          iterations, maxiter, fcalls, SimplexMeetsAbsoluteTolerance(),
+          FunctionMeetsAbsoluteTolerance());
+      break;
+    }
+
+    if (SimplexMeetsAbsoluteTolerance() || FunctionMeetsAbsoluteTolerance()) {
+      success = true;
+      status = fmt::format(
+          "Optimizer converged. fcalls: {}, iterations: {}, "
+          "simplex_meets_xatol: {}, function_meets_fatol: {}",
+          fcalls, iterations, SimplexMeetsAbsoluteTolerance(),
+          FunctionMeetsAbsoluteTolerance());
+      break;
+    }
+
+    if (value(0) <= ftarget) {
+      success = true;
+      status = fmt::format(
+          "Optimizer reached ftarget. f({}) <= ftarget({}), fcalls: {}, "
+          "iterations: {}",
+          value(0), ftarget, fcalls, iterations);
+      break;
+    }
+
+    if (stop_requested && stop_requested()) {
+      success = false;
+      status = fmt::format(
+          "Optimizer was stopped on request. fcalls: {}, iterations: {}",
+          fcalls, iterations);
+      break;
+    }
+
+    if (centroid_resync_interval <= 1 ||
+        iterations % centroid_resync_interval == 0) {
+      RecomputeSum();
+    }
+    const Point& worst = point(N);
+    const double f_worst = value(N);
+    for (size_t j = 0; j < N; ++j) {
+      xbar[j] = (point_sum_[j] - worst[j]) / static_cast<double>(N);
+    }
+
+    // The candidates are computed with the same fused multiply-adds as the
+    // Axpby calls of ScipyNelderMead, but only once they are needed.
+    for (size_t j = 0; j < N; ++j) {
+      xr[j] = std::fma(1 + reflection, xbar[j], -reflection * worst[j]);
+    }
+    EnforceBounds(xr);
+    const double f_xr = callback(xr);
+    fcalls++;
+
+    bool shrink = false;
+    if (f_xr < value(0)) {
+      for (size_t j = 0; j < N; ++j) {
+        xe[j] = std::fma(1 + reflection * expansion, xbar[j],
+                         -(reflection * expansion) * worst[j]);
+      }
+      EnforceBounds(xe);
+      const double f_xe = callback(xe);
+      fcalls++;
+      if (f_xe < f_xr) {
+        ReplaceWorst(xe, f_xe);
+      } else {
+        ReplaceWorst(xr, f_xr);
+      }
+    } else if (f_xr < value(N - 1)) {
+      ReplaceWorst(xr, f_xr);
+    } else if (f_xr < f_worst) {
+      // Perform contraction
+      for (size_t j = 0; j < N; ++j) {
+        xc[j] = std::fma(1 + contraction * reflection, xbar[j],
+                         -(contraction * reflection) * worst[j]);
+      }
+      EnforceBounds(xc);
+      const double f_xc = callback(xc);
+      fcalls++;
+      if (f_xc <= f_xr) {
+        ReplaceWorst(xc, f_xc);
+      } else {
+        shrink = true;
+      }
+    } else {
+      // Perform an inside contraction
+      for (size_t j = 0; j < N; ++j) {
+        xc[j] = std::fma(1 - contraction, xbar[j], contraction * worst[j]);
+      }
+      EnforceBounds(xc);
+      const double f_xcc = callback(xc);
+      fcalls++;
+      if (f_xcc < f_worst) {
+        ReplaceWorst(xc, f_xcc);
+      } else {
+        shrink = true;
+      }
+    }
+
+    if (shrink) {
+      Compact();
+      const Point& best = points_[0];
+      for (size_t i = 1; i < kSize; ++i) {
+        Point& x = points_[i];
+        for (size_t j = 0; j < N; ++j) {
+          x[j] = std::fma(1 - shrinkage, best[j], shrinkage * x[j]);
+        }
+        EnforceBounds(x);
+      }
+      for (size_t i = 1; i < kSize; ++i) {
+        values_[i] = callback(points_[i]);
+      }
+      fcalls += N;
+      RecomputeSum();
+    }
+
+    iterations++;
+    if (shrink) {
+      Sort();
+    } else {
+      SortWorst();
+    }
+  }
+
+  fun = value(0);
+  return point(0);
+}
+
+template <size_t N>
+template <typename Function>
+void NelderMead<N>::MakeSimplex(const Function& callback,
+                                const Point& initial_point) {
+  points_.fill(initial_point);
+  std::iota(order_.begin(), order_.end(), 0);
+
+  if (initial_simplex == InitialSimplex::kStencil) {
+    for (size_t i = 1; i < kSize; ++i) {
+      points_[i][i - 1] += stencile[i - 1];
+      EnforceBounds(points_[i]);
+    }
+    for (size_t i = 0; i < kSize; ++i) {
+      values_[i] = callback(points_[i]);
+    }
+    fcalls += kSize;
+    RecomputeSum();
+    return;
+  }
+
+  const double f0 = callback(initial_point);
+  fcalls++;
+  values_[0] = f0;
+
+  // Point i + 1 of the simplex walks from the full range towards the initial
+  // point along dimension i and stops at the first point better than the
+  // initial point.
+  const bool bisection = initial_simplex == InitialSimplex::kBisection;
+  const int n_steps = bisection ? kBisectionSteps : kLineSearchSteps;
+  for (size_t i = 0; i < N; ++i) {
+    Point& x = points_[i + 1];
+    const double step_size = stencile[i] / double(kLineSearchSteps);
+    double first_step_x = 0;
+    double first_step_f = 0;
+    bool found = false;
+    for (int k = 0; k < n_steps; k++) {
+      const double offset = bisection ? std::ldexp(stencile[i], -k)
+                                      : step_size * (kLineSearchSteps - k);
+      x[i] = initial_point[i] + offset;
+      EnforceBounds(x);
+      const double f = callback(x);
+      fcalls++;
+      if (k == 0) {
+        first_step_x = x[i];
+        first_step_f = f;
+      }
+      if (f < f0) {
+        values_[i + 1] = f;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      x[i] = initial_point[i] + stencile[i];
+      EnforceBounds(x);
+      if (x[i] == first_step_x) {
+        values_[i + 1] = first_step_f;
+      } else {
+        values_[i + 1] = callback(x);
+        fcalls++;
+      }
+    }
+  }
+
+  RecomputeSum();
+}
+
+template <size_t N>
+void NelderMead<N>::RecomputeSum() {
+  point_sum_.fill(0);
+  for (size_t i = 0; i < kSize; ++i) {
+    for (size_t j = 0; j < N; ++j) {
+      point_sum_[j] += points_[i][j];
+    }
+  }
+}
+
+template <size_t N>
+void NelderMead<N>::ReplaceWorst(const Point& x, double f) {
+  Point& worst = point(N);
+  for (size_t j = 0; j < N; ++j) {
+    point_sum_[j] += x[j] - worst[j];
+  }
+  worst = x;
+  value(N) = f;
+}
+
+template <size_t N>
+void NelderMead<N>::Sort() {
+  utils::Argsort(values_, absl::MakeSpan(order_));
+}
+
+template <size_t N>
+void NelderMead<N>::SortWorst() {
+  utils::ArgsortUpdate(values_, N, absl::MakeSpan(order_));
+}
+
+template <size_t N>
+void NelderMead<N>::Compact() {
+  std::array<Point, kSize> points;
+  std::array<double, kSize> values;
+  for (size_t k = 0; k < kSize; ++k) {
+    points[k] = point(k);
+    values[k] = value(k);
+  }
+  points_ = points;
+  values_ = values;
+  std::iota(order_.begin(), order_.end(), 0);
+}
+
+template <size_t N>
+void NelderMead<N>::EnforceBounds(Point& x) const {
+  for (double& p : x) {
+    if (p < lower_bound) {
+      p = lower_bound;
+    }
+    if (upper_bound < p) {
+      p = upper_bound;
+    }
+  }
+}
+
+template <size_t N>
+bool NelderMead<N>::SimplexMeetsAbsoluteTolerance() {
+  const Point& best = point(0);
+  for (size_t i = 1; i < kSize; ++i) {
+    const Point& x = point(i);
+    for (size_t j = 0; j < N; ++j) {
+      if (std::abs(x[j] - best[j]) > xatol) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <size_t N>
+bool NelderMead<N>::FunctionMeetsAbsoluteTolerance() {
+  for (size_t i = 1; i < kSize; ++i) {
+    if (std::abs(value(i) - value(0)) > fatol) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace optimizer
+
+#endif  // FIXED_NELDER_MEAD_H
@@ -0,0 +1,134 @@
+#include "fixed_nelder_mead.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "optimizer/nelder_mead.h"
+
+namespace optimizer {
+namespace {
+
+// Sum of (x_i - i)^2 with minimum at x_i = i.
+template <typename Point>
+double ShiftedQuadratic(const Point& x) {
+  double value = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    value += std::pow(x[i] - static_cast<double>(i), 2);
+  }
+  return value;
+};
+
+template <typename Point>
+double Rosenbrock(const Point& x) {
+  double value = 0;
+  for (size_t i = 0; i + 1 < x.size(); ++i) {
+    value += 100 * std::pow(x[i + 1] - x[i] * x[i], 2) + std::pow(1 - x[i], 2);
+  }
+  return value;
+};
+
+// Runs NelderMead<N> and ScipyNelderMead with the same options and expects
+// identical results.
+template <size_t N, typename Function>
+void ExpectSameAsScipyNelderMead(const Function& function,
+                                 const std::array<double, N>& initial_point,
+                                 double lower_bound, double upper_bound,
+                                 bool adaptive = false,
+                                 InitialSimplex initial_simplex =
+                                     InitialSimplex::kLineSearch) {
+  NelderMead<N> fixed;
+  fixed.fatol = 1e-12;
+  fixed.xatol = 1e-8;
+  fixed.maxfun = 20000;
+  fixed.maxiter = 20000;
+  fixed.lower_bound = lower_bound;
+  fixed.upper_bound = upper_bound;
+  fixed.adaptive = adaptive;
+  fixed.initial_simplex = initial_simplex;
+  std::array<double, N> fixed_x = fixed.Minimize(function, initial_point);
+
+  ScipyNelderMead dynamic;
+  dynamic.fatol = fixed.fatol;
+  dynamic.xatol = fixed.xatol;
+  dynamic.maxfun = fixed.maxfun;
+  dynamic.maxiter = fixed.maxiter;
+  dynamic.lower_bound = lower_bound;
+  dynamic.upper_bound = upper_bound;
+  dynamic.adaptive = adaptive;
+  dynamic.initial_simplex = initial_simplex;
+  std::vector<double> dynamic_x = dynamic.Minimize(
+      [&](const std::vector<double>& x) { return function(x); },
+      std::vector<double>(initial_point.begin(), initial_point.end()));
+
+  EXPECT_EQ(std::vector<double>(fixed_x.begin(), fixed_x.end()), dynamic_x);
+  EXPECT_EQ(fixed.fun, dynamic.fun);
+  EXPECT_EQ(fixed.fcalls, dynamic.fcalls);
+  EXPECT_EQ(fixed.iterations, dynamic.iterations);
+  EXPECT_EQ(fixed.success, dynamic.success);
+  EXPECT_EQ(fixed.status, dynamic.status);
+}
+
+TEST(NelderMeadTest, MinimizesShiftedQuadratic) {
+  NelderMead<4> optimizer;
+  optimizer.fatol = 1e-12;
+  optimizer.xatol = 1e-8;
+  optimizer.maxfun = 5000;
+  optimizer.maxiter = 5000;
+
+  std::array<double, 4> x = optimizer.Minimize(
+      ShiftedQuadratic<std::array<double, 4>>, {0.5, 0.5, 0.5, 0.5});
+
+  EXPECT_TRUE(optimizer.success);
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_NEAR(x[i], i, 1e-4);
+  }
+}
+
+TEST(NelderMeadTest, MatchesScipyNelderMead) {
+  auto quadratic = [](const auto& x) { return ShiftedQuadratic(x); };
+  auto rosenbrock = [](const auto& x) { return Rosenbrock(x); };
+  const double inf = std::numeric_limits<double>::infinity();
+
+  ExpectSameAsScipyNelderMead<1>(quadratic, {3}, -inf, inf);
+  ExpectSameAsScipyNelderMead<2>(rosenbrock, {0, 0}, -inf, inf);
+  ExpectSameAsScipyNelderMead<5>(quadratic, {0.5, 0.5, 0.5, 0.5, 0.5}, -inf,
+                                 inf);
+  ExpectSameAsScipyNelderMead<8>(rosenbrock, {}, -inf, inf);
+  // The minimum of some dimensions lies outside of the bounds.
+  ExpectSameAsScipyNelderMead<5>(quadratic, {0.5, 0.5, 0.5, 0.5, 0.5}, -1,
+                                 2.5);
+  ExpectSameAsScipyNelderMead<12>(quadratic, {}, -inf, inf,
+                                  /*adaptive=*/true);
+  for (InitialSimplex initial_simplex :
+       {InitialSimplex::kStencil, InitialSimplex::kBisection}) {
+    ExpectSameAsScipyNelderMead<4>(rosenbrock, {}, -inf, inf,
+                                   /*adaptive=*/false, initial_simplex);
+    ExpectSameAsScipyNelderMead<4>(quadratic, {0.5, 0.5, 0.5, 0.5}, -1, 2.5,
+                                   /*adaptive=*/false, initial_simplex);
+  }
+}
+
+TEST(NelderMeadTest, UseOptimizerRepeatedly) {
+  NelderMead<3> optimizer;
+  optimizer.fatol = 1e-12;
+  optimizer.xatol = 1e-8;
+  optimizer.maxfun = 5000;
+  optimizer.maxiter = 5000;
+
+  auto function = ShiftedQuadratic<std::array<double, 3>>;
+  std::array<double, 3> x1 = optimizer.Minimize(function, {0, 0, 0});
+  size_t fcalls = optimizer.fcalls;
+  optimizer.Minimize(function, {5, 5, 5});
+  std::array<double, 3> x2 = optimizer.Minimize(function, {0, 0, 0});
+
+  EXPECT_EQ(x1, x2);
+  EXPECT_EQ(optimizer.fcalls, fcalls);
+}
+
+}  // namespace
+}  // namespace optimizer
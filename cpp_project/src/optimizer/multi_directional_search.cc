@@ -0,0 +1,202 @@
+#include "multi_directional_search.h"
+
+#include <absl/types/span.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "utils/logging.h"
+
+namespace optimizer {
+
+namespace {
+
+// Swaps the point with the lowest value into row 0 of the row-major matrix
+// `points`. Keeps the current best point on ties.
+void MoveBestFirst(size_t n_dims, std::vector<double>& points,
+                   std::vector<double>& values) {
+  const size_t best = std::min_element(values.begin(), values.end()) -
+                      values.begin();
+  if (best == 0 || !(values[best] < values[0])) {
+    return;
+  }
+  std::swap_ranges(&points[0], &points[n_dims], &points[best * n_dims]);
+  std::swap(values[0], values[best]);
+}
+
+// Writes best + factor * (x_i - best) for the points x_i in rows 1..n of
+// `simplex` to rows 0..n-1 of `trial`.
+void Step(size_t n_dims, const std::vector<double>& simplex, double factor,
+          double* trial) {
+  const double* best = &simplex[0];
+  for (size_t i = 1; i <= n_dims; ++i) {
+    const double* x = &simplex[i * n_dims];
+    double* t = &trial[(i - 1) * n_dims];
+    for (size_t j = 0; j < n_dims; ++j) {
+      t[j] = best[j] + factor * (x[j] - best[j]);
+    }
+  }
+}
+
+}  // namespace
+
+std::vector<double> MultiDirectionalSearch::Minimize(
+    const CallbackFunction& callback,
+    const std::vector<double>& initial_point) {
+  return Minimize(MakeBatchCallback(callback, num_threads), initial_point);
+}
+
+std::vector<double> MultiDirectionalSearch::Minimize(
+    const BatchCallbackFunction& callback,
+    const std::vector<double>& initial_point) {
+  SPDLOG_CHECK(!initial_point.empty(), "Initial point vector cannot be empty.");
+
+  iterations = 0;
+  fcalls = 0;
+  speculative_fcalls = 0;
+  fun = std::numeric_limits<double>::infinity();
+  success = false;
+  status = "Optimization has not started yet.";
+
+  const size_t n = initial_point.size();
+  std::vector<double> ranges(n, stencile[0]);
+  if (stencile.size() != 1) {
+    SPDLOG_CHECK(
+        stencile.size() == n,
+        fmt::format("stencile must have either size of 1 or the same size as "
+                    "initial_point: stencil.size()={}, initial_point.size()={}",
+                    stencile.size(), n));
+    ranges = stencile;
+  }
+
+  // Simplex of n + 1 points with the best point in row 0.
+  std::vector<double> simplex((n + 1) * n);
+  std::vector<double> values(n + 1);
+  for (size_t i = 0; i <= n; ++i) {
+    std::copy(initial_point.begin(), initial_point.end(), &simplex[i * n]);
+    if (i > 0) {
+      simplex[i * n + i - 1] += ranges[i - 1];
+    }
+  }
+  callback(simplex, absl::MakeSpan(values));
+  fcalls += n + 1;
+  MoveBestFirst(n, simplex, values);
+
+  // Rows 0..n-1 hold the reflected points and rows n..2n-1 the expanded or
+  // contracted points.
+  const bool parallel = num_threads > 1;
+  std::vector<double> trial(2 * n * n);
+  std::vector<double> trial_values(2 * n);
+  double* reflected = &trial[0];
+  double* second = &trial[n * n];
+  auto evaluate = [&](const double* points, size_t rows, double* out) {
+    callback(absl::MakeConstSpan(points, rows * n), absl::MakeSpan(out, rows));
+  };
+  // Replaces rows 1..n of the simplex by n trial points.
+  auto accept = [&](const double* points, const double* point_values) {
+    std::copy(points, points + n * n, &simplex[n]);
+    std::copy(point_values, point_values + n, &values[1]);
+    MoveBestFirst(n, simplex, values);
+  };
+
+  while (true) {
+    double max_dx = 0;
+    double max_df = 0;
+    for (size_t i = 1; i <= n; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        max_dx = std::max(max_dx, std::abs(simplex[i * n + j] - simplex[j]));
+      }
+      max_df = std::max(max_df, std::abs(values[i] - values[0]));
+    }
+    const bool meets_xatol = max_dx <= xatol;
+    const bool meets_fatol = max_df <= fatol;
+
+    if (fcalls > maxfun) {
+      status = fmt::format("Optimizer did NOT converge. fcalls({}) > "
+                           "maxfun({}), iterations: {}",
+                           fcalls, maxfun, iterations);
+      break;
+    }
+    if (iterations > maxiter) {
+      status = fmt::format("Optimizer did NOT converge. iterations({}) > "
+                           "maxiter({}), fcalls: {}",
+                           iterations, maxiter, fcalls);
+      break;
+    }
+    if (meets_xatol || meets_fatol) {
+      success = true;
+      status = fmt::format("Optimizer converged. fcalls: {}, iterations: {}, "
+                           "simplex_meets_xatol: {}, function_meets_fatol: {}",
+                           fcalls, iterations, meets_xatol, meets_fatol);
+      break;
+    }
+    if (values[0] <= ftarget) {
+      success = true;
+      status = fmt::format("Optimizer reached ftarget. f({}) <= ftarget({}), "
+                           "fcalls: {}, iterations: {}",
+                           values[0], ftarget, fcalls, iterations);
+      break;
+    }
+    if (stop_requested && stop_requested()) {
+      status = fmt::format("Optimizer was stopped on request. fcalls: {}, "
+                           "iterations: {}",
+                           fcalls, iterations);
+      break;
+    }
+
+    Step(n, simplex, -1, reflected);
+    if (parallel) {
+      Step(n, simplex, -expansion, second);
+      evaluate(reflected, 2 * n, &trial_values[0]);
+    } else {
+      evaluate(reflected, n, &trial_values[0]);
+    }
+    fcalls += n;
+    const double best_reflected =
+        *std::min_element(&trial_values[0], &trial_values[n]);
+
+    if (best_reflected < values[0]) {
+      if (!parallel) {
+        Step(n, simplex, -expansion, second);
+        evaluate(second, n, &trial_values[n]);
+      }
+      fcalls += n;
+      const double best_expanded =
+          *std::min_element(&trial_values[n], &trial_values[2 * n]);
+      if (best_expanded < best_reflected) {
+        accept(second, &trial_values[n]);
+      } else {
+        accept(reflected, &trial_values[0]);
+      }
+    } else {
+      if (parallel) {
+        speculative_fcalls += n;
+      }
+      Step(n, simplex, contraction, second);
+      evaluate(second, n, &trial_values[n]);
+      fcalls += n;
+      accept(second, &trial_values[n]);
+    }
+    iterations += 1;
+  }
+
+  fun = values[0];
+  return std::vector<double>(simplex.begin(), simplex.begin() + n);
+}
+
+OptimizerResult MultiDirectionalSearch::result() const {
+  OptimizerResult result;
+  result.fun = fun;
+  result.iterations = iterations;
+  result.fcalls = fcalls;
+  result.success = success;
+  result.status = status;
+  return result;
+}
+
+}  // namespace optimizer
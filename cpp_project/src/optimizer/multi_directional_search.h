@@ -0,0 +1,100 @@
+#ifndef MULTI_DIRECTIONAL_SEARCH_H
+#define MULTI_DIRECTIONAL_SEARCH_H
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "optimizer/optimizer.h"
+
+namespace optimizer {
+
+// Multi-directional search of Torczon, "On the convergence of the
+// multidirectional search algorithm" (1991). Like Nelder-Mead it moves a
+// simplex of n + 1 points, but every step moves all points except the best
+// one at once: they are reflected through the best point, then expanded or
+// contracted towards it. Each step is one batch of n independent points, so
+// the search uses up to n threads, where Nelder-Mead evaluates one point at a
+// time.
+class MultiDirectionalSearch : public Optimizer {
+ public:
+  MultiDirectionalSearch(const std::string& name = "Multi-directional search")
+      : name_(name) {};
+
+  std::vector<double> Minimize(
+      const CallbackFunction& callback,
+      const std::vector<double>& initial_point) override;
+
+  // Same as above, but the initial simplex and every step are sent to the
+  // callback as one batch.
+  std::vector<double> Minimize(
+      const BatchCallbackFunction& callback,
+      const std::vector<double>& initial_point) override;
+
+  std::string name() override { return name_; };
+
+  OptimizerResult result() const override;
+
+  // tolerance for movement in the input search space for detecting convergence.
+  double xatol = 1e-4;
+
+  // tolerance for movement in the output space for detecting convergence.
+  double fatol = 1e-4;
+
+  // Stencil value used for making the initial simplex. Either one value for
+  // all dimensions or one per dimension.
+  std::vector<double> stencile{0.05};
+
+  // Expansion and contraction factors of the simplex.
+  double expansion = 2;
+  double contraction = 0.5;
+
+  // Maximum number of function calls.
+  size_t maxfun = 1000;
+
+  // Maximum number of iterations.
+  size_t maxiter = 500;
+
+  // The optimization stops successfully once the best function value is at or
+  // below ftarget.
+  double ftarget = -std::numeric_limits<double>::infinity();
+
+  // If set, called once per iteration. The optimization stops without success
+  // once it returns true.
+  std::function<bool()> stop_requested;
+
+  // Number of threads used to evaluate the points of a step concurrently.
+  // Larger values than 1 require a thread-safe callback. With more than one
+  // thread, the reflected and the expanded points are evaluated as one batch
+  // of 2 n points, so an expansion does not wait for the reflection. For a
+  // deterministic callback the result does not depend on this value.
+  size_t num_threads = 1;
+
+  // Number of iterations.
+  size_t iterations = 0;
+
+  // Number of function calls whose values were used by the search.
+  size_t fcalls = 0;
+
+  // Number of function calls made speculatively in parallel mode whose values
+  // were not needed by the search. These are not counted in fcalls.
+  size_t speculative_fcalls = 0;
+
+  // Function value at the point returned by Minimize.
+  double fun = std::numeric_limits<double>::infinity();
+
+  // Specifies if the optimization has succeeded.
+  bool success = false;
+
+  // Get information about the convergence status of the optimizer.
+  std::string status;
+
+ private:
+  std::string name_;
+};
+
+}  // namespace optimizer
+
+#endif  // MULTI_DIRECTIONAL_SEARCH_H
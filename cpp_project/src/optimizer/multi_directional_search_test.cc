@@ -0,0 +1,71 @@
+#include "multi_directional_search.h"
+
+#include <absl/types/span.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "testing/test_functions.h"
+
+namespace optimizer {
+namespace {
+
+double Quadratic(const std::vector<double>& x) {
+  return testing::ShiftedQuadratic(x);
+}
+
+// Every step after the initial simplex evaluates all n non-best points of the
+// simplex as one batch.
+TEST(MultiDirectionalSearchTest, EvaluatesWholeStepsAsBatches) {
+  MultiDirectionalSearch optimizer;
+  optimizer.maxfun = 5000;
+  std::vector<size_t> batch_sizes;
+  MultiDirectionalSearch::BatchCallbackFunction callback =
+      [&](absl::Span<const double> points, absl::Span<double> values) {
+        batch_sizes.push_back(values.size());
+        const size_t n_dims = points.size() / values.size();
+        for (size_t i = 0; i < values.size(); ++i) {
+          values[i] = Quadratic(std::vector<double>(
+              points.begin() + i * n_dims, points.begin() + (i + 1) * n_dims));
+        }
+      };
+  optimizer.Minimize(callback, std::vector<double>(5, 0.5));
+
+  EXPECT_TRUE(optimizer.success) << optimizer.status;
+  ASSERT_GT(batch_sizes.size(), 1);
+  EXPECT_EQ(batch_sizes[0], 6);
+  for (size_t i = 1; i < batch_sizes.size(); ++i) {
+    EXPECT_EQ(batch_sizes[i], 5);
+  }
+}
+
+// In parallel mode the expansion is evaluated together with the reflection.
+// Its values are only counted in fcalls when the step needed them.
+TEST(MultiDirectionalSearchTest, ParallelModeCountsSpeculativeCalls) {
+  MultiDirectionalSearch optimizer;
+  optimizer.maxfun = 5000;
+  std::vector<double> initial_point(4, 0.5);
+  std::vector<double> x = optimizer.Minimize(Quadratic, initial_point);
+  const size_t fcalls = optimizer.fcalls;
+  EXPECT_EQ(optimizer.speculative_fcalls, 0);
+
+  optimizer.num_threads = 4;
+  EXPECT_EQ(optimizer.Minimize(Quadratic, initial_point), x);
+  EXPECT_EQ(optimizer.fcalls, fcalls);
+  EXPECT_GT(optimizer.speculative_fcalls, 0);
+  EXPECT_EQ(optimizer.speculative_fcalls % initial_point.size(), 0);
+}
+
+TEST(MultiDirectionalSearchTest, StopsAtFtarget) {
+  MultiDirectionalSearch optimizer;
+  optimizer.maxfun = 5000;
+  optimizer.ftarget = 0.5;
+  optimizer.Minimize(Quadratic, {0, 0, 0});
+  EXPECT_TRUE(optimizer.success);
+  EXPECT_LE(optimizer.fun, 0.5);
+  EXPECT_GT(optimizer.fun, 1e-3);
+}
+
+}  // namespace
+}  // namespace optimizer
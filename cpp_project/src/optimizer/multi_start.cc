@@ -0,0 +1,72 @@
+#include "multi_start.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "utils/thread_pool.h"
+
+namespace optimizer {
+
+MultiStartNelderMead::MultiStartNelderMead(const ScipyNelderMead& options,
+                                           size_t num_threads)
+    : options(options),
+      thread_pool_(std::make_shared<utils::ThreadPool>(num_threads)) {}
+
+MultiStartNelderMead::~MultiStartNelderMead() = default;
+
+MultiStartResult MultiStartNelderMead::Minimize(
+    const ScipyNelderMead::CallbackFunction& callback,
+    const std::vector<std::vector<double>>& initial_points) {
+  MultiStartResult result;
+  result.runs.resize(initial_points.size());
+
+  std::atomic<bool> target_reached{false};
+
+  // Runs are claimed one at a time by idle threads, so long runs do not hold
+  // up the remaining ones.
+  thread_pool_->ParallelFor(initial_points.size(), [&](size_t i) {
+    NelderMeadResult& run = result.runs[i];
+    if (target_reached.load()) {
+      run.status = "Skipped because target_value was reached by another run.";
+      return;
+    }
+
+    ScipyNelderMead optimizer = options;
+    optimizer.num_threads = 1;
+    // A sink is not thread-safe, and every run would write the same file.
+    optimizer.trace_sink = nullptr;
+    optimizer.checkpoint_path.clear();
+    optimizer.ftarget = target_value;
+    optimizer.stop_requested = [&target_reached]() {
+      return target_reached.load();
+    };
+
+    std::vector<double> x = optimizer.Minimize(callback, initial_points[i]);
+    run = optimizer.result();
+    run.x = std::move(x);
+
+    if (run.fun <= target_value) {
+      target_reached.store(true);
+    }
+  });
+
+  for (size_t i = 0; i < result.runs.size(); ++i) {
+    const NelderMeadResult& run = result.runs[i];
+    result.total_fcalls += run.fcalls;
+    result.n_success += run.success ? 1 : 0;
+    if (run.fun < result.runs[result.best_index].fun) {
+      result.best_index = i;
+    }
+  }
+  if (!result.runs.empty()) {
+    result.best = result.runs[result.best_index];
+  }
+  result.target_reached = target_reached.load();
+
+  return result;
+}
+
+}  // namespace optimizer
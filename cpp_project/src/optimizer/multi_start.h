@@ -0,0 +1,75 @@
+#ifndef MULTI_START_H
+#define MULTI_START_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "optimizer/nelder_mead.h"
+
+namespace utils {
+class ThreadPool;
+}  // namespace utils
+
+namespace optimizer {
+
+// Outcome of MultiStartNelderMead::Minimize.
+struct MultiStartResult {
+  // Result of the run with the lowest function value.
+  NelderMeadResult best;
+
+  // Index of the best run in `runs`.
+  size_t best_index = 0;
+
+  // Result of every run, in the order of the initial points. Runs that were
+  // skipped after the target value was reached have no point and zero fcalls.
+  std::vector<NelderMeadResult> runs;
+
+  // Sum of fcalls over all runs.
+  size_t total_fcalls = 0;
+
+  // Number of runs that succeeded.
+  size_t n_success = 0;
+
+  // True if a run reached target_value.
+  bool target_reached = false;
+};
+
+// Runs ScipyNelderMead from many initial points concurrently and keeps the
+// best result. Every run works on its own copy of `options`, so runs do not
+// share any mutable state. For the same reason the runs are neither traced nor
+// checkpointed: options.trace_sink and options.checkpoint_path are ignored.
+class MultiStartNelderMead {
+ public:
+  // Runs use up to `num_threads` threads. If `num_threads` is 0, the number of
+  // hardware threads is used.
+  explicit MultiStartNelderMead(
+      const ScipyNelderMead& options = ScipyNelderMead(),
+      size_t num_threads = 0);
+  ~MultiStartNelderMead();
+
+  // The callback is called from several threads at once and must be
+  // thread-safe.
+  MultiStartResult Minimize(
+      const ScipyNelderMead::CallbackFunction& callback,
+      const std::vector<std::vector<double>>& initial_points);
+
+  // Optimizer settings used by every run. options.num_threads is ignored:
+  // the runs already keep the threads busy, so every run evaluates its points
+  // on the thread that runs it, and at most `num_threads` threads are used.
+  ScipyNelderMead options;
+
+  // Once a run reaches a function value at or below target_value, runs that
+  // have not started yet are skipped and running ones stop at their next
+  // iteration.
+  double target_value = -std::numeric_limits<double>::infinity();
+
+ private:
+  std::shared_ptr<utils::ThreadPool> thread_pool_;
+};
+
+}  // namespace optimizer
+
+#endif  // MULTI_START_H
@@ -0,0 +1,141 @@
+#include "multi_start.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "optimizer/nelder_mead.h"
+#include "optimizer/trace.h"
+
+namespace optimizer {
+namespace {
+
+// Tilted double well with a local minimum near x = 1 and the global minimum
+// near x = -1 in every dimension.
+double DoubleWell(const std::vector<double>& x) {
+  double value = 0;
+  for (double xi : x) {
+    value += std::pow(xi * xi - 1, 2) + 0.3 * xi;
+  }
+  return value;
+}
+
+ScipyNelderMead MakeOptions() {
+  ScipyNelderMead options;
+  options.fatol = 1e-10;
+  options.xatol = 1e-8;
+  options.maxfun = 2000;
+  options.maxiter = 2000;
+  return options;
+}
+
+std::vector<std::vector<double>> MakeInitialPoints() {
+  return {{1.2, 1.2}, {0.8, -0.5}, {-1.5, 1.5}, {-0.7, -1.3}, {2, 2}};
+}
+
+TEST(MultiStartNelderMeadTest, FindsGlobalMinimum) {
+  MultiStartNelderMead multi_start(MakeOptions(), 4);
+
+  MultiStartResult result =
+      multi_start.Minimize(DoubleWell, MakeInitialPoints());
+
+  ASSERT_EQ(result.runs.size(), 5);
+  EXPECT_EQ(result.best_index, 3);
+  EXPECT_THAT(result.best.x, testing::Each(testing::Lt(-0.9)));
+  size_t total_fcalls = 0;
+  for (const NelderMeadResult& run : result.runs) {
+    EXPECT_GE(run.fun, result.best.fun);
+    total_fcalls += run.fcalls;
+  }
+  EXPECT_EQ(result.total_fcalls, total_fcalls);
+  EXPECT_EQ(result.n_success, 5);
+  EXPECT_FALSE(result.target_reached);
+}
+
+// Each run must give the same result as a standalone optimizer.
+TEST(MultiStartNelderMeadTest, RunsMatchSingleOptimizations) {
+  MultiStartNelderMead multi_start(MakeOptions(), 4);
+  std::vector<std::vector<double>> initial_points = MakeInitialPoints();
+
+  MultiStartResult result = multi_start.Minimize(DoubleWell, initial_points);
+
+  for (size_t i = 0; i < initial_points.size(); ++i) {
+    ScipyNelderMead optimizer = MakeOptions();
+    std::vector<double> x = optimizer.Minimize(DoubleWell, initial_points[i]);
+    EXPECT_EQ(result.runs[i].x, x);
+    EXPECT_EQ(result.runs[i].fun, optimizer.fun);
+    EXPECT_EQ(result.runs[i].fcalls, optimizer.fcalls);
+    EXPECT_EQ(result.runs[i].iterations, optimizer.iterations);
+  }
+}
+
+TEST(MultiStartNelderMeadTest, RunsDoNotStartMoreThreads) {
+  ScipyNelderMead options = MakeOptions();
+  options.num_threads = 4;
+  MultiStartNelderMead multi_start(options, 2);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  auto recording = [&](const std::vector<double>& x) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    }
+    // Gives idle threads time to take part in the batch of this point.
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    return DoubleWell(x);
+  };
+
+  MultiStartResult result =
+      multi_start.Minimize(recording, MakeInitialPoints());
+
+  EXPECT_EQ(result.best_index, 3);
+  EXPECT_LE(threads.size(), 2);
+}
+
+TEST(MultiStartNelderMeadTest, RunsAreNotTracedOrCheckpointed) {
+  RingBufferTraceSink sink(100);
+  const std::string path = testing::TempDir() + "/multi_start_checkpoint.bin";
+  std::remove(path.c_str());
+  ScipyNelderMead options = MakeOptions();
+  options.trace_sink = &sink;
+  options.checkpoint_path = path;
+  options.checkpoint_interval = 1;
+  MultiStartNelderMead multi_start(options, 4);
+
+  MultiStartResult result =
+      multi_start.Minimize(DoubleWell, MakeInitialPoints());
+
+  EXPECT_EQ(result.best_index, 3);
+  EXPECT_EQ(sink.size(), 0);
+  EXPECT_FALSE(std::ifstream(path).is_open());
+}
+
+TEST(MultiStartNelderMeadTest, StopsOnceTargetIsReached) {
+  // A single thread runs the starts in order, so every run after the first
+  // one that reaches the target is skipped.
+  MultiStartNelderMead multi_start(MakeOptions(), 1);
+  multi_start.target_value = -0.5;
+
+  MultiStartResult result =
+      multi_start.Minimize(DoubleWell, MakeInitialPoints());
+
+  EXPECT_TRUE(result.target_reached);
+  EXPECT_EQ(result.best_index, 3);
+  EXPECT_LE(result.best.fun, -0.5);
+  EXPECT_THAT(result.best.status, testing::HasSubstr("reached ftarget"));
+  EXPECT_EQ(result.runs[4].fcalls, 0);
+  EXPECT_TRUE(result.runs[4].x.empty());
+  EXPECT_THAT(result.runs[4].status, testing::HasSubstr("Skipped"));
+}
+
+}  // namespace
+}  // namespace optimizer
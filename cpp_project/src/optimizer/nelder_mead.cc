@@ -1,291 +1,858 @@
 #include "nelder_mead.h"
 
+#include <absl/types/span.h>
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 #include <spdlog/common.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "optimizer/checkpoint.h"
+#include "optimizer/evaluation_cache.h"
+#include "utils/blas.h"
 #include "utils/logging.h"
-#include "utils/math.h"
 
 namespace optimizer {
 
 using namespace utils;
 
-// Function to reorder a vector based on the given indices
-template <typename T>
-std::vector<T> take(const std::vector<T>& vec,
-                    const std::vector<size_t>& indices) {
-  std::vector<T> result(indices.size());
-  for (size_t i = 0; i < indices.size(); ++i) {
-    result[i] = vec[indices[i]];
+namespace {
+
+// Indices of the candidate points tried in a single iteration.
+enum Candidate : size_t {
+  kReflect = 0,
+  kExpand,
+  kContract,
+  kInsideContract,
+  kNumCandidates,
+};
+
+static_assert(static_cast<size_t>(StepType::kReflect) == kReflect &&
+                  static_cast<size_t>(StepType::kExpand) == kExpand &&
+                  static_cast<size_t>(StepType::kContract) == kContract &&
+                  static_cast<size_t>(StepType::kInsideContract) ==
+                      kInsideContract,
+              "Candidates and steps must be listed in the same order.");
+
+// Number of steps of each line search of InitialSimplex::kLineSearch and
+// InitialSimplex::kBisection.
+constexpr int kLineSearchSteps = 20;
+constexpr int kBisectionSteps = 6;
+
+// Header of the checkpoints written by NelderMeadStepper. The version changes
+// whenever the layout of the checkpoint does.
+constexpr char kCheckpointMagic[9] = "NMSTEPPR";
+constexpr uint32_t kCheckpointVersion = 2;
+
+// Returns the per-dimension bounds of `options` for `n_dims` dimensions.
+Bounds MakeBounds(const ScipyNelderMead& options, size_t n_dims) {
+  std::vector<double> lower(n_dims, options.lower_bound);
+  std::vector<double> upper(n_dims, options.upper_bound);
+  if (!options.lower_bounds.empty()) {
+    SPDLOG_CHECK(options.lower_bounds.size() == n_dims,
+                 fmt::format("lower_bounds must be empty or have the same "
+                             "size as initial_point: lower_bounds.size()={}, "
+                             "initial_point.size()={}",
+                             options.lower_bounds.size(), n_dims));
+    lower = options.lower_bounds;
   }
-  return result;
+  if (!options.upper_bounds.empty()) {
+    SPDLOG_CHECK(options.upper_bounds.size() == n_dims,
+                 fmt::format("upper_bounds must be empty or have the same "
+                             "size as initial_point: upper_bounds.size()={}, "
+                             "initial_point.size()={}",
+                             options.upper_bounds.size(), n_dims));
+    upper = options.upper_bounds;
+  }
+  return Bounds(std::move(lower), std::move(upper), options.bound_handling);
 }
 
+// Evaluates the points stored as the rows of `points` as a single batch.
+void EvaluateBatch(const ScipyNelderMead::BatchCallbackFunction& callback,
+                   absl::Span<const double> points, absl::Span<double> values) {
+  if (!values.empty()) {
+    callback(points, values);
+  }
+}
+
+}  // namespace
+
 std::vector<double> ScipyNelderMead::Minimize(
     const CallbackFunction& callback,
     const std::vector<double>& initial_point) {
+  return Minimize(MakeBatchCallback(callback, num_threads), initial_point);
+}
+
+std::vector<double> ScipyNelderMead::Minimize(
+    const BatchCallbackFunction& objective,
+    const std::vector<double>& initial_point) {
   SPDLOG_CHECK(!initial_point.empty(), "Initial point vector cannot be empty.");
 
   SPDLOG_TRACE("------------ initial_point: {}", initial_point);
 
+  NelderMeadStepper stepper(*this, initial_point);
+  return Run(objective, stepper);
+}
+
+std::vector<double> ScipyNelderMead::Resume(const CallbackFunction& callback,
+                                            const std::string& path) {
+  return Resume(MakeBatchCallback(callback, num_threads), path);
+}
+
+std::vector<double> ScipyNelderMead::Resume(
+    const BatchCallbackFunction& objective, const std::string& path) {
+  const std::string checkpoint = ReadCheckpointFile(path);
+  NelderMeadStepper stepper =
+      NelderMeadStepper::FromCheckpoint(*this, checkpoint);
+  return Run(objective, stepper);
+}
+
+std::vector<double> ScipyNelderMead::Run(const BatchCallbackFunction& objective,
+                                         NelderMeadStepper& stepper) {
   iterations = 0;
   fcalls = 0;
+  fun = std::numeric_limits<double>::infinity();
+  speculative_fcalls = 0;
+  cache_hits = 0;
+  cache_misses = 0;
+  restarts = 0;
   success = false;
   status = "Optimization has not started yet.";
 
-  auto wrapped_callback = [this, &callback](const std::vector<double>& x) {
-    fcalls += 1;
-    return callback(x);
+  // Only the points of a batch that are not in the cache are passed on to the
+  // objective.
+  EvaluationCache cache(cache_size, cache_quantum);
+  std::vector<double> miss_points;
+  std::vector<double> miss_values;
+  std::vector<size_t> miss_indices;
+  BatchCallbackFunction cached_objective = [&](absl::Span<const double> points,
+                                               absl::Span<double> values) {
+    const size_t n_dims = points.size() / values.size();
+    miss_points.clear();
+    miss_indices.clear();
+    for (size_t i = 0; i < values.size(); ++i) {
+      absl::Span<const double> point = points.subspan(i * n_dims, n_dims);
+      if (cache.Lookup(point, values[i])) {
+        cache_hits += 1;
+      } else {
+        miss_points.insert(miss_points.end(), point.begin(), point.end());
+        miss_indices.push_back(i);
+      }
+    }
+    if (miss_indices.empty()) {
+      return;
+    }
+
+    miss_values.resize(miss_indices.size());
+    objective(miss_points, absl::MakeSpan(miss_values));
+    cache_misses += miss_indices.size();
+    for (size_t k = 0; k < miss_indices.size(); ++k) {
+      values[miss_indices[k]] = miss_values[k];
+      cache.Insert(points.subspan(miss_indices[k] * n_dims, n_dims),
+                   miss_values[k]);
+    }
   };
+  const BatchCallbackFunction& callback =
+      cache_size > 0 ? cached_objective : objective;
+
+  const bool write_checkpoints =
+      checkpoint_interval > 0 && !checkpoint_path.empty();
+  size_t n_checkpoints = stepper.n_checkpoints();
+  std::vector<double> values;
+  while (!stepper.done()) {
+    values.resize(stepper.n_asked());
+    EvaluateBatch(callback, stepper.Ask(), absl::MakeSpan(values));
+    stepper.Tell(values);
+    if (write_checkpoints && stepper.n_checkpoints() != n_checkpoints) {
+      n_checkpoints = stepper.n_checkpoints();
+      WriteCheckpointFile(checkpoint_path, stepper.checkpoint());
+    }
+  }
 
-  // Holds simplex points.
-  // std::vector<std::vector<double>> simplex = make_simplex(initial_point);
-  std::vector<std::vector<double>> simplex =
-      make_simplex2(callback, initial_point);
+  speculative_fcalls = stepper.speculative_fcalls();
+  NelderMeadResult result = std::move(stepper).result();
+  iterations = result.iterations;
+  fcalls = result.fcalls;
+  restarts = result.restarts;
+  fun = result.fun;
+  success = result.success;
+  status = std::move(result.status);
+  if (cache_size > 0) {
+    status += fmt::format(", cache_hits: {}, cache_misses: {}", cache_hits,
+                          cache_misses);
+  }
 
-  // Number of the simplex points.
-  size_t n_simplex = simplex.size();
+  return result.x;
+};
 
-  std::vector<double> f_simplex(simplex.size(), 0);
-  std::transform(simplex.begin(), simplex.end(), f_simplex.begin(),
-                 wrapped_callback);
+NelderMeadResult ScipyNelderMead::result() const {
+  NelderMeadResult result;
+  result.fun = fun;
+  result.iterations = iterations;
+  result.fcalls = fcalls;
+  result.restarts = restarts;
+  result.success = success;
+  result.status = status;
+  return result;
+}
 
-  // sort simplex so that the first point has the lowest function value.
-  std::vector<size_t> idx = argsort(f_simplex);
-  simplex = take(simplex, idx);
-  f_simplex = take(f_simplex, idx);
-
-  while (true) {
-    if (fcalls > maxfun) {
-      success = false;
-      status = fmt::format(
-          "Optimizer did NOT converged. fcalls({}) > maxfun({}), "
-          "iterations: {}, "
-          "simplex_meets_xatol: {}, function_meets_fatol: {}",
-          fcalls, maxfun, iterations,
-          SimplexMeetsAbsoluteTolerance(simplex, xatol),
-          FunctionMeetsAbsoluteTolerance(f_simplex, fatol));
+NelderMeadStepper::NelderMeadStepper(size_t n_dims,
+                                     const ScipyNelderMead& options)
+    : options_(options),
+      initial_point_(n_dims, 0.0),
+      told_(n_dims + 1),
+      simplex_(initial_point_),
+      xbar_(n_dims),
+      candidates_(kNumCandidates * n_dims),
+      f_candidates_(kNumCandidates),
+      known_(kNumCandidates),
+      used_(kNumCandidates) {
+  SPDLOG_CHECK(n_dims > 0, "Initial point vector cannot be empty.");
+
+  result_.status = "Optimization has not started yet.";
+  if (options_.trace_sink) {
+    start_time_ = std::chrono::steady_clock::now();
+  }
+}
+
+NelderMeadStepper::NelderMeadStepper(const ScipyNelderMead& options,
+                                     const std::vector<double>& initial_point)
+    : NelderMeadStepper(initial_point.size(), options) {
+  bounds_ = MakeBounds(options_, n_dims());
+  initial_point_ = initial_point;
+  if (bounds_.transforms()) {
+    bounds_.FromBounded(initial_point, absl::MakeSpan(initial_point_));
+  } else {
+    bounds_.Enforce(absl::MakeSpan(initial_point_));
+  }
+  simplex_ = Simplex(initial_point_);
+  if (options_.adaptive) {
+    const double n = static_cast<double>(n_dims());
+    options_.rho = 1;
+    options_.chi = 1 + 2 / n;
+    options_.psi = 0.75 - 1 / (2 * n);
+    options_.sigma = 1 - 1 / n;
+  }
+
+  ranges_.assign(n_dims(), options_.stencile[0]);
+  if (options_.stencile.size() != 1) {
+    SPDLOG_CHECK(
+        options_.stencile.size() == initial_point.size(),
+        fmt::format("stencile must have either size of 1 or the same size as "
+                    "initial_point: stencil.size()={}, initial_point.size()={}",
+                    options_.stencile.size(), initial_point.size()));
+    ranges_ = options_.stencile;
+  }
+
+  switch (options_.initial_simplex) {
+    case InitialSimplex::kStencil:
+      make_simplex(simplex_);
+      Request(Phase::kInitialSimplex, simplex_.points().data(),
+              simplex_.size(), simplex_.values().data());
+      break;
+    case InitialSimplex::kLineSearch:
+    case InitialSimplex::kBisection:
+      line_search_steps_ =
+          options_.initial_simplex == InitialSimplex::kLineSearch
+              ? kLineSearchSteps
+              : kBisectionSteps;
+      first_step_x_.resize(n_dims());
+      first_step_f_.resize(n_dims());
+      Request(Phase::kInitialPoint, initial_point_.data(), 1,
+              &simplex_.value(0));
       break;
+  }
+}
+
+NelderMeadStepper NelderMeadStepper::FromCheckpoint(
+    const ScipyNelderMead& options, absl::Span<const char> checkpoint) {
+  CheckpointReader reader(checkpoint, kCheckpointMagic, kCheckpointVersion);
+  NelderMeadStepper stepper(reader.ReadSize(), options);
+  ScipyNelderMead& restored = stepper.options_;
+  restored.adaptive = false;
+  restored.rho = reader.ReadDouble();
+  restored.chi = reader.ReadDouble();
+  restored.psi = reader.ReadDouble();
+  restored.sigma = reader.ReadDouble();
+  restored.lower_bounds.resize(stepper.n_dims());
+  restored.upper_bounds.resize(stepper.n_dims());
+  reader.ReadDoubles(absl::MakeSpan(restored.lower_bounds));
+  reader.ReadDoubles(absl::MakeSpan(restored.upper_bounds));
+  const size_t bound_handling = reader.ReadSize();
+  SPDLOG_CHECK(
+      bound_handling <= static_cast<size_t>(BoundHandling::kTransform),
+      fmt::format("Invalid bound handling {}.", bound_handling));
+  restored.bound_handling = static_cast<BoundHandling>(bound_handling);
+  stepper.bounds_ = MakeBounds(restored, stepper.n_dims());
+  restored.stagnation_iterations = reader.ReadSize();
+  restored.stagnation_rtol = reader.ReadDouble();
+  restored.min_flatness = reader.ReadDouble();
+  restored.centroid_resync_interval = reader.ReadSize();
+  stepper.ranges_.resize(stepper.n_dims());
+  reader.ReadDoubles(absl::MakeSpan(stepper.ranges_));
+  restored.stencile = stepper.ranges_;
+
+  stepper.result_.iterations = reader.ReadSize();
+  stepper.result_.fcalls = reader.ReadSize();
+  stepper.result_.restarts = reader.ReadSize();
+  stepper.speculative_fcalls_ = reader.ReadSize();
+  stepper.last_check_iteration_ = reader.ReadSize();
+  stepper.last_check_fun_ = reader.ReadDouble();
+  stepper.simplex_.Load(reader);
+  reader.Finish();
+
+  // The checkpoint was taken at the start of this iteration.
+  stepper.checkpoint_iteration_ = stepper.result_.iterations;
+  stepper.StartIteration();
+  return stepper;
+}
+
+void NelderMeadStepper::SaveCheckpoint() {
+  CheckpointWriter writer(checkpoint_, kCheckpointMagic, kCheckpointVersion);
+  writer.WriteSize(n_dims());
+  writer.WriteDouble(options_.rho);
+  writer.WriteDouble(options_.chi);
+  writer.WriteDouble(options_.psi);
+  writer.WriteDouble(options_.sigma);
+  writer.WriteDoubles(bounds_.lower());
+  writer.WriteDoubles(bounds_.upper());
+  writer.WriteSize(static_cast<size_t>(bounds_.handling()));
+  writer.WriteSize(options_.stagnation_iterations);
+  writer.WriteDouble(options_.stagnation_rtol);
+  writer.WriteDouble(options_.min_flatness);
+  writer.WriteSize(options_.centroid_resync_interval);
+  writer.WriteDoubles(ranges_);
+
+  writer.WriteSize(result_.iterations);
+  writer.WriteSize(result_.fcalls);
+  writer.WriteSize(result_.restarts);
+  writer.WriteSize(speculative_fcalls_);
+  writer.WriteSize(last_check_iteration_);
+  writer.WriteDouble(last_check_fun_);
+  simplex_.Save(writer);
+
+  checkpoint_iteration_ = result_.iterations;
+  n_checkpoints_ += 1;
+}
+
+void NelderMeadStepper::Tell(absl::Span<const double> values) {
+  SPDLOG_CHECK(values.size() == n_asked_,
+               fmt::format("Expected {} values but got {}.", n_asked_,
+                           values.size()));
+  std::copy(values.begin(), values.end(), ask_values_);
+  n_told_ = n_asked_;
+  Advance();
+}
+
+void NelderMeadStepper::Tell(size_t i, double value) {
+  SPDLOG_CHECK(i < n_asked_, fmt::format("Point {} was not asked for. "
+                                         "n_asked: {}",
+                                         i, n_asked_));
+  ask_values_[i] = value;
+  if (!told_[i]) {
+    told_[i] = 1;
+    n_told_ += 1;
+  }
+  if (n_told_ == n_asked_) {
+    Advance();
+  }
+}
+
+void NelderMeadStepper::Request(Phase phase, const double* points, size_t n,
+                                double* values) {
+  phase_ = phase;
+  request_points_ = points;
+  ask_points_ = points;
+  if (bounds_.transforms() && n > 0) {
+    const size_t size = n * n_dims();
+    if (bounded_points_.size() < size) {
+      // Large enough for every request, so this allocates only once.
+      bounded_points_.resize(std::max<size_t>(n_dims() + 1, kNumCandidates) *
+                             n_dims());
     }
+    bounds_.ToBounded(absl::MakeConstSpan(points, size),
+                      absl::MakeSpan(bounded_points_.data(), size));
+    ask_points_ = bounded_points_.data();
+  }
+  n_asked_ = n;
+  ask_values_ = values;
+  n_told_ = 0;
+  std::fill(told_.begin(), told_.begin() + n, 0);
+}
 
-    if (iterations > maxiter) {
-      success = false;
-      status = fmt::format(
-          "Optimizer did NOT converged. iterations({}) > maxiter({}), "
-          "fcalls: {}, "
-          "simplex_meets_xatol: {}, function_meets_fatol: {}",
-          iterations, maxiter, fcalls,
-          SimplexMeetsAbsoluteTolerance(simplex, xatol),
-          FunctionMeetsAbsoluteTolerance(f_simplex, fatol));
+void NelderMeadStepper::Advance() {
+  switch (phase_) {
+    case Phase::kInitialPoint: {
+      // Point i + 1 of the simplex is found by a line search along dimension
+      // i that walks from the full range towards the initial point and stops
+      // at the first point better than the initial point. The line searches
+      // of all dimensions advance in lockstep so each step is evaluated as one
+      // batch.
+      result_.fcalls += 1;
+      f0_ = simplex_.value(0);
+      active_.resize(n_dims());
+      std::iota(active_.begin(), active_.end(), 0);
+      line_search_step_ = 0;
+      ContinueLineSearch();
       break;
     }
-
-    if (SimplexMeetsAbsoluteTolerance(simplex, xatol) ||
-        FunctionMeetsAbsoluteTolerance(f_simplex, fatol)) {
-      success = true;
-      status = fmt::format(
-          "Optimizer converged. fcalls: {}, iterations: {}, "
-          "simplex_meets_xatol: {}, function_meets_fatol: {}",
-          fcalls, iterations, SimplexMeetsAbsoluteTolerance(simplex, xatol),
-          FunctionMeetsAbsoluteTolerance(f_simplex, fatol));
+    case Phase::kLineSearch: {
+      result_.fcalls += n_asked_;
+      size_t n_active = 0;
+      for (size_t k = 0; k < active_.size(); ++k) {
+        const size_t i = active_[k];
+        const double f = line_search_values_[k];
+        if (line_search_step_ == 0) {
+          first_step_x_[i] = simplex_.point(i + 1)[i];
+          first_step_f_[i] = f;
+        }
+        if (f < f0_) {
+          simplex_.value(i + 1) = f;
+        } else {
+          active_[n_active++] = i;
+        }
+      }
+      active_.resize(n_active);
+      line_search_step_ += 1;
+      ContinueLineSearch();
       break;
     }
-
-    std::vector<double> xbar = GetXbar(simplex);
-    std::vector<double> xr = (1 + rho) * xbar - rho * simplex.back();
-    EnforceBounds(lower_bound, upper_bound, xr);
-    double f_xr = wrapped_callback(xr);
-
-    bool do_shrink = false;
-
-    if (f_xr < f_simplex[0]) {
-      std::vector<double> xe =
-          (1 + rho * chi) * xbar - rho * chi * simplex.back();
-      EnforceBounds(lower_bound, upper_bound, xe);
-      double f_xe = wrapped_callback(xe);
-      if (f_xe < f_xr) {
-        simplex.back() = xe;
-        f_simplex.back() = f_xe;
-      } else {
-        simplex.back() = xr;
-        f_simplex.back() = f_xr;
+    case Phase::kLineSearchFallback: {
+      result_.fcalls += n_asked_;
+      for (size_t k = 0; k < active_.size(); ++k) {
+        simplex_.value(active_[k] + 1) = line_search_values_[k];
       }
-    } else {
-      // f_simplex[0] <= f_xr
-      if (f_xr < f_simplex[n_simplex - 2]) {
-        simplex.back() = xr;
-        f_simplex.back() = f_xr;
+      FinishInitialSimplex();
+      break;
+    }
+    case Phase::kInitialSimplex: {
+      result_.fcalls += n_asked_;
+      FinishInitialSimplex();
+      break;
+    }
+    case Phase::kCandidates: {
+      if (n_asked_ == kNumCandidates) {
+        std::fill(known_.begin(), known_.end(), 1);
       } else {
-        // f_xr <= f_simplex[-2]
-        // Perform contraction
-        if (f_xr < f_simplex.back()) {
-          std::vector<double> xc =
-              (1 + psi * rho) * xbar - psi * rho * simplex.back();
-          EnforceBounds(lower_bound, upper_bound, xc);
-          double f_xc = wrapped_callback(xc);
-          if (f_xc <= f_xr) {
-            simplex.back() = xc;
-            f_simplex.back() = f_xc;
-          } else {
-            do_shrink = true;
-          }
-        } else {
-          // Perform an inside contraction
-          std::vector<double> xcc = (1 - psi) * xbar + psi * simplex.back();
-          EnforceBounds(lower_bound, upper_bound, xcc);
-          double f_xcc = wrapped_callback(xcc);
-
-          if (f_xcc < f_simplex.back()) {
-            simplex.back() = xcc;
-            f_simplex.back() = f_xcc;
-          } else {
-            do_shrink = true;
-          }
-        }
-
-        if (do_shrink) {
-          for (size_t j = 1; j < simplex.size(); j++) {
-            simplex[j] = simplex[0] + sigma * (simplex[j] - simplex[0]);
-            EnforceBounds(lower_bound, upper_bound, simplex[j]);
-            f_simplex[j] = wrapped_callback(simplex[j]);
-          }
-        }
+        known_[(request_points_ - candidates_.data()) / n_dims()] = 1;
       }
+      ContinueIteration();
+      break;
+    }
+    case Phase::kShrink: {
+      result_.fcalls += simplex_.size() - 1;
+      simplex_.RecomputeSum();
+      FinishIteration();
+      break;
+    }
+    case Phase::kRestart: {
+      result_.fcalls += simplex_.size() - 1;
+      result_.restarts += 1;
+      simplex_.RecomputeSum();
+      simplex_.Sort();
+      last_check_fun_ = simplex_.value(0);
+      StartIteration();
+      break;
     }
+    case Phase::kDone: {
+      SPDLOG_THROW2("The optimization has already finished.");
+    }
+  }
+}
 
-    iterations += 1;
-    std::vector<size_t> idx = argsort(f_simplex);
-    simplex = take(simplex, idx);
-    f_simplex = take(f_simplex, idx);
+void NelderMeadStepper::ContinueLineSearch() {
+  const size_t n_dims = this->n_dims();
+
+  if (line_search_step_ < line_search_steps_ && !active_.empty()) {
+    line_search_points_.clear();
+    for (size_t i : active_) {
+      double* x = simplex_.point(i + 1);
+      x[i] = initial_point_[i] + LineSearchOffset(i);
+      bounds_.Enforce(absl::MakeSpan(x, n_dims));
+      line_search_points_.insert(line_search_points_.end(), x, x + n_dims);
+    }
+    line_search_values_.resize(active_.size());
+    Request(Phase::kLineSearch, line_search_points_.data(), active_.size(),
+            line_search_values_.data());
+    return;
   }
 
-  std::vector<double> x = simplex[0];
+  // The remaining points move by the full range. Only those that differ from
+  // the first step of their line search, due to rounding, are evaluated.
+  line_search_points_.clear();
+  size_t n_pending = 0;
+  for (size_t i : active_) {
+    double* x = simplex_.point(i + 1);
+    x[i] = initial_point_[i] + ranges_[i];
+    bounds_.Enforce(absl::MakeSpan(x, n_dims));
+    if (x[i] == first_step_x_[i]) {
+      simplex_.value(i + 1) = first_step_f_[i];
+    } else {
+      active_[n_pending++] = i;
+      line_search_points_.insert(line_search_points_.end(), x, x + n_dims);
+    }
+  }
+  active_.resize(n_pending);
 
-  return x;
-};
+  if (n_pending > 0) {
+    line_search_values_.resize(n_pending);
+    Request(Phase::kLineSearchFallback, line_search_points_.data(), n_pending,
+            line_search_values_.data());
+    return;
+  }
+  FinishInitialSimplex();
+}
 
-std::vector<std::vector<double>> ScipyNelderMead::make_simplex(
-    const std::vector<double>& initial_point) {
-  std::vector<std::vector<double>> simplex(initial_point.size() + 1,
-                                           initial_point);
+double NelderMeadStepper::LineSearchOffset(size_t i) const {
+  if (options_.initial_simplex == InitialSimplex::kBisection) {
+    return std::ldexp(ranges_[i], -line_search_step_);
+  }
+  double step_size = ranges_[i] / double(kLineSearchSteps);
+  return step_size * (kLineSearchSteps - line_search_step_);
+}
 
-  if (stencile.size() == 1) {
-    for (size_t i = 1; i < simplex.size(); i++) {
-      simplex[i][i - 1] += stencile[0];
-    }
-  } else {
-    SPDLOG_CHECK(
-        stencile.size() == initial_point.size(),
-        fmt::format("stencile must have either size of 1 or the same size as "
-                    "initial_point: stencil.size()={}, initial_point.size()={}",
-                    stencile.size(), initial_point.size()));
+void NelderMeadStepper::FinishInitialSimplex() {
+  simplex_.RecomputeSum();
+  // sort simplex so that the first point has the lowest function value.
+  simplex_.Sort();
+  last_check_fun_ = simplex_.value(0);
+  StartIteration();
+}
 
-    for (size_t i = 1; i < simplex.size(); i++) {
-      simplex[i][i - 1] += stencile[i - 1];
-    }
+void NelderMeadStepper::StartIteration() {
+  const Simplex& simplex = simplex_;
+  const size_t fcalls = result_.fcalls;
+  const size_t iterations = result_.iterations;
+  const size_t maxfun = options_.maxfun;
+  const size_t maxiter = options_.maxiter;
+  const double xatol = options_.xatol;
+  const double fatol = options_.fatol;
+
+  // Everything that determines the remaining steps is known at this point,
+  // so resuming from here takes the same steps.
+  if (options_.checkpoint_interval > 0 &&
+      iterations % options_.checkpoint_interval == 0 &&
+      iterations != checkpoint_iteration_) {
+    SaveCheckpoint();
   }
 
-  for (size_t i = 0; i < simplex.size(); i++) {
-    EnforceBounds(lower_bound, upper_bound, simplex[i]);
+  if (fcalls > maxfun) {
+    Finish(false,
+           fmt::format("Optimizer did NOT converged. fcalls({}) > maxfun({}), "
+                       "iterations: {}, "
+                       "simplex_meets_xatol: {}, function_meets_fatol: {}",
+                       fcalls, maxfun, iterations,
+                       SimplexMeetsAbsoluteTolerance(simplex, xatol),
+                       FunctionMeetsAbsoluteTolerance(simplex, fatol)));
+    return;
   }
 
-  return simplex;
-};
+  if (iterations > maxiter) {
+    Finish(false,
+           fmt::format("Optimizer did NOT converged. iterations({}) > "
+                       "maxiter({}), fcalls: {}, "
+                       "simplex_meets_xatol: {}, function_meets_fatol: {}",
+                       iterations, maxiter, fcalls,
+                       SimplexMeetsAbsoluteTolerance(simplex, xatol),
+                       FunctionMeetsAbsoluteTolerance(simplex, fatol)));
+    return;
+  }
 
-std::vector<std::vector<double>> ScipyNelderMead::make_simplex2(
-    const CallbackFunction& callback,
-    const std::vector<double>& initial_point) {
-  std::vector<std::vector<double>> simplex(initial_point.size() + 1,
-                                           initial_point);
+  if (SimplexMeetsAbsoluteTolerance(simplex, xatol) ||
+      FunctionMeetsAbsoluteTolerance(simplex, fatol)) {
+    Finish(true,
+           fmt::format("Optimizer converged. fcalls: {}, iterations: {}, "
+                       "simplex_meets_xatol: {}, function_meets_fatol: {}",
+                       fcalls, iterations,
+                       SimplexMeetsAbsoluteTolerance(simplex, xatol),
+                       FunctionMeetsAbsoluteTolerance(simplex, fatol)));
+    return;
+  }
 
-  double f0 = callback(initial_point);
+  if (simplex.value(0) <= options_.ftarget) {
+    Finish(true, fmt::format("Optimizer reached ftarget. f({}) <= "
+                             "ftarget({}), fcalls: {}, iterations: {}",
+                             simplex.value(0), options_.ftarget, fcalls,
+                             iterations));
+    return;
+  }
+
+  if (options_.stop_requested && options_.stop_requested()) {
+    Finish(false, fmt::format("Optimizer was stopped on request. fcalls: {}, "
+                              "iterations: {}",
+                              fcalls, iterations));
+    return;
+  }
 
-  auto make_new_point = [&](size_t i, double range) {
-    double original_value = simplex[i][i - 1];
+  if (Stagnated()) {
+    StartRestart();
+    return;
+  }
 
-    int n_steps = 20;
-    double step_size = range / double(n_steps);
+  const size_t n_dims = this->n_dims();
+  const double rho = options_.rho;
+  const double chi = options_.chi;
+  const double psi = options_.psi;
 
-    for (int j = n_steps; j > 0; j--) {
-      simplex[i][i - 1] = original_value + step_size * j;
-      EnforceBounds(lower_bound, upper_bound, simplex[i]);
-      double f = callback(simplex[i]);
-      if (f < f0) {
-        return;
-      }
-    }
-    simplex[i][i - 1] = original_value + range;
-    EnforceBounds(lower_bound, upper_bound, simplex[i]);
+  if (options_.centroid_resync_interval <= 1 ||
+      iterations % options_.centroid_resync_interval == 0) {
+    simplex_.RecomputeSum();
+  }
+  GetXbar(simplex_, xbar_);
+  const absl::Span<const double> worst(simplex_.point(simplex_.size() - 1),
+                                       n_dims);
+
+  // The candidates only depend on xbar and the worst point, so they are all
+  // known up front.
+  Axpby(1 + rho, xbar_, -rho, worst,
+        absl::MakeSpan(candidate(kReflect), n_dims));
+  Axpby(1 + rho * chi, xbar_, -rho * chi, worst,
+        absl::MakeSpan(candidate(kExpand), n_dims));
+  Axpby(1 + psi * rho, xbar_, -psi * rho, worst,
+        absl::MakeSpan(candidate(kContract), n_dims));
+  Axpby(1 - psi, xbar_, psi, worst,
+        absl::MakeSpan(candidate(kInsideContract), n_dims));
+  bounds_.Enforce(absl::MakeSpan(candidates_));
+
+  std::fill(known_.begin(), known_.end(), 0);
+  std::fill(used_.begin(), used_.end(), 0);
+
+  // In parallel mode every candidate is requested speculatively in one
+  // batch. The values are then consumed in the same order as in serial mode,
+  // so both modes take identical steps and count identical fcalls.
+  if (options_.num_threads > 1) {
+    Request(Phase::kCandidates, candidates_.data(), kNumCandidates,
+            f_candidates_.data());
+    return;
+  }
+  ContinueIteration();
+}
+
+bool NelderMeadStepper::NeedCandidate(size_t k) {
+  if (!known_[k]) {
+    Request(Phase::kCandidates, candidate(k), 1, &f_candidates_[k]);
+    return true;
+  }
+  if (!used_[k]) {
+    used_[k] = 1;
+    result_.fcalls += 1;
+  }
+  return false;
+}
+
+void NelderMeadStepper::ContinueIteration() {
+  const size_t n_simplex = simplex_.size();
+  const double f_worst = simplex_.value(n_simplex - 1);
+
+  // Replaces the worst point of the simplex with candidate k.
+  auto accept = [&](size_t k) {
+    simplex_.ReplaceWorst(candidate(k), f_candidates_[k]);
+    // The candidates are listed in the same order as the steps.
+    step_ = static_cast<StepType>(k);
   };
 
-  if (stencile.size() == 1) {
-    for (size_t i = 1; i < simplex.size(); i++) {
-      make_new_point(i, stencile[0]);
+  if (NeedCandidate(kReflect)) {
+    return;
+  }
+  const double f_xr = f_candidates_[kReflect];
+
+  if (f_xr < simplex_.value(0)) {
+    if (NeedCandidate(kExpand)) {
+      return;
+    }
+    double f_xe = f_candidates_[kExpand];
+    if (f_xe < f_xr) {
+      accept(kExpand);
+    } else {
+      accept(kReflect);
     }
   } else {
-    SPDLOG_CHECK(
-        stencile.size() == initial_point.size(),
-        fmt::format("stencile must have either size of 1 or the same size as "
-                    "initial_point: stencil.size()={}, initial_point.size()={}",
-                    stencile.size(), initial_point.size()));
+    // f_simplex[0] <= f_xr
+    if (f_xr < simplex_.value(n_simplex - 2)) {
+      accept(kReflect);
+    } else {
+      // f_xr <= f_simplex[-2]
+      // Perform contraction
+      if (f_xr < f_worst) {
+        if (NeedCandidate(kContract)) {
+          return;
+        }
+        double f_xc = f_candidates_[kContract];
+        if (f_xc <= f_xr) {
+          accept(kContract);
+        } else {
+          StartShrink();
+          return;
+        }
+      } else {
+        // Perform an inside contraction
+        if (NeedCandidate(kInsideContract)) {
+          return;
+        }
+        double f_xcc = f_candidates_[kInsideContract];
 
-    for (size_t i = 1; i < simplex.size(); i++) {
-      make_new_point(i, stencile[i - 1]);
+        if (f_xcc < f_worst) {
+          accept(kInsideContract);
+        } else {
+          StartShrink();
+          return;
+        }
+      }
     }
   }
 
-  return simplex;
-};
+  FinishIteration();
+}
 
-std::vector<double> ScipyNelderMead::GetXbar(
-    const std::vector<std::vector<double>>& simplex) {
-  if (simplex.empty()) {
-    return {};
+void NelderMeadStepper::StartShrink() {
+  const size_t n_dims = this->n_dims();
+  const double sigma = options_.sigma;
+  step_ = StepType::kShrink;
+
+  // After compacting, the points to shrink are the contiguous rows 1..n of
+  // the simplex and can be evaluated as one batch.
+  simplex_.Compact();
+  const absl::Span<const double> best(simplex_.point(0), n_dims);
+  for (size_t i = 1; i < simplex_.size(); i++) {
+    const absl::Span<double> x(simplex_.point(i), n_dims);
+    Axpby(1 - sigma, best, sigma, x);
+    bounds_.Enforce(x);
   }
+  Request(Phase::kShrink, simplex_.point(1), simplex_.size() - 1,
+          &simplex_.value(1));
+}
 
-  size_t N = simplex[0].size();
-  if (simplex.size() != (N + 1)) {
-    throw std::length_error("Incorrect simplex size.");
+bool NelderMeadStepper::Stagnated() {
+  const size_t interval = options_.stagnation_iterations;
+  if (interval == 0 || result_.iterations - last_check_iteration_ < interval) {
+    return false;
   }
 
-  auto xbar = std::vector<double>(N, 0);
-  // Loop over all simplex points except for the last point.
-  for (size_t i = 0; i < (simplex.size() - 1); ++i) {
-    for (size_t j = 0; j < N; ++j) {
-      xbar[j] += simplex[i][j];
-    }
-  }
+  const double fun = simplex_.value(0);
+  const bool improved =
+      fun < last_check_fun_ -
+                options_.stagnation_rtol * std::abs(last_check_fun_);
+  last_check_iteration_ = result_.iterations;
+  last_check_fun_ = fun;
+  return !improved || simplex_.Flatness() < options_.min_flatness;
+}
 
-  for (size_t j = 0; j < N; ++j) {
-    xbar[j] /= static_cast<double>(N);
+void NelderMeadStepper::StartRestart() {
+  SPDLOG_TRACE("Restarting stagnated simplex. iterations: {}, fun: {}",
+               result_.iterations, simplex_.value(0));
+  make_simplex(simplex_);
+  Request(Phase::kRestart, simplex_.point(1), simplex_.size() - 1,
+          &simplex_.value(1));
+}
+
+void NelderMeadStepper::FinishIteration() {
+  if (options_.num_threads > 1) {
+    speculative_fcalls_ +=
+        kNumCandidates - std::count(used_.begin(), used_.end(), 1);
   }
 
-  return xbar;
+  result_.iterations += 1;
+  // All other steps only replace the worst point.
+  if (step_ == StepType::kShrink) {
+    simplex_.Sort();
+  } else {
+    simplex_.SortWorst();
+  }
+  if (options_.trace_sink) {
+    RecordIteration();
+  }
+  StartIteration();
 }
 
-void ScipyNelderMead::EnforceBounds(double lower_bound, double upper_bound,
-                                    std::vector<double>& point) {
-  for (double& p : point) {
-    if (p < lower_bound) {
-      p = lower_bound;
-    }
-    if (upper_bound < p) {
-      p = upper_bound;
+void NelderMeadStepper::RecordIteration() {
+  const size_t n_dims = this->n_dims();
+  const double* best = simplex_.point(0);
+  double diameter = 0;
+  for (size_t i = 1; i < simplex_.size(); ++i) {
+    const double* x = simplex_.point(i);
+    double distance = 0;
+    for (size_t j = 0; j < n_dims; ++j) {
+      distance += (x[j] - best[j]) * (x[j] - best[j]);
     }
+    diameter = std::max(diameter, distance);
   }
+
+  IterationEvent event;
+  event.iteration = result_.iterations - 1;
+  event.step = step_;
+  event.best_f = simplex_.value(0);
+  event.worst_f = simplex_.value(simplex_.size() - 1);
+  event.diameter = std::sqrt(diameter);
+  event.fcalls = result_.fcalls;
+  event.wall_time = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start_time_)
+                        .count();
+  options_.trace_sink->Record(event);
 }
 
-bool ScipyNelderMead::SimplexMeetsAbsoluteTolerance(
-    const std::vector<std::vector<double>>& simplex, double xatol) {
+void NelderMeadStepper::Finish(bool success, std::string status) {
+  result_.success = success;
+  result_.status = std::move(status);
+  result_.fun = simplex_.value(0);
+  result_.x.resize(n_dims());
+  bounds_.ToBounded(absl::MakeConstSpan(simplex_.point(0), n_dims()),
+                    absl::MakeSpan(result_.x));
+  Request(Phase::kDone, nullptr, 0, nullptr);
+}
+
+void NelderMeadStepper::make_simplex(Simplex& simplex) {
+  const size_t n_dims = simplex.n_dims();
+
+  // After compacting, the best point is stored in row 0 and the rebuilt
+  // points 1..n are contiguous.
+  simplex.Compact();
+  const double* best = simplex.point(0);
+  for (size_t i = 1; i < simplex.size(); i++) {
+    double* x = simplex.point(i);
+    std::copy(best, best + n_dims, x);
+    x[i - 1] += ranges_[i - 1];
+    bounds_.Enforce(absl::MakeSpan(x, n_dims));
+  }
+};
+
+void NelderMeadStepper::GetXbar(const Simplex& simplex,
+                                std::vector<double>& xbar) {
+  size_t N = simplex.n_dims();
+  xbar.resize(N);
+  if (simplex.size() == 0) {
+    return;
+  }
+
+  if (simplex.size() != (N + 1)) {
+    throw std::length_error("Incorrect simplex size.");
+  }
+
+  // Sum of all simplex points except for the last point.
+  const std::vector<double>& sum = simplex.point_sum();
+  const double* worst = simplex.point(simplex.size() - 1);
+  for (size_t j = 0; j < N; ++j) {
+    xbar[j] = (sum[j] - worst[j]) / static_cast<double>(N);
+  }
+}
+
+bool NelderMeadStepper::SimplexMeetsAbsoluteTolerance(const Simplex& simplex,
+                                                      double xatol) {
+  const double* best = simplex.point(0);
   for (size_t i = 1; i < simplex.size(); ++i) {
-    for (size_t j = 0; j < simplex[0].size(); ++j) {
-      if (std::abs(simplex[i][j] - simplex[0][j]) > xatol) {
+    const double* x = simplex.point(i);
+    for (size_t j = 0; j < simplex.n_dims(); ++j) {
+      if (std::abs(x[j] - best[j]) > xatol) {
         return false;
       }
     }
@@ -293,10 +860,10 @@ bool ScipyNelderMead::SimplexMeetsAbsoluteTolerance(
   return true;
 };
 
-bool ScipyNelderMead::FunctionMeetsAbsoluteTolerance(
-    const std::vector<double>& f_simplex, double fatol) {
-  for (size_t i = 1; i < f_simplex.size(); ++i) {
-    if (std::abs(f_simplex[i] - f_simplex[0]) > fatol) {
+bool NelderMeadStepper::FunctionMeetsAbsoluteTolerance(const Simplex& simplex,
+                                                       double fatol) {
+  for (size_t i = 1; i < simplex.size(); ++i) {
+    if (std::abs(simplex.value(i) - simplex.value(0)) > fatol) {
       return false;
     }
   }
@@ -304,4 +871,4 @@ bool ScipyNelderMead::FunctionMeetsAbsoluteTolerance(
   return true;
 };
 
-}  // namespace optimizer
\ No newline at end of file
+}  // namespace optimizer
@@ -1,22 +1,61 @@
 #ifndef NELDER_MEAD_H
 #define NELDER_MEAD_H
+#include <absl/types/span.h>
+
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "optimizer/bounds.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/simplex.h"
+#include "optimizer/trace.h"
+
 namespace optimizer {
 
-class ScipyNelderMead {
+class NelderMeadStepper;
+
+// Outcome of a single call to ScipyNelderMead::Minimize. `restarts` counts
+// the simplices rebuilt after stagnation.
+using NelderMeadResult = OptimizerResult;
+
+class ScipyNelderMead : public Optimizer {
  public:
-  using CallbackFunction = std::function<double(const std::vector<double>&)>;
   ScipyNelderMead(const std::string& name = "Scipy Nelder Mead")
       : name_(name) {};
 
-  std::vector<double> Minimize(const CallbackFunction& callback,
-                               const std::vector<double>& initial_point);
-  std::string name() { return name_; };
+  std::vector<double> Minimize(
+      const CallbackFunction& callback,
+      const std::vector<double>& initial_point) override;
+
+  // Same as above, but every set of independent points (the initial simplex,
+  // each step of its line search and the shrink step) is sent to the callback
+  // as one batch. The callback is responsible for its own
+  // parallelism.
+  std::vector<double> Minimize(
+      const BatchCallbackFunction& callback,
+      const std::vector<double>& initial_point) override;
+
+  // Continues the optimization saved in the checkpoint file at `path`, see
+  // checkpoint_path. The simplex, the counters and the options that determine
+  // the steps (rho, chi, psi, sigma, stencile, the bounds, the stagnation
+  // options and centroid_resync_interval) are restored from the checkpoint.
+  // The stopping criteria and all other options are taken from this
+  // optimizer. With the same options and a deterministic callback, the
+  // resumed optimization takes bit-identical steps to an uninterrupted one
+  // and returns the same point and counters.
+  std::vector<double> Resume(const CallbackFunction& callback,
+                             const std::string& path);
+  std::vector<double> Resume(const BatchCallbackFunction& callback,
+                             const std::string& path);
+
+  std::string name() override { return name_; };
+
+  NelderMeadResult result() const override;
 
   // tolerance for movement in the input search space for detecting convergence.
   double xatol = 1e-4;
@@ -27,28 +66,137 @@ class ScipyNelderMead {
   // Stencil value used for making the initial simplex.
   std::vector<double> stencile{0.05};
 
+  // How the initial simplex is built. The line searches of all dimensions run
+  // in lockstep, so each of their steps is one batch. Every function call is
+  // counted in fcalls.
+  InitialSimplex initial_simplex = InitialSimplex::kLineSearch;
+
   // Maximum number of function calls.
   size_t maxfun = 100;
 
   // Maximum number of iterations
   size_t maxiter = 500;
 
+  // The optimization stops successfully once the best function value is at or
+  // below ftarget.
+  double ftarget = -std::numeric_limits<double>::infinity();
+
+  // If set, called once per iteration. The optimization stops without success
+  // once it returns true. Used to cancel a running optimization from another
+  // thread.
+  std::function<bool()> stop_requested;
+
   // Number of iterations.
   size_t iterations = 0;
 
   // Number of function calls.
   size_t fcalls;
 
+  // Number of evaluations answered from the cache. These are counted in
+  // fcalls but never reached the callback.
+  size_t cache_hits = 0;
+
+  // Number of evaluations that were not in the cache and were passed to the
+  // callback.
+  size_t cache_misses = 0;
+
+  // Maximum number of function values kept in a least recently used cache
+  // during Minimize. Points found in the cache are not passed to the callback
+  // again, which typically happens near convergence and when
+  // BoundHandling::kClamp clips several candidates onto the same point. 0
+  // disables the cache.
+  size_t cache_size = 0;
+
+  // If larger than 0, points are rounded to multiples of cache_quantum before
+  // they are looked up in the cache, so points closer than this share a
+  // function value. With 0, only exactly equal points share a value.
+  double cache_quantum = 0;
+
+  // The centroid is maintained through a running sum of the simplex points
+  // that is updated in O(D) per iteration. The sum is recomputed from scratch
+  // after every shrink and every `centroid_resync_interval` iterations to
+  // bound the accumulated rounding error. With 1, it is recomputed every
+  // iteration.
+  size_t centroid_resync_interval = 100;
+
+  // Number of threads used to evaluate independent points concurrently: the
+  // initial simplex, the shrink step and the reflection, expansion and
+  // contraction candidates. With 1, all points are evaluated serially on the
+  // calling thread. Larger values require a thread-safe callback. For a
+  // deterministic callback the result does not depend on this value. With a
+  // BatchCallbackFunction, values larger than 1 make the four candidates of
+  // each iteration be sent to the callback as a single batch.
+  size_t num_threads = 1;
+
+  // Number of function calls made speculatively in parallel mode whose values
+  // were not needed by the algorithm. These are not counted in fcalls.
+  size_t speculative_fcalls = 0;
+
+  // Stagnation detection. Every stagnation_iterations iterations, the best
+  // function value is compared to the one of the previous check. The
+  // optimization stagnated if the value did not decrease by more than
+  // stagnation_rtol relative to the previous value, or if the simplex
+  // degenerated, i.e. its Simplex::Flatness() is below min_flatness. The
+  // simplex is then rebuilt around its best point with make_simplex, at the
+  // cost of one function call per dimension. This mostly helps in higher
+  // dimensions, where the simplex tends to crawl for thousands of iterations
+  // without making progress; e.g. stagnation_iterations = 50 and
+  // stagnation_rtol = 1e-3 work well. 0 disables the detection.
+  size_t stagnation_iterations = 0;
+  double stagnation_rtol = 1e-3;
+  double min_flatness = 1e-8;
+
+  // Number of times the simplex was rebuilt after stagnation.
+  size_t restarts = 0;
+
+  // If set, receives one IterationEvent per iteration. The sink is not owned
+  // and must outlive Minimize. With nullptr, tracing costs one branch per
+  // iteration.
+  TraceSink* trace_sink = nullptr;
+
+  // If checkpoint_interval is larger than 0 and checkpoint_path is not empty,
+  // the state of the optimization is written to checkpoint_path at the start
+  // of every checkpoint_interval-th iteration, including iteration 0 right
+  // after the initial simplex. Resume continues from such a file. The file is
+  // replaced atomically and synced to disk, so it holds a complete checkpoint
+  // even after a crash. A checkpoint stores the simplex in binary, about
+  // (n + 1) * (n + 4) numbers of 8 bytes, and the sync typically takes a few
+  // hundred microseconds; choose the interval so that writing it stays small
+  // against the function calls in between.
+  std::string checkpoint_path;
+  size_t checkpoint_interval = 0;
+
   // Parameters for updating simplex points.
   double rho = 1;
   double chi = 2;
   double psi = 0.5;
   double sigma = 0.5;
 
+  // If true, rho, chi, psi and sigma are ignored and set from the dimension n
+  // following Gao and Han, "Implementing the Nelder-Mead simplex algorithm
+  // with adaptive parameters" (2012): rho = 1, chi = 1 + 2 / n,
+  // psi = 0.75 - 1 / (2 n) and sigma = 1 - 1 / n. This converges much faster
+  // than the fixed parameters for n larger than about 10. For n = 2 both sets
+  // of parameters are equal.
+  bool adaptive = false;
+
   // lower and upper bound of the search space for all dimensions.
   double lower_bound = -std::numeric_limits<double>::infinity();
   double upper_bound = std::numeric_limits<double>::infinity();
 
+  // Per-dimension bounds. If not empty, they must have the size of the
+  // initial point and replace lower_bound and upper_bound, respectively.
+  std::vector<double> lower_bounds;
+  std::vector<double> upper_bounds;
+
+  // How points outside the bounds are handled, including the initial point.
+  // Every point passed to the callback lies within the bounds. With
+  // kTransform, xatol and stencile apply to the transformed space.
+  BoundHandling bound_handling = BoundHandling::kClamp;
+
+  // Function value at the point returned by Minimize.
+  double fun = std::numeric_limits<double>::infinity();
+
   // Specifies if the optimization has succeeded.
   bool success = false;
 
@@ -58,28 +206,236 @@ class ScipyNelderMead {
  private:
   std::string name_;
 
-  std::vector<std::vector<double>> make_simplex(
-      const std::vector<double>& initial_point);
+  // Resets the counters and runs `stepper` to the end.
+  std::vector<double> Run(const BatchCallbackFunction& objective,
+                          NelderMeadStepper& stepper);
+};
 
-  std::vector<std::vector<double>> make_simplex2(
-      const CallbackFunction& callback,
-      const std::vector<double>& initial_point);
+// Steppable ("ask/tell") form of ScipyNelderMead. Instead of calling an
+// objective, the stepper hands out the points it needs evaluated and resumes
+// once their values are told. This lets a single thread drive many
+// optimizations whose evaluations complete asynchronously:
+//
+//   NelderMeadStepper stepper(options, initial_point);
+//   while (!stepper.done()) {
+//     absl::Span<const double> points = stepper.Ask();
+//     ... evaluate the stepper.n_asked() rows of `points` ...
+//     stepper.Tell(values);
+//   }
+//
+// ScipyNelderMead::Minimize drives the same stepper, so both take identical
+// steps. The options are copied when the stepper is created. A stepper can be
+// moved, e.g. into a std::vector, and the points returned by Ask() stay valid
+// when it is.
+class NelderMeadStepper {
+ public:
+  NelderMeadStepper(const ScipyNelderMead& options,
+                    const std::vector<double>& initial_point);
+
+  // Creates a stepper that continues from `checkpoint`, see
+  // ScipyNelderMead::Resume for which options are restored from it.
+  static NelderMeadStepper FromCheckpoint(const ScipyNelderMead& options,
+                                          absl::Span<const char> checkpoint);
+
+  // Requests point into the buffers of the stepper, so copies would answer
+  // the requests of the original.
+  NelderMeadStepper(const NelderMeadStepper&) = delete;
+  NelderMeadStepper& operator=(const NelderMeadStepper&) = delete;
+  NelderMeadStepper(NelderMeadStepper&&) = default;
+  NelderMeadStepper& operator=(NelderMeadStepper&&) = default;
+
+  // Returns true once the optimization finished.
+  bool done() const { return phase_ == Phase::kDone; }
+
+  // Points whose function values are needed next, stored as the rows of a
+  // row-major matrix with n_dims() columns. The points stay valid until all
+  // their values were told. Empty once done().
+  absl::Span<const double> Ask() const {
+    return absl::MakeConstSpan(ask_points_, n_asked_ * n_dims());
+  }
+
+  // Number of points returned by Ask().
+  size_t n_asked() const { return n_asked_; }
+
+  // Supplies the function values of all points returned by Ask(), in order.
+  void Tell(absl::Span<const double> values);
+
+  // Supplies the function value of point i returned by Ask(). The values may
+  // arrive in any order. The stepper advances once all values arrived.
+  void Tell(size_t i, double value);
+
+  // Dimension of the search space.
+  size_t n_dims() const { return initial_point_.size(); }
+
+  // Counters and convergence status so far. The best point `x` is only set
+  // once done().
+  const NelderMeadResult& result() const& { return result_; }
+  NelderMeadResult result() && { return std::move(result_); }
+
+  // Number of function values requested speculatively whose values were not
+  // needed by the algorithm.
+  size_t speculative_fcalls() const { return speculative_fcalls_; }
+
+  // Latest checkpoint taken every options.checkpoint_interval iterations,
+  // regardless of checkpoint_path. Empty if none was taken yet. The buffer is
+  // reused, so the stepper only allocates for its first checkpoint.
+  const std::string& checkpoint() const { return checkpoint_; }
+
+  // Number of checkpoints taken so far. Changes whenever checkpoint() does.
+  size_t n_checkpoints() const { return n_checkpoints_; }
+
+ private:
+  enum class Phase {
+    // Evaluating the initial point before the line searches.
+    kInitialPoint,
+    // Evaluating one step of the line searches.
+    kLineSearch,
+    // Evaluating the points whose line search found no better point.
+    kLineSearchFallback,
+    // Evaluating all points of the stencil initial simplex.
+    kInitialSimplex,
+    // Evaluating reflection, expansion or contraction candidates.
+    kCandidates,
+    // Evaluating the shrunk simplex points.
+    kShrink,
+    // Evaluating the points of a simplex rebuilt after stagnation.
+    kRestart,
+    kDone,
+  };
+
+  // Allocates the buffers for `n_dims` dimensions without starting the
+  // optimization. The order of the arguments keeps a braced initial point of
+  // one element from selecting this constructor.
+  NelderMeadStepper(size_t n_dims, const ScipyNelderMead& options);
+
+  // Writes the state at the start of an iteration to checkpoint_.
+  void SaveCheckpoint();
+
+  // Requests the values of the `n` rows of `points` to be written to
+  // `values`.
+  void Request(Phase phase, const double* points, size_t n, double* values);
+
+  // Processes the told values of the current request.
+  void Advance();
+
+  // Rebuilds `simplex` around its best point by moving point i + 1 along
+  // dimension i by the stencil. Does not evaluate the function.
+  void make_simplex(Simplex& simplex);
+
+  // Requests the next step of the line searches, or the points without a
+  // better point once all line searches finished.
+  void ContinueLineSearch();
+
+  // Distance from the initial point of the current line search step along
+  // dimension i.
+  double LineSearchOffset(size_t i) const;
+
+  // Starts the iterations once all values of the initial simplex are known.
+  void FinishInitialSimplex();
+
+  // Checks for convergence and requests the candidates of a new iteration.
+  void StartIteration();
+
+  // Runs the iteration as far as the known candidate values allow. Requests
+  // the next candidate that is needed, or starts a shrink.
+  void ContinueIteration();
+
+  // Returns true and requests candidate k if its value is not known yet.
+  // Otherwise counts its value as used.
+  bool NeedCandidate(size_t k);
+
+  void StartShrink();
+
+  // Returns true if the optimization stagnated. Only checks every
+  // options_.stagnation_iterations iterations.
+  bool Stagnated();
+
+  // Rebuilds the simplex around the best point and requests its values.
+  void StartRestart();
+
+  void FinishIteration();
+
+  // Sends the event of the finished iteration to options_.trace_sink.
+  void RecordIteration();
+
+  // Ends the optimization with the given status.
+  void Finish(bool success, std::string status);
+
+  double* candidate(size_t k) { return &candidates_[k * n_dims()]; }
 
   // Returns true if maximum difference between simplex is smaller than xatol.
-  bool SimplexMeetsAbsoluteTolerance(
-      const std::vector<std::vector<double>>& simplex, double xatol);
+  bool SimplexMeetsAbsoluteTolerance(const Simplex& simplex, double xatol);
 
   // Returns true if maximum difference between simplex is smaller than xatol.
-  bool FunctionMeetsAbsoluteTolerance(const std::vector<double>& f_simplex,
-                                      double fatol);
+  bool FunctionMeetsAbsoluteTolerance(const Simplex& simplex, double fatol);
+
+  // Writes the average point of the simplex point except for the last point of
+  // the simplex to `xbar`. Uses the running sum of the simplex points, so it
+  // costs O(D).
+  void GetXbar(const Simplex& simplex, std::vector<double>& xbar);
+
+
+  ScipyNelderMead options_;
+  std::vector<double> initial_point_;
+  NelderMeadResult result_;
+  size_t speculative_fcalls_ = 0;
+
+  // Bounds of the search space. With BoundHandling::kTransform, the simplex
+  // lives in the transformed space and the requested points are mapped into
+  // the bounds before they are handed out by Ask().
+  Bounds bounds_;
+  std::vector<double> bounded_points_;
+
+  // Current request. request_points_ are the requested rows of the simplex
+  // or candidates, ask_points_ the points handed out by Ask().
+  Phase phase_ = Phase::kInitialPoint;
+  const double* request_points_ = nullptr;
+  const double* ask_points_ = nullptr;
+  size_t n_asked_ = 0;
+  double* ask_values_ = nullptr;
+  size_t n_told_ = 0;
+  std::vector<char> told_;
+
+  // State of the line searches. The first step of each line search moves by
+  // the full stencil; its coordinate and value are kept so that the fallback
+  // to the full stencil does not evaluate the same point again.
+  double f0_ = 0;
+  std::vector<double> ranges_;
+  std::vector<size_t> active_;
+  int line_search_step_ = 0;
+  int line_search_steps_ = 0;
+  std::vector<double> line_search_points_;
+  std::vector<double> line_search_values_;
+  std::vector<double> first_step_x_;
+  std::vector<double> first_step_f_;
+
+  Simplex simplex_;
+
+  // Workspace reused by every iteration, so that iterations do not allocate.
+  // The reflection, expansion and contraction candidates are stored as the
+  // rows of a row-major matrix.
+  std::vector<double> xbar_;
+  std::vector<double> candidates_;
+  std::vector<double> f_candidates_;
+  // Candidates whose values are known, and those whose values were used.
+  std::vector<char> known_;
+  std::vector<char> used_;
+
+  // Iteration and best function value of the last stagnation check.
+  size_t last_check_iteration_ = 0;
+  double last_check_fun_ = 0;
+
+  // Step taken by the current iteration.
+  StepType step_ = StepType::kReflect;
 
-  // Returns the average point of the simplex point except for the last point of
-  // the simplex.
-  std::vector<double> GetXbar(const std::vector<std::vector<double>>& simplex);
+  // Start of the optimization, only set when tracing.
+  std::chrono::steady_clock::time_point start_time_;
 
-  // Clips the input point to the bound limits.
-  void EnforceBounds(double lower_bound, double upper_bound,
-                     std::vector<double>& point);
+  std::string checkpoint_;
+  size_t n_checkpoints_ = 0;
+  // Iteration of the latest checkpoint, so that an iteration that is started
+  // again after a restart is only saved once.
+  size_t checkpoint_iteration_ = std::numeric_limits<size_t>::max();
 };
 
 }  // namespace optimizer
@@ -0,0 +1,385 @@
+// Benchmarks of the Nelder-Mead optimizers on standard test functions.
+//
+// Besides the wall time of a whole optimization, every benchmark reports
+//   time_per_iteration: wall time per optimizer iteration, in seconds.
+//   allocs_per_iteration: heap allocations per optimizer iteration.
+//   fcalls: function calls per optimization.
+//   iterations: optimizer iterations per optimization.
+//   success: fraction of optimizations that converged.
+// BM_InitialSimplex compares the initial simplex strategies on a short fit of
+// an expensive objective with a budget of 50 * D function calls.
+// BM_Checkpoint measures the cost of writing a checkpoint file every
+// checkpoint_interval iterations, where 0 disables checkpoints, and
+// additionally reports
+//   checkpoint_bytes: size of the checkpoint file.
+// BM_AdaptiveParameters compares the fixed and the adaptive parameters within
+// a budget of function calls and additionally reports
+//   fun: best function value found.
+// BM_Optimizer compares ScipyNelderMead, CmaEs and MultiDirectionalSearch
+// through the common Optimizer interface, with 1 or 4 threads, and
+// additionally reports fun.
+// The expensive variants spin for kExpensiveCost in every function call to
+// stand in for objectives whose cost dominates the optimizer overhead.
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "optimizer/cma_es.h"
+#include "optimizer/fixed_nelder_mead.h"
+#include "optimizer/multi_directional_search.h"
+#include "optimizer/nelder_mead.h"
+#include "optimizer/optimizer.h"
+#include "testing/allocation_counter.h"
+#include "testing/test_functions.h"
+
+namespace optimizer {
+namespace {
+
+// The test functions with the starting point used for every dimension.
+struct Quadratic {
+  static constexpr double kStart = 0.5;
+  template <typename Point>
+  double operator()(const Point& x) const {
+    return testing::ShiftedQuadratic(x);
+  }
+};
+
+struct Rosenbrock {
+  static constexpr double kStart = 0.0;
+  template <typename Point>
+  double operator()(const Point& x) const {
+    return testing::Rosenbrock(x);
+  }
+};
+
+struct Rastrigin {
+  static constexpr double kStart = 2.5;
+  template <typename Point>
+  double operator()(const Point& x) const {
+    return testing::Rastrigin(x);
+  }
+};
+
+struct Ackley {
+  static constexpr double kStart = 2.5;
+  template <typename Point>
+  double operator()(const Point& x) const {
+    return testing::Ackley(x);
+  }
+};
+
+constexpr std::chrono::microseconds kExpensiveCost(10);
+
+// Busy-waits for `duration`.
+void Spin(std::chrono::nanoseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+// Options shared by all benchmarks. maxiter bounds the run time in high
+// dimensions, where the optimizer does not converge.
+template <typename Optimizer>
+void SetOptions(Optimizer& optimizer) {
+  optimizer.fatol = 1e-8;
+  optimizer.xatol = 1e-8;
+  optimizer.maxfun = 1000000;
+  optimizer.maxiter = 20000;
+}
+
+// Sets the counters listed at the top of the file.
+void SetCounters(benchmark::State& state, size_t iterations, size_t fcalls,
+                 size_t allocations, size_t n_success) {
+  state.counters["time_per_iteration"] = benchmark::Counter(
+      iterations, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  state.counters["allocs_per_iteration"] =
+      iterations == 0 ? 0 : double(allocations) / double(iterations);
+  state.counters["fcalls"] =
+      benchmark::Counter(fcalls, benchmark::Counter::kAvgIterations);
+  state.counters["iterations"] =
+      benchmark::Counter(iterations, benchmark::Counter::kAvgIterations);
+  state.counters["success"] =
+      benchmark::Counter(n_success, benchmark::Counter::kAvgIterations);
+}
+
+// Arguments: the dimension and whether the objective is expensive.
+template <typename Objective>
+void BM_ScipyNelderMead(benchmark::State& state) {
+  const size_t n_dims = state.range(0);
+  const bool expensive = state.range(1) != 0;
+
+  ScipyNelderMead optimizer;
+  SetOptions(optimizer);
+  std::vector<double> initial_point(n_dims, Objective::kStart);
+  auto callback = [expensive](const std::vector<double>& x) {
+    if (expensive) {
+      Spin(kExpensiveCost);
+    }
+    return Objective()(x);
+  };
+
+  size_t iterations = 0;
+  size_t fcalls = 0;
+  size_t allocations = 0;
+  size_t n_success = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    benchmark::DoNotOptimize(optimizer.Minimize(callback, initial_point));
+    allocations += ::testing::AllocationCount() - count;
+    iterations += optimizer.iterations;
+    fcalls += optimizer.fcalls;
+    n_success += optimizer.success;
+  }
+  SetCounters(state, iterations, fcalls, allocations, n_success);
+}
+
+// Same as BM_ScipyNelderMead for NelderMead<N> and a cheap objective.
+template <typename Objective, size_t N>
+void BM_FixedNelderMead(benchmark::State& state) {
+  NelderMead<N> optimizer;
+  SetOptions(optimizer);
+  std::array<double, N> initial_point;
+  initial_point.fill(Objective::kStart);
+
+  size_t iterations = 0;
+  size_t fcalls = 0;
+  size_t allocations = 0;
+  size_t n_success = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    benchmark::DoNotOptimize(optimizer.Minimize(Objective(), initial_point));
+    allocations += ::testing::AllocationCount() - count;
+    iterations += optimizer.iterations;
+    fcalls += optimizer.fcalls;
+    n_success += optimizer.success;
+  }
+  SetCounters(state, iterations, fcalls, allocations, n_success);
+}
+
+// Arguments: the dimension and whether ScipyNelderMead::adaptive is set.
+template <typename Objective>
+void BM_AdaptiveParameters(benchmark::State& state) {
+  const size_t n_dims = state.range(0);
+
+  ScipyNelderMead optimizer;
+  SetOptions(optimizer);
+  optimizer.maxfun = 2000 * n_dims;
+  optimizer.maxiter = optimizer.maxfun;
+  optimizer.adaptive = state.range(1) != 0;
+  std::vector<double> initial_point(n_dims, Objective::kStart);
+  auto callback = [](const std::vector<double>& x) { return Objective()(x); };
+
+  size_t iterations = 0;
+  size_t fcalls = 0;
+  size_t allocations = 0;
+  size_t n_success = 0;
+  double fun = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    benchmark::DoNotOptimize(optimizer.Minimize(callback, initial_point));
+    allocations += ::testing::AllocationCount() - count;
+    iterations += optimizer.iterations;
+    fcalls += optimizer.fcalls;
+    n_success += optimizer.success;
+    fun += optimizer.fun;
+  }
+  SetCounters(state, iterations, fcalls, allocations, n_success);
+  state.counters["fun"] =
+      benchmark::Counter(fun, benchmark::Counter::kAvgIterations);
+}
+
+// Arguments: the dimension and the InitialSimplex strategy.
+template <typename Objective>
+void BM_InitialSimplex(benchmark::State& state) {
+  const size_t n_dims = state.range(0);
+
+  ScipyNelderMead optimizer;
+  SetOptions(optimizer);
+  optimizer.maxfun = 50 * n_dims;
+  optimizer.initial_simplex = static_cast<InitialSimplex>(state.range(1));
+  std::vector<double> initial_point(n_dims, Objective::kStart);
+  auto callback = [](const std::vector<double>& x) {
+    Spin(kExpensiveCost);
+    return Objective()(x);
+  };
+
+  size_t iterations = 0;
+  size_t fcalls = 0;
+  size_t allocations = 0;
+  size_t n_success = 0;
+  double fun = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    benchmark::DoNotOptimize(optimizer.Minimize(callback, initial_point));
+    allocations += ::testing::AllocationCount() - count;
+    iterations += optimizer.iterations;
+    fcalls += optimizer.fcalls;
+    n_success += optimizer.success;
+    fun += optimizer.fun;
+  }
+  SetCounters(state, iterations, fcalls, allocations, n_success);
+  state.counters["fun"] =
+      benchmark::Counter(fun, benchmark::Counter::kAvgIterations);
+}
+
+// Arguments: the dimension and ScipyNelderMead::checkpoint_interval.
+template <typename Objective>
+void BM_Checkpoint(benchmark::State& state) {
+  const size_t n_dims = state.range(0);
+
+  ScipyNelderMead optimizer;
+  SetOptions(optimizer);
+  optimizer.maxiter = 2000;
+  optimizer.checkpoint_interval = state.range(1);
+  optimizer.checkpoint_path =
+      (std::filesystem::temp_directory_path() / "nelder_mead_bench.checkpoint")
+          .string();
+  std::vector<double> initial_point(n_dims, Objective::kStart);
+  auto callback = [](const std::vector<double>& x) { return Objective()(x); };
+
+  size_t iterations = 0;
+  size_t fcalls = 0;
+  size_t allocations = 0;
+  size_t n_success = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    benchmark::DoNotOptimize(optimizer.Minimize(callback, initial_point));
+    allocations += ::testing::AllocationCount() - count;
+    iterations += optimizer.iterations;
+    fcalls += optimizer.fcalls;
+    n_success += optimizer.success;
+  }
+  SetCounters(state, iterations, fcalls, allocations, n_success);
+  std::error_code error;
+  const auto bytes =
+      std::filesystem::file_size(optimizer.checkpoint_path, error);
+  state.counters["checkpoint_bytes"] = error ? 0 : double(bytes);
+  std::remove(optimizer.checkpoint_path.c_str());
+}
+
+// Arguments: the dimension, whether the objective is expensive and the number
+// of threads.
+template <typename OptimizerType, typename Objective>
+void BM_Optimizer(benchmark::State& state) {
+  const size_t n_dims = state.range(0);
+  const bool expensive = state.range(1) != 0;
+
+  OptimizerType optimizer_type;
+  SetOptions(optimizer_type);
+  optimizer_type.maxfun = 2000 * n_dims;
+  optimizer_type.num_threads = state.range(2);
+  Optimizer& optimizer = optimizer_type;
+  std::vector<double> initial_point(n_dims, Objective::kStart);
+  auto callback = [expensive](const std::vector<double>& x) {
+    if (expensive) {
+      Spin(kExpensiveCost);
+    }
+    return Objective()(x);
+  };
+
+  size_t iterations = 0;
+  size_t fcalls = 0;
+  size_t allocations = 0;
+  size_t n_success = 0;
+  double fun = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    benchmark::DoNotOptimize(optimizer.Minimize(callback, initial_point));
+    allocations += ::testing::AllocationCount() - count;
+    const OptimizerResult result = optimizer.result();
+    iterations += result.iterations;
+    fcalls += result.fcalls;
+    n_success += result.success;
+    fun += result.fun;
+  }
+  SetCounters(state, iterations, fcalls, allocations, n_success);
+  state.counters["fun"] =
+      benchmark::Counter(fun, benchmark::Counter::kAvgIterations);
+}
+
+void DimensionsAndCost(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"D", "expensive"})
+      ->ArgsProduct({{2, 8, 32, 128, 512}, {0, 1}})
+      ->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(BM_ScipyNelderMead, Quadratic)->Apply(DimensionsAndCost);
+BENCHMARK_TEMPLATE(BM_ScipyNelderMead, Rosenbrock)->Apply(DimensionsAndCost);
+BENCHMARK_TEMPLATE(BM_ScipyNelderMead, Rastrigin)->Apply(DimensionsAndCost);
+BENCHMARK_TEMPLATE(BM_ScipyNelderMead, Ackley)->Apply(DimensionsAndCost);
+
+void DimensionsAndAdaptive(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"D", "adaptive"})
+      ->ArgsProduct({{10, 20, 50, 100, 200}, {0, 1}})
+      ->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(BM_AdaptiveParameters, Quadratic)
+    ->Apply(DimensionsAndAdaptive);
+BENCHMARK_TEMPLATE(BM_AdaptiveParameters, Rosenbrock)
+    ->Apply(DimensionsAndAdaptive);
+BENCHMARK_TEMPLATE(BM_AdaptiveParameters, Rastrigin)
+    ->Apply(DimensionsAndAdaptive);
+BENCHMARK_TEMPLATE(BM_AdaptiveParameters, Ackley)
+    ->Apply(DimensionsAndAdaptive);
+
+void DimensionsAndInitialSimplex(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"D", "initial_simplex"})
+      ->ArgsProduct({{8, 32, 128},
+                     {static_cast<int>(InitialSimplex::kStencil),
+                      static_cast<int>(InitialSimplex::kLineSearch),
+                      static_cast<int>(InitialSimplex::kBisection)}})
+      ->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(BM_InitialSimplex, Quadratic)
+    ->Apply(DimensionsAndInitialSimplex);
+BENCHMARK_TEMPLATE(BM_InitialSimplex, Rosenbrock)
+    ->Apply(DimensionsAndInitialSimplex);
+
+void DimensionsAndCheckpointInterval(
+    benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"D", "checkpoint_interval"})
+      ->ArgsProduct({{8, 32, 128}, {0, 1, 10, 100}})
+      ->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(BM_Checkpoint, Rosenbrock)
+    ->Apply(DimensionsAndCheckpointInterval);
+
+void DimensionsCostAndThreads(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"D", "expensive", "threads"})
+      ->ArgsProduct({{8, 32}, {0, 1}, {1, 4}})
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_Optimizer, ScipyNelderMead, Rosenbrock)
+    ->Apply(DimensionsCostAndThreads);
+BENCHMARK_TEMPLATE(BM_Optimizer, CmaEs, Rosenbrock)
+    ->Apply(DimensionsCostAndThreads);
+BENCHMARK_TEMPLATE(BM_Optimizer, MultiDirectionalSearch, Rosenbrock)
+    ->Apply(DimensionsCostAndThreads);
+BENCHMARK_TEMPLATE(BM_Optimizer, ScipyNelderMead, Rastrigin)
+    ->Apply(DimensionsCostAndThreads);
+BENCHMARK_TEMPLATE(BM_Optimizer, CmaEs, Rastrigin)
+    ->Apply(DimensionsCostAndThreads);
+BENCHMARK_TEMPLATE(BM_Optimizer, MultiDirectionalSearch, Rastrigin)
+    ->Apply(DimensionsCostAndThreads);
+
+BENCHMARK_TEMPLATE(BM_FixedNelderMead, Quadratic, 2);
+BENCHMARK_TEMPLATE(BM_FixedNelderMead, Quadratic, 8);
+BENCHMARK_TEMPLATE(BM_FixedNelderMead, Quadratic, 16);
+BENCHMARK_TEMPLATE(BM_FixedNelderMead, Rosenbrock, 2);
+BENCHMARK_TEMPLATE(BM_FixedNelderMead, Rosenbrock, 8);
+BENCHMARK_TEMPLATE(BM_FixedNelderMead, Rosenbrock, 16);
+
+}  // namespace
+}  // namespace optimizer
@@ -1,15 +1,25 @@
 #include "nelder_mead.h"
 
+#include <absl/types/span.h>
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
 
+#include <atomic>
+#include <cmath>
+#include <cstdio>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
+#include "testing/allocation_counter.h"
+#include "utils/vector_kernels.h"
 
 namespace optimizer {
 namespace {
@@ -21,6 +31,15 @@ double Rosenbrock(std::vector<double> x) {
   return std::pow(a - x[0], 2) + b * std::pow(x[1] - std::pow(x[0], 2), 2);
 };
 
+// Sum of (x_i - i)^2 with minimum at x_i = i.
+double ShiftedQuadratic(const std::vector<double>& x) {
+  double value = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    value += std::pow(x[i] - static_cast<double>(i), 2);
+  }
+  return value;
+};
+
 class ScipyNelderMeadTest : public testing::Test {
  protected:
   void SetUp() override { optimizer = std::make_unique<ScipyNelderMead>(); };
@@ -128,5 +147,543 @@ TEST_F(ScipyNelderMeadTest, UseOptimizerRepeatedly) {
   }
 }
 
+// Evaluating points in parallel must not change the path of the optimizer for
+// a deterministic callback.
+TEST_F(ScipyNelderMeadTest, ParallelModeMatchesSerialMode) {
+  for (size_t ndim : {2, 5, 12}) {
+    std::vector<double> initial_point(ndim, 0.5);
+
+    auto run = [&](size_t num_threads) {
+      ScipyNelderMead nm;
+      nm.fatol = 1e-12;
+      nm.xatol = 1e-8;
+      nm.maxfun = 5000;
+      nm.maxiter = 5000;
+      nm.num_threads = num_threads;
+      std::vector<double> x = nm.Minimize(ShiftedQuadratic, initial_point);
+      return std::make_tuple(x, nm.fcalls, nm.iterations, nm.success);
+    };
+
+    auto [serial_x, serial_fcalls, serial_iterations, serial_success] = run(1);
+    auto [parallel_x, parallel_fcalls, parallel_iterations, parallel_success] =
+        run(4);
+
+    EXPECT_EQ(serial_x, parallel_x);
+    EXPECT_EQ(serial_fcalls, parallel_fcalls);
+    EXPECT_EQ(serial_iterations, parallel_iterations);
+    EXPECT_EQ(serial_success, parallel_success);
+  }
+}
+
+// The steps use the utils/vector_kernels.h kernels, which must round the same
+// way at every SIMD level, so that results and checkpoints do not depend on
+// the CPU.
+TEST_F(ScipyNelderMeadTest, SimdLevelDoesNotChangeResult) {
+  for (size_t ndim : {3, 8, 21}) {
+    std::vector<double> initial_point(ndim, 0.5);
+
+    auto run = [&](utils::SimdLevel level) {
+      utils::SetSimdLevel(level);
+      ScipyNelderMead nm;
+      nm.fatol = 1e-12;
+      nm.xatol = 1e-8;
+      nm.maxfun = 5000;
+      nm.maxiter = 5000;
+      std::vector<double> x = nm.Minimize(ShiftedQuadratic, initial_point);
+      utils::SetSimdLevel(utils::SupportedSimdLevel());
+      return std::make_tuple(x, nm.fun, nm.fcalls, nm.iterations);
+    };
+
+    EXPECT_EQ(run(utils::SimdLevel::kScalar),
+              run(utils::SupportedSimdLevel()))
+        << ndim;
+  }
+}
+
+TEST_F(ScipyNelderMeadTest, ParallelModeCountsSpeculativeCalls) {
+  std::atomic<size_t> n_calls{0};
+  auto callback = [&n_calls](const std::vector<double>& x) {
+    n_calls += 1;
+    return Rosenbrock(x);
+  };
+
+  optimizer->num_threads = 4;
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-6;
+  optimizer->maxfun = 200;
+  optimizer->Minimize(callback, {0, 0});
+
+  EXPECT_GT(optimizer->speculative_fcalls, 0);
+  EXPECT_GE(n_calls.load(),
+            optimizer->fcalls + optimizer->speculative_fcalls);
+}
+
+TEST_F(ScipyNelderMeadTest, BatchCallbackMatchesSingleCallback) {
+  std::vector<double> initial_point(6, 0.5);
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-8;
+  optimizer->maxfun = 5000;
+  optimizer->maxiter = 5000;
+
+  std::vector<double> single_x =
+      optimizer->Minimize(ShiftedQuadratic, initial_point);
+  size_t single_fcalls = optimizer->fcalls;
+
+  std::vector<size_t> batch_sizes;
+  ScipyNelderMead::BatchCallbackFunction batch_callback =
+      [&batch_sizes](absl::Span<const double> points,
+                     absl::Span<double> values) {
+        batch_sizes.push_back(values.size());
+        const size_t n_dims = points.size() / values.size();
+        for (size_t i = 0; i < values.size(); ++i) {
+          values[i] = ShiftedQuadratic(
+              std::vector<double>(points.begin() + i * n_dims,
+                                  points.begin() + (i + 1) * n_dims));
+        }
+      };
+  std::vector<double> batch_x =
+      optimizer->Minimize(batch_callback, initial_point);
+
+  EXPECT_EQ(single_x, batch_x);
+  EXPECT_EQ(single_fcalls, optimizer->fcalls);
+
+  // The initial point, then the first step of the line search along all
+  // dimensions at once.
+  ASSERT_GE(batch_sizes.size(), 2);
+  EXPECT_EQ(batch_sizes[0], 1);
+  EXPECT_EQ(batch_sizes[1], initial_point.size());
+
+  // The whole stencil initial simplex is evaluated as one batch.
+  batch_sizes.clear();
+  optimizer->initial_simplex = InitialSimplex::kStencil;
+  optimizer->Minimize(batch_callback, initial_point);
+  ASSERT_GE(batch_sizes.size(), 1);
+  EXPECT_EQ(batch_sizes[0], initial_point.size() + 1);
+}
+
+// The running centroid sum must reach the same minimum as recomputing the
+// centroid every iteration.
+TEST_F(ScipyNelderMeadTest, IncrementalCentroidMatchesFullRecompute) {
+  std::vector<double> initial_point(8, 0.5);
+
+  auto run = [&](size_t centroid_resync_interval) {
+    ScipyNelderMead nm;
+    nm.fatol = 1e-14;
+    nm.xatol = 1e-9;
+    nm.maxfun = 100000;
+    nm.maxiter = 100000;
+    nm.centroid_resync_interval = centroid_resync_interval;
+    std::vector<double> x = nm.Minimize(ShiftedQuadratic, initial_point);
+    EXPECT_TRUE(nm.success);
+    return x;
+  };
+
+  std::vector<double> exact = run(1);
+  std::vector<double> incremental = run(1000000);
+
+  for (size_t i = 0; i < initial_point.size(); ++i) {
+    EXPECT_NEAR(incremental[i], static_cast<double>(i), 1e-4);
+    EXPECT_NEAR(incremental[i], exact[i], 1e-4);
+  }
+}
+
+// In exact mode the cache must not change the result, and the callback must
+// only be called for the cache misses.
+TEST_F(ScipyNelderMeadTest, ExactCacheSkipsRepeatedPoints) {
+  std::vector<double> initial_point{0.49, 0};
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-8;
+  optimizer->maxfun = 1000;
+  // Clipping makes many candidates collapse onto the nearby bound.
+  optimizer->lower_bound = -0.5;
+  optimizer->upper_bound = 0.5;
+
+  std::vector<double> uncached_x =
+      optimizer->Minimize(Rosenbrock, initial_point);
+  size_t uncached_fcalls = optimizer->fcalls;
+  EXPECT_EQ(optimizer->cache_hits, 0);
+
+  size_t n_calls = 0;
+  auto counting_rosenbrock = [&n_calls](const std::vector<double>& x) {
+    n_calls += 1;
+    return Rosenbrock(x);
+  };
+  optimizer->cache_size = 1000;
+  std::vector<double> cached_x =
+      optimizer->Minimize(counting_rosenbrock, initial_point);
+
+  EXPECT_EQ(cached_x, uncached_x);
+  EXPECT_EQ(optimizer->fcalls, uncached_fcalls);
+  EXPECT_GT(optimizer->cache_hits, 0);
+  EXPECT_EQ(optimizer->cache_misses, n_calls);
+  EXPECT_THAT(optimizer->status, ::testing::HasSubstr("cache_hits: "));
+}
+
+// Once the optimizer is set up, its iterations must not allocate.
+TEST_F(ScipyNelderMeadTest, IterationsDoNotAllocate) {
+  std::vector<double> initial_point(5, 0.5);
+  // Negative tolerances are never met, so every run ends at maxiter.
+  optimizer->fatol = -1;
+  optimizer->xatol = -1;
+  optimizer->maxfun = 1000000;
+
+  auto count_allocations = [&](size_t maxiter) {
+    optimizer->maxiter = maxiter;
+    size_t count = ::testing::AllocationCount();
+    optimizer->Minimize(ShiftedQuadratic, initial_point);
+    return ::testing::AllocationCount() - count;
+  };
+
+  // Warm up buffers that are reused across calls to Minimize.
+  count_allocations(1);
+
+  EXPECT_EQ(count_allocations(10), count_allocations(2000));
+}
+
+// The adaptive parameters of Gao and Han equal the defaults for 2 dimensions.
+TEST_F(ScipyNelderMeadTest, AdaptiveMatchesDefaultsInTwoDimensions) {
+  std::vector<double> initial_point = {0, 0};
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-8;
+  optimizer->maxfun = 1000;
+  std::vector<double> x = optimizer->Minimize(Rosenbrock, initial_point);
+  size_t fcalls = optimizer->fcalls;
+
+  optimizer->adaptive = true;
+  EXPECT_EQ(optimizer->Minimize(Rosenbrock, initial_point), x);
+  EXPECT_EQ(optimizer->fcalls, fcalls);
+}
+
+TEST_F(ScipyNelderMeadTest, AdaptiveConvergesInHighDimensions) {
+  std::vector<double> initial_point(20, 0.5);
+  optimizer->fatol = 1e-8;
+  optimizer->xatol = 1e-8;
+  optimizer->maxfun = 40000;
+  optimizer->maxiter = 40000;
+
+  optimizer->Minimize(ShiftedQuadratic, initial_point);
+  double fixed_fun = optimizer->fun;
+
+  optimizer->adaptive = true;
+  optimizer->Minimize(ShiftedQuadratic, initial_point);
+  EXPECT_TRUE(optimizer->success);
+  EXPECT_LT(optimizer->fun, 1e-6);
+  EXPECT_GT(fixed_fun, 1);
+  // The options are not modified.
+  EXPECT_EQ(optimizer->chi, 2);
+}
+
+// Without restarts, the simplex stalls far from the minimum in 20 dimensions.
+TEST_F(ScipyNelderMeadTest, StagnationRestartsReachBetterMinimum) {
+  std::vector<double> initial_point(20, 0.5);
+  optimizer->fatol = -1;
+  optimizer->xatol = -1;
+  optimizer->maxfun = 20000;
+  optimizer->maxiter = 1000000;
+
+  optimizer->Minimize(ShiftedQuadratic, initial_point);
+  double plain_fun = optimizer->fun;
+  EXPECT_EQ(optimizer->restarts, 0);
+
+  optimizer->stagnation_iterations = 50;
+  optimizer->stagnation_rtol = 1e-3;
+  optimizer->Minimize(ShiftedQuadratic, initial_point);
+  EXPECT_GT(optimizer->restarts, 0);
+  EXPECT_EQ(optimizer->result().restarts, optimizer->restarts);
+  EXPECT_LT(optimizer->fun, 0.01 * plain_fun);
+  EXPECT_LE(optimizer->fcalls, optimizer->maxfun + initial_point.size());
+}
+
+// Every function call, including those made to build the initial simplex, is
+// counted in fcalls.
+TEST_F(ScipyNelderMeadTest, InitialSimplexCountsEveryCall) {
+  const size_t n_dims = 6;
+  size_t calls = 0;
+  auto function = [&calls](const std::vector<double>& x) {
+    calls++;
+    return ShiftedQuadratic(x);
+  };
+
+  // maxfun = 0 stops right after the initial simplex.
+  optimizer->maxfun = 0;
+  for (auto [initial_simplex, max_fcalls] :
+       {std::make_pair(InitialSimplex::kStencil, n_dims + 1),
+        std::make_pair(InitialSimplex::kLineSearch, 20 * n_dims + 1),
+        std::make_pair(InitialSimplex::kBisection, 6 * n_dims + 1)}) {
+    calls = 0;
+    optimizer->initial_simplex = initial_simplex;
+    optimizer->Minimize(function, std::vector<double>(n_dims, 0.5));
+    EXPECT_EQ(optimizer->iterations, 0);
+    EXPECT_EQ(optimizer->fcalls, calls);
+    EXPECT_LE(optimizer->fcalls, max_fcalls);
+    EXPECT_GT(optimizer->fcalls, n_dims);
+  }
+
+  optimizer->maxfun = 5000;
+  optimizer->maxiter = 5000;
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-8;
+  for (InitialSimplex initial_simplex :
+       {InitialSimplex::kStencil, InitialSimplex::kLineSearch,
+        InitialSimplex::kBisection}) {
+    calls = 0;
+    optimizer->initial_simplex = initial_simplex;
+    optimizer->Minimize(function, std::vector<double>(n_dims, 0.5));
+    EXPECT_TRUE(optimizer->success);
+    EXPECT_EQ(optimizer->fcalls, calls);
+  }
+}
+
+// Driving the stepper by hand takes the same steps as Minimize.
+TEST_F(ScipyNelderMeadTest, StepperMatchesMinimize) {
+  for (size_t num_threads : {1, 4}) {
+    std::vector<double> initial_point(5, 0.5);
+    optimizer->fatol = 1e-12;
+    optimizer->xatol = 1e-8;
+    optimizer->maxfun = 5000;
+    optimizer->maxiter = 5000;
+    optimizer->num_threads = num_threads;
+    std::vector<double> x =
+        optimizer->Minimize(ShiftedQuadratic, initial_point);
+
+    NelderMeadStepper stepper(*optimizer, initial_point);
+    std::vector<double> values;
+    while (!stepper.done()) {
+      absl::Span<const double> points = stepper.Ask();
+      values.resize(stepper.n_asked());
+      for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = ShiftedQuadratic(std::vector<double>(
+            points.begin() + i * stepper.n_dims(),
+            points.begin() + (i + 1) * stepper.n_dims()));
+      }
+      stepper.Tell(values);
+    }
+
+    EXPECT_EQ(stepper.result().x, x);
+    EXPECT_EQ(stepper.result().fun, optimizer->fun);
+    EXPECT_EQ(stepper.result().fcalls, optimizer->fcalls);
+    EXPECT_EQ(stepper.result().iterations, optimizer->iterations);
+    EXPECT_EQ(stepper.result().status, optimizer->status);
+    EXPECT_EQ(stepper.speculative_fcalls(), optimizer->speculative_fcalls);
+  }
+}
+
+// Values told out of order and optimizations interleaved on one thread give
+// the same results as running each optimization on its own.
+TEST_F(ScipyNelderMeadTest, StepperAcceptsValuesInAnyOrder) {
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-8;
+  optimizer->maxfun = 5000;
+  optimizer->maxiter = 5000;
+  optimizer->num_threads = 4;
+
+  std::vector<std::vector<double>> initial_points = {
+      {0.5, 0.5, 0.5}, {-1, 2, 0}, {3, 3, 3}};
+  std::vector<NelderMeadStepper> steppers;
+  for (const std::vector<double>& initial_point : initial_points) {
+    steppers.emplace_back(*optimizer, initial_point);
+  }
+
+  bool all_done = false;
+  while (!all_done) {
+    all_done = true;
+    for (NelderMeadStepper& stepper : steppers) {
+      if (stepper.done()) {
+        continue;
+      }
+      all_done = false;
+      absl::Span<const double> points = stepper.Ask();
+      for (size_t i = stepper.n_asked(); i-- > 0;) {
+        stepper.Tell(i, ShiftedQuadratic(std::vector<double>(
+                            points.begin() + i * stepper.n_dims(),
+                            points.begin() + (i + 1) * stepper.n_dims())));
+      }
+    }
+  }
+
+  for (size_t k = 0; k < steppers.size(); ++k) {
+    std::vector<double> x =
+        optimizer->Minimize(ShiftedQuadratic, initial_points[k]);
+    EXPECT_EQ(steppers[k].result().x, x);
+    EXPECT_EQ(steppers[k].result().fcalls, optimizer->fcalls);
+    EXPECT_TRUE(steppers[k].result().success);
+  }
+}
+
+TEST_F(ScipyNelderMeadTest, StepperRejectsValuesAfterDone) {
+  optimizer->maxiter = 0;
+  NelderMeadStepper stepper(*optimizer, {1, 2});
+  while (!stepper.done()) {
+    std::vector<double> values(stepper.n_asked(), 1.0);
+    stepper.Tell(values);
+  }
+
+  EXPECT_EQ(stepper.n_asked(), 0);
+  EXPECT_THROW(stepper.Tell(0, 1.0), std::runtime_error);
+  EXPECT_THROW(stepper.Tell(std::vector<double>{}), std::runtime_error);
+}
+
+// Every point passed to the callback lies within the per-dimension bounds,
+// and the optimizer finds the minimum on the bounds.
+TEST_F(ScipyNelderMeadTest, PerDimensionBoundsHoldForEveryStrategy) {
+  std::vector<double> lower = {-1, -1, 0.5};
+  std::vector<double> upper = {0.5, 0.5, 3};
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-10;
+  optimizer->maxfun = 5000;
+  optimizer->maxiter = 5000;
+  optimizer->lower_bounds = lower;
+  optimizer->upper_bounds = upper;
+
+  for (BoundHandling handling :
+       {BoundHandling::kClamp, BoundHandling::kReflect,
+        BoundHandling::kTransform}) {
+    optimizer->bound_handling = handling;
+    bool in_bounds = true;
+    auto function = [&](const std::vector<double>& x) {
+      for (size_t j = 0; j < x.size(); ++j) {
+        in_bounds = in_bounds && lower[j] <= x[j] && x[j] <= upper[j];
+      }
+      return ShiftedQuadratic(x);
+    };
+    // The initial point violates the bounds in the last dimension.
+    std::vector<double> x = optimizer->Minimize(function, {0.25, 0.25, 0});
+    EXPECT_TRUE(in_bounds);
+    EXPECT_TRUE(optimizer->success) << optimizer->status;
+    EXPECT_NEAR(x[0], 0, 1e-3);
+    EXPECT_NEAR(x[1], 0.5, 1e-3);
+    EXPECT_NEAR(x[2], 2, 1e-3);
+  }
+
+  optimizer->lower_bounds = {0};
+  EXPECT_THROW(optimizer->Minimize(ShiftedQuadratic, {0.25, 0.25, 1}),
+               std::runtime_error);
+}
+
+// Reflecting keeps candidates that leave the bounds apart, so fewer points
+// are evaluated more than once than when clamping them onto the bounds.
+TEST_F(ScipyNelderMeadTest, ReflectionRepeatsFewerPoints) {
+  std::vector<double> initial_point{0.49, 0};
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-8;
+  optimizer->maxfun = 1000;
+  optimizer->lower_bound = -0.5;
+  optimizer->upper_bound = 0.5;
+  optimizer->cache_size = 1000;
+
+  optimizer->Minimize(Rosenbrock, initial_point);
+  const size_t clamp_hits = optimizer->cache_hits;
+  const double clamp_fun = optimizer->fun;
+  optimizer->bound_handling = BoundHandling::kReflect;
+  optimizer->Minimize(Rosenbrock, initial_point);
+  EXPECT_LT(optimizer->cache_hits, clamp_hits);
+  EXPECT_NEAR(optimizer->fun, clamp_fun, 1e-6);
+}
+
+// An optimization that is interrupted and resumed from its last checkpoint
+// takes the same steps as an uninterrupted one.
+TEST_F(ScipyNelderMeadTest, ResumeContinuesBitExactly) {
+  auto function = [](const std::vector<double>& x) {
+    double value = 0;
+    for (size_t i = 0; i + 1 < x.size(); ++i) {
+      value += 100 * std::pow(x[i + 1] - x[i] * x[i], 2) +
+               std::pow(1 - x[i], 2);
+    }
+    return value;
+  };
+  std::vector<double> initial_point(10, 0);
+  optimizer->fatol = -1;
+  optimizer->xatol = -1;
+  optimizer->maxfun = 10000;
+  optimizer->maxiter = 1000000;
+  optimizer->adaptive = true;
+  optimizer->stagnation_iterations = 50;
+  optimizer->lower_bound = -0.5;
+  std::vector<double> x = optimizer->Minimize(function, initial_point);
+  const NelderMeadResult expected = optimizer->result();
+  ASSERT_GT(expected.restarts, 0);
+
+  const std::string path = testing::TempDir() + "/nelder_mead.checkpoint";
+  std::remove(path.c_str());
+  optimizer->checkpoint_path = path;
+  optimizer->checkpoint_interval = 100;
+  size_t calls = 0;
+  auto interrupted = [&](const std::vector<double>& point) {
+    if (++calls > expected.fcalls / 2) {
+      throw std::runtime_error("Interrupted.");
+    }
+    return function(point);
+  };
+  EXPECT_THROW(optimizer->Minimize(interrupted, initial_point),
+               std::runtime_error);
+
+  ScipyNelderMead resumed;
+  resumed.fatol = -1;
+  resumed.xatol = -1;
+  resumed.maxfun = 10000;
+  resumed.maxiter = 1000000;
+  EXPECT_EQ(resumed.Resume(function, path), x);
+  EXPECT_EQ(resumed.fun, expected.fun);
+  EXPECT_EQ(resumed.fcalls, expected.fcalls);
+  EXPECT_EQ(resumed.iterations, expected.iterations);
+  EXPECT_EQ(resumed.restarts, expected.restarts);
+  EXPECT_EQ(resumed.status, expected.status);
+  std::remove(path.c_str());
+}
+
+// A stepper restored from any of its checkpoints finishes with the same
+// result.
+TEST_F(ScipyNelderMeadTest, StepperResumesFromEveryCheckpoint) {
+  optimizer->fatol = 1e-12;
+  optimizer->xatol = 1e-8;
+  optimizer->maxfun = 5000;
+  optimizer->maxiter = 5000;
+  optimizer->checkpoint_interval = 1;
+
+  auto run = [](NelderMeadStepper& stepper,
+                std::vector<std::string>* checkpoints) {
+    std::vector<double> values;
+    while (!stepper.done()) {
+      absl::Span<const double> points = stepper.Ask();
+      values.resize(stepper.n_asked());
+      for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = ShiftedQuadratic(std::vector<double>(
+            points.begin() + i * stepper.n_dims(),
+            points.begin() + (i + 1) * stepper.n_dims()));
+      }
+      const size_t n_checkpoints = stepper.n_checkpoints();
+      stepper.Tell(values);
+      if (checkpoints && stepper.n_checkpoints() != n_checkpoints) {
+        checkpoints->push_back(stepper.checkpoint());
+      }
+    }
+  };
+
+  NelderMeadStepper stepper(*optimizer, std::vector<double>(4, 0.5));
+  std::vector<std::string> checkpoints;
+  run(stepper, &checkpoints);
+  ASSERT_EQ(checkpoints.size(), stepper.result().iterations + 1);
+
+  for (const std::string& checkpoint : checkpoints) {
+    NelderMeadStepper resumed =
+        NelderMeadStepper::FromCheckpoint(*optimizer, checkpoint);
+    run(resumed, nullptr);
+    EXPECT_EQ(resumed.result().x, stepper.result().x);
+    EXPECT_EQ(resumed.result().fcalls, stepper.result().fcalls);
+    EXPECT_EQ(resumed.result().iterations, stepper.result().iterations);
+  }
+}
+
+TEST_F(ScipyNelderMeadTest, ResumeRejectsInvalidCheckpoints) {
+  EXPECT_THROW(NelderMeadStepper::FromCheckpoint(*optimizer, {}),
+               std::runtime_error);
+  std::string not_a_checkpoint = "not a checkpoint";
+  EXPECT_THROW(
+      NelderMeadStepper::FromCheckpoint(*optimizer, not_a_checkpoint),
+      std::runtime_error);
+  EXPECT_THROW(optimizer->Resume(Rosenbrock, testing::TempDir() + "/missing"),
+               std::runtime_error);
+}
+
 }  // namespace
 }  // namespace optimizer
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "optimizer.h"
+
+#include <absl/types/span.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "utils/thread_pool.h"
+
+namespace optimizer {
+
+Optimizer::BatchCallbackFunction Optimizer::MakeBatchCallback(
+    const CallbackFunction& callback, size_t num_threads) {
+  if (num_threads > 1 &&
+      (!thread_pool_ || thread_pool_->size() != num_threads)) {
+    thread_pool_ = std::make_shared<utils::ThreadPool>(num_threads);
+  }
+  utils::ThreadPool* thread_pool =
+      num_threads > 1 ? thread_pool_.get() : nullptr;
+
+  // One buffer per point of a batch, reused between calls, so points are only
+  // copied, not allocated. The buffers belong to this callback, so a callback
+  // that runs another optimization on the same thread cannot overwrite them.
+  auto buffers = std::make_shared<std::vector<std::vector<double>>>();
+  return [thread_pool, buffers, &callback](absl::Span<const double> points,
+                                           absl::Span<double> values) {
+    const size_t n_dims = points.size() / values.size();
+    if (buffers->size() < values.size()) {
+      buffers->resize(values.size());
+    }
+    auto evaluate = [&](size_t i) {
+      std::vector<double>& x = (*buffers)[i];
+      x.assign(points.begin() + i * n_dims, points.begin() + (i + 1) * n_dims);
+      values[i] = callback(x);
+    };
+    if (thread_pool) {
+      thread_pool->ParallelFor(values.size(), evaluate);
+    } else {
+      for (size_t i = 0; i < values.size(); ++i) {
+        evaluate(i);
+      }
+    }
+  };
+}
+
+}  // namespace optimizer
@@ -0,0 +1,90 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <absl/types/span.h>
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utils {
+class ThreadPool;
+}  // namespace utils
+
+namespace optimizer {
+
+// Outcome of a single call to Optimizer::Minimize.
+struct OptimizerResult {
+  // Best point found.
+  std::vector<double> x;
+
+  // Function value at x.
+  double fun = std::numeric_limits<double>::infinity();
+
+  size_t iterations = 0;
+  size_t fcalls = 0;
+
+  // Number of times the search was restarted, e.g. a stagnated Nelder-Mead
+  // simplex that was rebuilt.
+  size_t restarts = 0;
+
+  bool success = false;
+  std::string status;
+};
+
+// Interface of the derivative-free minimizers. Options and counters are public
+// members of the implementations.
+class Optimizer {
+ public:
+  using CallbackFunction = std::function<double(const std::vector<double>&)>;
+
+  // Evaluates a batch of points. `points` holds the points as the rows of a
+  // row-major matrix with `values.size()` rows, and the value of row i is
+  // written to `values[i]`.
+  using BatchCallbackFunction = std::function<void(
+      absl::Span<const double> points, absl::Span<double> values)>;
+
+  virtual ~Optimizer() = default;
+
+  // Minimizes `callback` starting from `initial_point` and returns the best
+  // point found.
+  virtual std::vector<double> Minimize(
+      const CallbackFunction& callback,
+      const std::vector<double>& initial_point) = 0;
+
+  // Same as above, but the points that can be evaluated independently are
+  // sent to the callback as one batch. The callback is responsible for its
+  // own parallelism.
+  virtual std::vector<double> Minimize(
+      const BatchCallbackFunction& callback,
+      const std::vector<double>& initial_point) = 0;
+
+  // Returns the counters and the convergence status of the last call to
+  // Minimize. The returned point is not part of the optimizer state, so `x`
+  // is left empty.
+  virtual OptimizerResult result() const = 0;
+
+  virtual std::string name() = 0;
+
+ protected:
+  // Returns a batch callback that evaluates every point of a batch with
+  // `callback`, spread over `num_threads` threads if larger than 1, in which
+  // case `callback` must be thread-safe. The returned callback refers to
+  // `callback`, which must outlive it. It keeps its own buffers for the points,
+  // so it must not be called concurrently with itself, but `callback` may run
+  // other optimizations.
+  BatchCallbackFunction MakeBatchCallback(const CallbackFunction& callback,
+                                          size_t num_threads);
+
+ private:
+  // Pool used by the batch callbacks. Created on demand when num_threads is
+  // larger than 1.
+  std::shared_ptr<utils::ThreadPool> thread_pool_;
+};
+
+}  // namespace optimizer
+
+#endif  // OPTIMIZER_H
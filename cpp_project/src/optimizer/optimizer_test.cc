@@ -0,0 +1,150 @@
+#include "optimizer.h"
+
+#include <absl/types/span.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "optimizer/cma_es.h"
+#include "optimizer/multi_directional_search.h"
+#include "optimizer/nelder_mead.h"
+#include "testing/test_functions.h"
+
+namespace optimizer {
+namespace {
+
+// Creates an optimizer with tight tolerances, a budget of `maxfun` calls and
+// `num_threads` threads.
+struct OptimizerFactory {
+  std::string name;
+  std::function<std::unique_ptr<Optimizer>(size_t num_threads, size_t maxfun)>
+      make;
+};
+
+template <typename T>
+OptimizerFactory Factory(const std::string& name) {
+  return {name, [](size_t num_threads, size_t maxfun) {
+            auto optimizer = std::make_unique<T>();
+            optimizer->xatol = 1e-8;
+            optimizer->fatol = 1e-12;
+            optimizer->maxfun = maxfun;
+            optimizer->maxiter = maxfun;
+            optimizer->num_threads = num_threads;
+            return optimizer;
+          }};
+}
+
+constexpr size_t kMaxfun = 20000;
+
+double Quadratic(const std::vector<double>& x) {
+  return testing::ShiftedQuadratic(x);
+}
+
+// Contract shared by every Optimizer.
+class OptimizerTest : public testing::TestWithParam<OptimizerFactory> {};
+
+TEST_P(OptimizerTest, MinimizesQuadratic) {
+  std::unique_ptr<Optimizer> optimizer = GetParam().make(1, kMaxfun);
+  std::vector<double> x =
+      optimizer->Minimize(Quadratic, std::vector<double>(4, 0.5));
+
+  OptimizerResult result = optimizer->result();
+  EXPECT_TRUE(result.success) << optimizer->name() << ": " << result.status;
+  EXPECT_EQ(result.fun, Quadratic(x));
+  EXPECT_TRUE(result.x.empty());
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_NEAR(x[i], i, 1e-3) << optimizer->name();
+  }
+}
+
+TEST_P(OptimizerTest, CountsEveryCall) {
+  std::unique_ptr<Optimizer> optimizer = GetParam().make(1, kMaxfun);
+  size_t calls = 0;
+  auto counting = [&calls](const std::vector<double>& x) {
+    calls += 1;
+    return Quadratic(x);
+  };
+  optimizer->Minimize(counting, std::vector<double>(3, 0.5));
+  EXPECT_EQ(optimizer->result().fcalls, calls) << optimizer->name();
+}
+
+TEST_P(OptimizerTest, BatchCallbackMatchesSingleCallback) {
+  std::unique_ptr<Optimizer> optimizer = GetParam().make(1, kMaxfun);
+  std::vector<double> initial_point(3, 0.5);
+  std::vector<double> x = optimizer->Minimize(Quadratic, initial_point);
+  OptimizerResult single = optimizer->result();
+
+  Optimizer::BatchCallbackFunction batch =
+      [](absl::Span<const double> points, absl::Span<double> values) {
+        const size_t n_dims = points.size() / values.size();
+        for (size_t i = 0; i < values.size(); ++i) {
+          values[i] = Quadratic(std::vector<double>(
+              points.begin() + i * n_dims, points.begin() + (i + 1) * n_dims));
+        }
+      };
+  EXPECT_EQ(optimizer->Minimize(batch, initial_point), x);
+  EXPECT_EQ(optimizer->result().fcalls, single.fcalls);
+  EXPECT_EQ(optimizer->result().iterations, single.iterations);
+}
+
+TEST_P(OptimizerTest, ThreadsDoNotChangeResult) {
+  std::vector<double> initial_point(6, 0.5);
+  std::unique_ptr<Optimizer> serial = GetParam().make(1, kMaxfun);
+  std::vector<double> x = serial->Minimize(Quadratic, initial_point);
+
+  std::unique_ptr<Optimizer> parallel = GetParam().make(4, kMaxfun);
+  std::atomic<size_t> calls{0};
+  auto counting = [&calls](const std::vector<double>& x) {
+    calls += 1;
+    return Quadratic(x);
+  };
+  EXPECT_EQ(parallel->Minimize(counting, initial_point), x);
+  EXPECT_EQ(parallel->result().fcalls, serial->result().fcalls);
+  EXPECT_GE(calls.load(), parallel->result().fcalls);
+}
+
+TEST_P(OptimizerTest, CallbackMayRunAnotherOptimization) {
+  std::unique_ptr<Optimizer> outer = GetParam().make(1, 2000);
+  std::unique_ptr<Optimizer> inner = GetParam().make(1, 200);
+  bool clobbered = false;
+  auto nested = [&](const std::vector<double>& x) {
+    const std::vector<double> before = x;
+    inner->Minimize(Quadratic, std::vector<double>(2, 0.5));
+    clobbered |= x != before;
+    return Quadratic(x);
+  };
+  outer->Minimize(nested, std::vector<double>(3, 0.5));
+  EXPECT_FALSE(clobbered) << outer->name();
+}
+
+TEST_P(OptimizerTest, StopsAtBudget) {
+  const size_t maxfun = 300;
+  const size_t n_dims = 10;
+  std::unique_ptr<Optimizer> optimizer = GetParam().make(1, maxfun);
+  auto rosenbrock = [](const std::vector<double>& x) {
+    return testing::Rosenbrock(x);
+  };
+  optimizer->Minimize(rosenbrock, std::vector<double>(n_dims, 0));
+
+  // Every optimizer checks the budget between batches of at most 2 n points.
+  EXPECT_FALSE(optimizer->result().success) << optimizer->name();
+  EXPECT_LE(optimizer->result().fcalls, maxfun + 2 * n_dims);
+  EXPECT_GT(optimizer->result().fcalls, maxfun / 2);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Optimizers, OptimizerTest,
+    testing::Values(Factory<ScipyNelderMead>("ScipyNelderMead"),
+                    Factory<CmaEs>("CmaEs"),
+                    Factory<MultiDirectionalSearch>("MultiDirectionalSearch")),
+    [](const testing::TestParamInfo<OptimizerFactory>& info) {
+      return info.param.name;
+    });
+
+}  // namespace
+}  // namespace optimizer
@@ -0,0 +1,145 @@
+#include "simplex.h"
+
+#include <absl/types/span.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include "utils/logging.h"
+#include "utils/math.h"
+
+namespace optimizer {
+
+Simplex::Simplex(const std::vector<double>& point)
+    : n_dims_(point.size()),
+      values_(point.size() + 1, 0),
+      order_(point.size() + 1),
+      compact_points_(size() * n_dims_),
+      compact_values_(size()) {
+  points_.reserve(size() * n_dims_);
+  for (size_t i = 0; i < size(); ++i) {
+    points_.insert(points_.end(), point.begin(), point.end());
+  }
+  std::iota(order_.begin(), order_.end(), 0);
+  RecomputeSum();
+}
+
+void Simplex::RecomputeSum() {
+  point_sum_.assign(n_dims_, 0);
+  for (size_t i = 0; i < size(); ++i) {
+    const double* x = &points_[i * n_dims_];
+    for (size_t j = 0; j < n_dims_; ++j) {
+      point_sum_[j] += x[j];
+    }
+  }
+}
+
+void Simplex::ReplaceWorst(const double* point, double value) {
+  double* worst = this->point(size() - 1);
+  for (size_t j = 0; j < n_dims_; ++j) {
+    point_sum_[j] += point[j] - worst[j];
+  }
+  std::copy(point, point + n_dims_, worst);
+  this->value(size() - 1) = value;
+}
+
+void Simplex::Sort() { utils::Argsort(values_, absl::MakeSpan(order_)); }
+
+void Simplex::SortWorst() {
+  utils::ArgsortUpdate(values_, size() - 1, absl::MakeSpan(order_));
+}
+
+void Simplex::Compact() {
+  compact_points_.resize(points_.size());
+  compact_values_.resize(values_.size());
+  for (size_t k = 0; k < size(); ++k) {
+    std::copy(point(k), point(k) + n_dims_, &compact_points_[k * n_dims_]);
+    compact_values_[k] = value(k);
+  }
+  points_.swap(compact_points_);
+  values_.swap(compact_values_);
+  std::iota(order_.begin(), order_.end(), 0);
+}
+
+double Simplex::Flatness() {
+  const size_t n = n_dims_;
+  if (n == 0) {
+    return 1;
+  }
+
+  // Normalized edges, as the rows of a n x n matrix.
+  double* edges = compact_points_.data();
+  const double* best = point(0);
+  for (size_t i = 0; i < n; ++i) {
+    const double* x = point(i + 1);
+    double* edge = &edges[i * n];
+    double norm = 0;
+    for (size_t j = 0; j < n; ++j) {
+      edge[j] = x[j] - best[j];
+      norm += edge[j] * edge[j];
+    }
+    if (norm == 0) {
+      return 0;
+    }
+    norm = std::sqrt(norm);
+    for (size_t j = 0; j < n; ++j) {
+      edge[j] /= norm;
+    }
+  }
+
+  // Gaussian elimination with partial pivoting. The determinant is the
+  // product of the pivots, accumulated as a sum of logarithms.
+  double log_det = 0;
+  for (size_t k = 0; k < n; ++k) {
+    size_t pivot = k;
+    for (size_t i = k + 1; i < n; ++i) {
+      if (std::abs(edges[i * n + k]) > std::abs(edges[pivot * n + k])) {
+        pivot = i;
+      }
+    }
+    if (edges[pivot * n + k] == 0) {
+      return 0;
+    }
+    if (pivot != k) {
+      std::swap_ranges(&edges[k * n], &edges[(k + 1) * n], &edges[pivot * n]);
+    }
+    const double* row_k = &edges[k * n];
+    log_det += std::log(std::abs(row_k[k]));
+    for (size_t i = k + 1; i < n; ++i) {
+      double* row_i = &edges[i * n];
+      const double factor = row_i[k] / row_k[k];
+      for (size_t j = k; j < n; ++j) {
+        row_i[j] -= factor * row_k[j];
+      }
+    }
+  }
+
+  return std::exp(log_det / static_cast<double>(n));
+}
+
+void Simplex::Save(CheckpointWriter& writer) const {
+  writer.WriteDoubles(points_);
+  writer.WriteDoubles(values_);
+  writer.WriteSizes(order_);
+  writer.WriteDoubles(point_sum_);
+}
+
+void Simplex::Load(CheckpointReader& reader) {
+  reader.ReadDoubles(absl::MakeSpan(points_));
+  reader.ReadDoubles(absl::MakeSpan(values_));
+  reader.ReadSizes(absl::MakeSpan(order_));
+  // The ranking must be a permutation of the points.
+  std::vector<bool> seen(size(), false);
+  for (size_t k : order_) {
+    SPDLOG_CHECK(k < size(), fmt::format("Invalid simplex rank {}.", k));
+    SPDLOG_CHECK(!seen[k], fmt::format("Duplicate simplex rank {}.", k));
+    seen[k] = true;
+  }
+  reader.ReadDoubles(absl::MakeSpan(point_sum_));
+}
+
+}  // namespace optimizer
@@ -0,0 +1,112 @@
+#ifndef SIMPLEX_H
+#define SIMPLEX_H
+
+#include <absl/types/span.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "optimizer/checkpoint.h"
+
+namespace optimizer {
+
+// Strategies for building the initial simplex around the initial point x0.
+// Point i + 1 of the simplex is x0 moved along dimension i.
+enum class InitialSimplex {
+  // Moves by the stencil. Costs n + 1 function calls.
+  kStencil,
+  // Line search that walks from the full stencil towards x0 in 20 equal steps
+  // and stops at the first point better than x0. If there is none, the point
+  // is moved by the full stencil. Costs up to 20 n + 1 function calls.
+  kLineSearch,
+  // Same as kLineSearch, but halves the step each time, from the full stencil
+  // down to 1/32 of it. Costs up to 6 n + 1 function calls.
+  kBisection,
+};
+
+// Simplex of n_dims + 1 points stored as the rows of a single row-major
+// buffer. The points are ranked by their function value through a permutation
+// index, so sorting the simplex moves indices instead of points.
+class Simplex {
+ public:
+  Simplex() = default;
+
+  // Creates a simplex whose points are all equal to `point`.
+  explicit Simplex(const std::vector<double>& point);
+
+  // Dimension of the search space.
+  size_t n_dims() const { return n_dims_; }
+
+  // Number of points in the simplex.
+  size_t size() const { return values_.size(); }
+
+  // Point with rank k, where rank 0 is the best point. Writing to the point
+  // directly requires a RecomputeSum() afterwards.
+  double* point(size_t k) { return &points_[order_[k] * n_dims_]; }
+  const double* point(size_t k) const { return &points_[order_[k] * n_dims_]; }
+
+  // Function value of the point with rank k.
+  double& value(size_t k) { return values_[order_[k]]; }
+  double value(size_t k) const { return values_[order_[k]]; }
+
+  // All points in storage order as the rows of a row-major matrix.
+  absl::Span<double> points() { return absl::MakeSpan(points_); }
+
+  // All function values in storage order.
+  absl::Span<double> values() { return absl::MakeSpan(values_); }
+
+  // Sum of all points. It is updated incrementally by ReplaceWorst(), so it
+  // accumulates rounding errors until the next RecomputeSum().
+  const std::vector<double>& point_sum() const { return point_sum_; }
+
+  // Recomputes point_sum() from scratch.
+  void RecomputeSum();
+
+  // Replaces the worst point and its value and updates point_sum() in O(D).
+  void ReplaceWorst(const double* point, double value);
+
+  // Ranks the points by function value. Points with equal values are ranked
+  // by their storage order.
+  void Sort();
+
+  // Same as Sort() if only the worst point changed since the last Sort(),
+  // e.g. by ReplaceWorst(). Moves it to its rank by insertion in O(size())
+  // instead of O(size() log size()).
+  void SortWorst();
+
+  // Returns |det(E)| / prod_i |e_i| to the power of 1 / n_dims(), where the
+  // rows e_i of E are the edges from the best point to the other points. The
+  // value lies in [0, 1]. It is 1 if the edges are orthogonal, as for a
+  // simplex built from a stencil, and tends to 0 as the simplex flattens into
+  // a lower dimensional subspace. Costs O(n_dims^3) and uses the scratch
+  // buffers of Compact(), so it does not allocate.
+  double Flatness();
+
+  // Moves the points into rank order, so that afterwards the point with rank
+  // k is stored in row k and points() lists the points from best to worst.
+  void Compact();
+
+  // Writes the points, values, ranking and running sum, so that a simplex
+  // restored by Load() takes bit-identical steps.
+  void Save(CheckpointWriter& writer) const;
+
+  // Restores a simplex written by Save(). The simplex must already have the
+  // dimension of the saved one. Throws a std::runtime_error if the stored
+  // ranking is not a permutation of the points.
+  void Load(CheckpointReader& reader);
+
+ private:
+  size_t n_dims_ = 0;
+  std::vector<double> points_;
+  std::vector<double> values_;
+  std::vector<size_t> order_;
+  std::vector<double> point_sum_;
+
+  // Scratch buffers for Compact().
+  std::vector<double> compact_points_;
+  std::vector<double> compact_values_;
+};
+
+}  // namespace optimizer
+
+#endif  // SIMPLEX_H
@@ -0,0 +1,175 @@
+#include "simplex.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "optimizer/checkpoint.h"
+
+namespace optimizer {
+namespace {
+
+// Creates a 2D simplex whose point i is (i, 10 * i) with value f[i].
+Simplex MakeSimplex(const std::vector<double>& f) {
+  Simplex simplex(std::vector<double>{0, 0});
+  for (size_t i = 0; i < simplex.size(); ++i) {
+    simplex.point(i)[0] = i;
+    simplex.point(i)[1] = 10 * i;
+    simplex.value(i) = f[i];
+  }
+  return simplex;
+}
+
+TEST(SimplexTest, ConstructorCopiesPoint) {
+  Simplex simplex(std::vector<double>{1, 2, 3});
+
+  EXPECT_EQ(simplex.n_dims(), 3);
+  EXPECT_EQ(simplex.size(), 4);
+  for (size_t i = 0; i < simplex.size(); ++i) {
+    EXPECT_THAT(std::vector<double>(simplex.point(i), simplex.point(i) + 3),
+                testing::ElementsAre(1, 2, 3));
+  }
+}
+
+TEST(SimplexTest, SortRanksPointsWithoutMovingThem) {
+  Simplex simplex = MakeSimplex({3, 1, 2});
+  std::vector<double> points(simplex.points().begin(),
+                             simplex.points().end());
+
+  simplex.Sort();
+
+  EXPECT_EQ(simplex.value(0), 1);
+  EXPECT_EQ(simplex.value(1), 2);
+  EXPECT_EQ(simplex.value(2), 3);
+  EXPECT_EQ(simplex.point(0)[1], 10);
+  EXPECT_EQ(simplex.point(2)[1], 0);
+  EXPECT_THAT(simplex.points(), testing::ElementsAreArray(points));
+}
+
+TEST(SimplexTest, CompactStoresPointsInRankOrder) {
+  Simplex simplex = MakeSimplex({3, 1, 2});
+  simplex.Sort();
+
+  simplex.Compact();
+
+  EXPECT_THAT(simplex.values(), testing::ElementsAre(1, 2, 3));
+  EXPECT_THAT(simplex.points(), testing::ElementsAre(1, 10, 2, 20, 0, 0));
+  EXPECT_EQ(simplex.point(0)[0], 1);
+  EXPECT_EQ(simplex.value(2), 3);
+}
+
+TEST(SimplexTest, ReplaceWorstUpdatesPointSum) {
+  Simplex simplex = MakeSimplex({3, 1, 2});
+  simplex.RecomputeSum();
+  simplex.Sort();
+
+  std::vector<double> point{5, 7};
+  simplex.ReplaceWorst(point.data(), 0.5);
+
+  EXPECT_EQ(simplex.value(2), 0.5);
+  EXPECT_THAT(std::vector<double>(simplex.point(2), simplex.point(2) + 2),
+              testing::ElementsAre(5, 7));
+  EXPECT_THAT(simplex.point_sum(), testing::ElementsAre(8, 37));
+}
+
+// The running sum must stay close to the exact sum over many replacements
+// without a resync.
+TEST(SimplexTest, RunningSumDriftIsBounded) {
+  const size_t n_dims = 50;
+  std::default_random_engine rng(0);
+  std::normal_distribution<double> distribution(0, 1);
+
+  Simplex simplex(std::vector<double>(n_dims, 0));
+  for (double& x : simplex.points()) {
+    x = distribution(rng);
+  }
+  for (double& f : simplex.values()) {
+    f = distribution(rng);
+  }
+  simplex.RecomputeSum();
+  simplex.Sort();
+
+  std::vector<double> point(n_dims);
+  for (size_t iteration = 0; iteration < 10000; ++iteration) {
+    for (double& x : point) {
+      x = distribution(rng);
+    }
+    simplex.ReplaceWorst(point.data(), distribution(rng));
+    simplex.Sort();
+  }
+
+  std::vector<double> running_sum = simplex.point_sum();
+  simplex.RecomputeSum();
+  for (size_t j = 0; j < n_dims; ++j) {
+    EXPECT_NEAR(running_sum[j], simplex.point_sum()[j], 1e-10);
+  }
+}
+
+TEST(SimplexTest, FlatnessDetectsDegenerateSimplex) {
+  // Points 0, e_1 and e_2, with the best point at the origin.
+  Simplex simplex(std::vector<double>{0, 0});
+  simplex.point(1)[0] = 1;
+  simplex.point(2)[1] = 1;
+  EXPECT_NEAR(simplex.Flatness(), 1, 1e-12);
+
+  // An equilateral triangle: sin(60 degrees) ^ (1 / 2).
+  simplex.point(2)[0] = 0.5;
+  simplex.point(2)[1] = std::sqrt(3) / 2;
+  EXPECT_NEAR(simplex.Flatness(), std::sqrt(std::sqrt(3) / 2), 1e-12);
+
+  // Nearly collinear points.
+  simplex.point(2)[0] = 2;
+  simplex.point(2)[1] = 1e-8;
+  EXPECT_LT(simplex.Flatness(), 1e-4);
+
+  // Two equal points.
+  simplex.point(2)[0] = 1;
+  simplex.point(2)[1] = 0;
+  EXPECT_EQ(simplex.Flatness(), 0);
+}
+
+constexpr char kMagic[9] = "SIMPLEXT";
+
+TEST(SimplexTest, LoadRestoresSavedSimplex) {
+  Simplex simplex = MakeSimplex({3, 1, 2});
+  simplex.Sort();
+  std::string buffer;
+  CheckpointWriter writer(buffer, kMagic, 1);
+  simplex.Save(writer);
+
+  Simplex loaded(std::vector<double>{0, 0});
+  CheckpointReader reader(buffer, kMagic, 1);
+  loaded.Load(reader);
+  reader.Finish();
+  EXPECT_EQ(loaded.points(), simplex.points());
+  EXPECT_EQ(loaded.values(), simplex.values());
+  EXPECT_EQ(loaded.point_sum(), simplex.point_sum());
+  for (size_t k = 0; k < simplex.size(); ++k) {
+    EXPECT_EQ(loaded.value(k), simplex.value(k));
+  }
+}
+
+TEST(SimplexTest, LoadRejectsInvalidRanking) {
+  Simplex simplex = MakeSimplex({3, 1, 2});
+  for (const std::vector<size_t>& order :
+       {std::vector<size_t>{0, 0, 1}, std::vector<size_t>{0, 1, 3}}) {
+    std::string buffer;
+    CheckpointWriter writer(buffer, kMagic, 1);
+    writer.WriteDoubles(simplex.points());
+    writer.WriteDoubles(simplex.values());
+    writer.WriteSizes(order);
+    writer.WriteDoubles(simplex.point_sum());
+
+    CheckpointReader reader(buffer, kMagic, 1);
+    EXPECT_THROW(simplex.Load(reader), std::runtime_error);
+  }
+}
+
+}  // namespace
+}  // namespace optimizer
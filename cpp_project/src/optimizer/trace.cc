@@ -0,0 +1,85 @@
+#include "trace.h"
+
+#include <fmt/ostream.h>
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "utils/logging.h"
+
+namespace optimizer {
+
+const char* StepTypeName(StepType step) {
+  switch (step) {
+    case StepType::kReflect:
+      return "reflect";
+    case StepType::kExpand:
+      return "expand";
+    case StepType::kContract:
+      return "contract";
+    case StepType::kInsideContract:
+      return "inside_contract";
+    case StepType::kShrink:
+      return "shrink";
+  }
+  return "unknown";
+}
+
+RingBufferTraceSink::RingBufferTraceSink(size_t capacity) : buffer_(capacity) {
+  SPDLOG_CHECK(capacity > 0, "Trace capacity must be positive.");
+}
+
+void RingBufferTraceSink::Record(const IterationEvent& event) {
+  buffer_[next_] = event;
+  next_ = next_ + 1 == buffer_.size() ? 0 : next_ + 1;
+  if (size_ < buffer_.size()) {
+    size_++;
+  } else {
+    dropped_++;
+  }
+}
+
+std::vector<IterationEvent> RingBufferTraceSink::Events() const {
+  std::vector<IterationEvent> events;
+  events.reserve(size_);
+  size_t first = size_ < buffer_.size() ? 0 : next_;
+  for (size_t i = 0; i < size_; ++i) {
+    events.push_back(buffer_[(first + i) % buffer_.size()]);
+  }
+  return events;
+}
+
+void RingBufferTraceSink::Clear() {
+  next_ = 0;
+  size_ = 0;
+  dropped_ = 0;
+}
+
+void RingBufferTraceSink::WriteCsv(std::ostream& out) const {
+  fmt::print(out, "iteration,step,best_f,worst_f,diameter,fcalls,wall_time\n");
+  for (const IterationEvent& e : Events()) {
+    fmt::print(out, "{},{},{},{},{},{},{}\n", e.iteration,
+               StepTypeName(e.step), e.best_f, e.worst_f, e.diameter,
+               e.fcalls, e.wall_time);
+  }
+}
+
+void RingBufferTraceSink::WriteJson(std::ostream& out) const {
+  // ordered_json keeps the fields in the order of the CSV columns. JSON has
+  // no representation of inf and nan, and dump() writes them as null.
+  nlohmann::ordered_json events = nlohmann::ordered_json::array();
+  for (const IterationEvent& e : Events()) {
+    events.push_back({{"iteration", e.iteration},
+                      {"step", StepTypeName(e.step)},
+                      {"best_f", e.best_f},
+                      {"worst_f", e.worst_f},
+                      {"diameter", e.diameter},
+                      {"fcalls", e.fcalls},
+                      {"wall_time", e.wall_time}});
+  }
+  out << events.dump(2) << "\n";
+}
+
+}  // namespace optimizer
@@ -0,0 +1,94 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace optimizer {
+
+// Kind of step taken by a Nelder-Mead iteration.
+enum class StepType : uint8_t {
+  kReflect,
+  kExpand,
+  kContract,
+  kInsideContract,
+  kShrink,
+};
+
+// Returns a lower case name of the step, e.g. "reflect".
+const char* StepTypeName(StepType step);
+
+// State of the optimizer after one iteration.
+struct IterationEvent {
+  // Number of the iteration, starting at 0.
+  size_t iteration = 0;
+
+  StepType step = StepType::kReflect;
+
+  // Function values of the best and the worst point of the simplex.
+  double best_f = 0;
+  double worst_f = 0;
+
+  // Largest Euclidean distance between the best point and any other point of
+  // the simplex.
+  double diameter = 0;
+
+  // Number of function calls so far.
+  size_t fcalls = 0;
+
+  // Seconds since the start of the optimization.
+  double wall_time = 0;
+};
+
+// Receives one event per optimizer iteration. Record() is called on the
+// thread that runs the optimizer.
+class TraceSink {
+ public:
+  virtual ~TraceSink() = default;
+
+  virtual void Record(const IterationEvent& event) = 0;
+};
+
+// Keeps the most recent events in a fixed size ring buffer that is allocated
+// once, so recording an event only copies it. Not thread-safe: use one sink
+// per optimizer.
+class RingBufferTraceSink : public TraceSink {
+ public:
+  explicit RingBufferTraceSink(size_t capacity);
+
+  void Record(const IterationEvent& event) override;
+
+  // Number of events currently held.
+  size_t size() const { return size_; }
+
+  size_t capacity() const { return buffer_.size(); }
+
+  // Number of events that were overwritten because the buffer was full.
+  size_t dropped() const { return dropped_; }
+
+  // Returns the held events from oldest to newest.
+  std::vector<IterationEvent> Events() const;
+
+  void Clear();
+
+  // Writes the held events as CSV with a header line.
+  void WriteCsv(std::ostream& out) const;
+
+  // Writes the held events as a JSON array of objects. Non-finite numbers are
+  // written as null.
+  void WriteJson(std::ostream& out) const;
+
+ private:
+  std::vector<IterationEvent> buffer_;
+
+  // Position of the next event to be written.
+  size_t next_ = 0;
+  size_t size_ = 0;
+  size_t dropped_ = 0;
+};
+
+}  // namespace optimizer
+
+#endif  // TRACE_H
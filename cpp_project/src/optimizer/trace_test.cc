@@ -0,0 +1,124 @@
+#include "trace.h"
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "optimizer/nelder_mead.h"
+
+namespace optimizer {
+namespace {
+
+IterationEvent Event(size_t iteration) {
+  IterationEvent event;
+  event.iteration = iteration;
+  event.step = StepType::kExpand;
+  event.best_f = 1.5;
+  event.worst_f = 2;
+  event.diameter = 0.25;
+  event.fcalls = 10 + iteration;
+  event.wall_time = 0.5;
+  return event;
+}
+
+TEST(RingBufferTraceSinkTest, KeepsMostRecentEvents) {
+  RingBufferTraceSink sink(3);
+  for (size_t i = 0; i < 5; ++i) {
+    sink.Record(Event(i));
+  }
+
+  std::vector<IterationEvent> events = sink.Events();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(events[0].iteration, 2);
+  EXPECT_EQ(events[1].iteration, 3);
+  EXPECT_EQ(events[2].iteration, 4);
+  EXPECT_EQ(sink.dropped(), 2);
+
+  sink.Clear();
+  EXPECT_EQ(sink.size(), 0);
+  EXPECT_TRUE(sink.Events().empty());
+}
+
+TEST(RingBufferTraceSinkTest, WritesCsv) {
+  RingBufferTraceSink sink(4);
+  sink.Record(Event(0));
+  sink.Record(Event(1));
+
+  std::ostringstream out;
+  sink.WriteCsv(out);
+  EXPECT_EQ(out.str(),
+            "iteration,step,best_f,worst_f,diameter,fcalls,wall_time\n"
+            "0,expand,1.5,2,0.25,10,0.5\n"
+            "1,expand,1.5,2,0.25,11,0.5\n");
+}
+
+TEST(RingBufferTraceSinkTest, WritesJson) {
+  RingBufferTraceSink sink(4);
+  std::ostringstream empty;
+  sink.WriteJson(empty);
+  EXPECT_EQ(empty.str(), "[]\n");
+
+  IterationEvent event = Event(0);
+  event.best_f = 0.1;
+  event.worst_f = std::numeric_limits<double>::infinity();
+  event.diameter = std::numeric_limits<double>::quiet_NaN();
+  sink.Record(event);
+  std::ostringstream out;
+  sink.WriteJson(out);
+  nlohmann::ordered_json events = nlohmann::ordered_json::parse(out.str());
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0]["iteration"], 0);
+  EXPECT_EQ(events[0]["step"], "expand");
+  EXPECT_EQ(events[0]["best_f"].get<double>(), 0.1);
+  EXPECT_TRUE(events[0]["worst_f"].is_null());
+  EXPECT_TRUE(events[0]["diameter"].is_null());
+  EXPECT_EQ(events[0]["fcalls"], 10);
+  EXPECT_EQ(events[0]["wall_time"], 0.5);
+
+  // The fields are written in the order of the CSV columns.
+  std::vector<std::string> keys;
+  for (const auto& field : events[0].items()) {
+    keys.push_back(field.key());
+  }
+  EXPECT_EQ(keys, (std::vector<std::string>{"iteration", "step", "best_f",
+                                            "worst_f", "diameter", "fcalls",
+                                            "wall_time"}));
+}
+
+TEST(RingBufferTraceSinkTest, RecordsNelderMeadIterations) {
+  auto function = [](const std::vector<double>& x) {
+    return std::pow(x[0] - 1, 2) + std::pow(x[1] + 2, 2);
+  };
+  ScipyNelderMead optimizer;
+  optimizer.maxfun = 1000;
+  RingBufferTraceSink sink(1000);
+  optimizer.trace_sink = &sink;
+  optimizer.Minimize(function, {0, 0});
+
+  std::vector<IterationEvent> events = sink.Events();
+  ASSERT_EQ(events.size(), optimizer.iterations);
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(events[i].iteration, i);
+    EXPECT_LE(events[i].best_f, events[i].worst_f);
+    if (i > 0) {
+      EXPECT_LE(events[i].best_f, events[i - 1].best_f);
+      EXPECT_GT(events[i].fcalls, events[i - 1].fcalls);
+      EXPECT_GE(events[i].wall_time, events[i - 1].wall_time);
+    }
+  }
+  EXPECT_EQ(events.back().fcalls, optimizer.fcalls);
+  EXPECT_EQ(events.back().best_f, optimizer.fun);
+
+  // The same run without a sink takes the same steps.
+  std::vector<double> traced_x = optimizer.Minimize(function, {0, 0});
+  optimizer.trace_sink = nullptr;
+  EXPECT_EQ(optimizer.Minimize(function, {0, 0}), traced_x);
+}
+
+}  // namespace
+}  // namespace optimizer
@@ -0,0 +1,15 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+namespace testing {
+
+// Number of calls to the global operator new since the start of the program.
+// Linking the allocation_counter library replaces the global operator new
+// and operator delete with counting versions.
+size_t AllocationCount();
+
+}  // namespace testing
+
+#endif  // ALLOCATION_COUNTER_H
@@ -0,0 +1,64 @@
+#ifndef TEST_FUNCTIONS_H
+#define TEST_FUNCTIONS_H
+
+#include <cmath>
+#include <cstddef>
+
+// Standard test functions for optimizers. Each function accepts any container
+// of doubles with size() and operator[], e.g. std::vector<double> or
+// std::array<double, N>, and has its global minimum of 0.
+namespace testing {
+
+// Sum of (x_i - i)^2 with minimum at x_i = i.
+template <typename Point>
+double ShiftedQuadratic(const Point& x) {
+  double value = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    const double d = x[i] - static_cast<double>(i);
+    value += d * d;
+  }
+  return value;
+}
+
+// Narrow curved valley with minimum at x_i = 1.
+template <typename Point>
+double Rosenbrock(const Point& x) {
+  double value = 0;
+  for (size_t i = 0; i + 1 < x.size(); ++i) {
+    const double a = 1 - x[i];
+    const double b = x[i + 1] - x[i] * x[i];
+    value += a * a + 100 * b * b;
+  }
+  return value;
+}
+
+// Highly multimodal function with minimum at x_i = 0.
+template <typename Point>
+double Rastrigin(const Point& x) {
+  constexpr double kTwoPi = 6.283185307179586;
+  double value = 10 * static_cast<double>(x.size());
+  for (size_t i = 0; i < x.size(); ++i) {
+    value += x[i] * x[i] - 10 * std::cos(kTwoPi * x[i]);
+  }
+  return value;
+}
+
+// Nearly flat outer region with a deep hole at x_i = 0.
+template <typename Point>
+double Ackley(const Point& x) {
+  constexpr double kTwoPi = 6.283185307179586;
+  constexpr double kE = 2.718281828459045;
+  const double n = static_cast<double>(x.size());
+  double sum_squares = 0;
+  double sum_cos = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    sum_squares += x[i] * x[i];
+    sum_cos += std::cos(kTwoPi * x[i]);
+  }
+  return -20 * std::exp(-0.2 * std::sqrt(sum_squares / n)) -
+         std::exp(sum_cos / n) + 20 + kE;
+}
+
+}  // namespace testing
+
+#endif  // TEST_FUNCTIONS_H
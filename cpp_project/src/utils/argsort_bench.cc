@@ -0,0 +1,134 @@
+// Benchmarks of the argsort family in math.h on uniformly random values.
+//
+// BM_IndirectSort is the comparison sort that Argsort uses below
+// kRadixArgsortMinSize, without the dispatch, so that it can be compared
+// with BM_RadixArgsort at every size. BM_ArgsortUpdate changes one random
+// value per iteration and restores the order. BM_PartialArgsort sorts the 3
+// smallest values, BM_ArgNthElement selects the second largest.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "utils/math.h"
+
+namespace utils {
+namespace {
+
+const int kSeed = 0;
+
+std::vector<double> RandomValues(size_t size) {
+  std::default_random_engine rng(kSeed);
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  std::vector<double> values(size);
+  for (double &value : values) {
+    value = distribution(rng);
+  }
+  return values;
+}
+
+void SetItemsProcessed(benchmark::State &state) {
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// The allocating argsort(std::vector<double>).
+void BM_ArgsortAllocating(benchmark::State &state) {
+  const std::vector<double> values = RandomValues(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(argsort(values).data());
+  }
+  SetItemsProcessed(state);
+}
+
+void BM_IndirectSort(benchmark::State &state) {
+  const std::vector<double> values = RandomValues(state.range(0));
+  std::vector<size_t> indices(values.size());
+  for (auto _ : state) {
+    std::iota(indices.begin(), indices.end(), 0);
+    std::sort(indices.begin(), indices.end(), [&values](size_t i1, size_t i2) {
+      return values[i1] < values[i2] || (values[i1] == values[i2] && i1 < i2);
+    });
+    benchmark::DoNotOptimize(indices.data());
+  }
+  SetItemsProcessed(state);
+}
+
+void BM_Argsort(benchmark::State &state) {
+  const std::vector<double> values = RandomValues(state.range(0));
+  std::vector<size_t> indices(values.size());
+  for (auto _ : state) {
+    Argsort(values, absl::MakeSpan(indices));
+    benchmark::DoNotOptimize(indices.data());
+  }
+  SetItemsProcessed(state);
+}
+
+void BM_RadixArgsort(benchmark::State &state) {
+  const std::vector<double> values = RandomValues(state.range(0));
+  std::vector<size_t> indices(values.size());
+  for (auto _ : state) {
+    RadixArgsort(values, absl::MakeSpan(indices));
+    benchmark::DoNotOptimize(indices.data());
+  }
+  SetItemsProcessed(state);
+}
+
+void BM_PartialArgsort(benchmark::State &state) {
+  const std::vector<double> values = RandomValues(state.range(0));
+  std::vector<size_t> indices(values.size());
+  for (auto _ : state) {
+    PartialArgsort(values, 3, absl::MakeSpan(indices));
+    benchmark::DoNotOptimize(indices.data());
+  }
+  SetItemsProcessed(state);
+}
+
+void BM_ArgNthElement(benchmark::State &state) {
+  const std::vector<double> values = RandomValues(state.range(0));
+  std::vector<size_t> indices(values.size());
+  const size_t n = values.size() >= 2 ? values.size() - 2 : 0;
+  for (auto _ : state) {
+    ArgNthElement(values, n, absl::MakeSpan(indices));
+    benchmark::DoNotOptimize(indices.data());
+  }
+  SetItemsProcessed(state);
+}
+
+void BM_ArgsortUpdate(benchmark::State &state) {
+  std::vector<double> values = RandomValues(state.range(0));
+  std::vector<size_t> indices(values.size());
+  Argsort(values, absl::MakeSpan(indices));
+  std::default_random_engine rng(kSeed);
+  std::uniform_int_distribution<size_t> positions(0, values.size() - 1);
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  for (auto _ : state) {
+    const size_t position = positions(rng);
+    values[indices[position]] = distribution(rng);
+    ArgsortUpdate(values, position, absl::MakeSpan(indices));
+    benchmark::DoNotOptimize(indices.data());
+  }
+  SetItemsProcessed(state);
+}
+
+void Sizes(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgName("size");
+  for (int size :
+       {3, 8, 64, 1024, 4096, 1 << 13, 1 << 14, 1 << 16, 1 << 20, 10000000}) {
+    benchmark->Arg(size);
+  }
+}
+
+BENCHMARK(BM_ArgsortAllocating)->Apply(Sizes);
+BENCHMARK(BM_IndirectSort)->Apply(Sizes);
+BENCHMARK(BM_Argsort)->Apply(Sizes);
+BENCHMARK(BM_RadixArgsort)->Apply(Sizes);
+BENCHMARK(BM_PartialArgsort)->Apply(Sizes);
+BENCHMARK(BM_ArgNthElement)->Apply(Sizes);
+BENCHMARK(BM_ArgsortUpdate)->Apply(Sizes);
+
+}  // namespace
+}  // namespace utils
@@ -0,0 +1,94 @@
+#include "blas.h"
+
+#include <absl/types/span.h>
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+#include "vector_kernels.h"
+
+namespace utils {
+namespace {
+
+void CheckSizes(size_t x_size, size_t y_size) {
+  if (x_size != y_size) {
+    throw std::invalid_argument("Spans must be of the same size.");
+  }
+}
+
+template <typename T>
+void AxpyOf(T alpha, absl::Span<const T> x, absl::Span<T> y) {
+  CheckSizes(x.size(), y.size());
+  kernels::Axpy(alpha, x.data(), y.data(), x.size());
+}
+
+template <typename T>
+void AxpbyOf(T alpha, absl::Span<const T> x, T beta, absl::Span<const T> y,
+             absl::Span<T> out) {
+  CheckSizes(x.size(), y.size());
+  CheckSizes(x.size(), out.size());
+  kernels::Axpby(alpha, x.data(), beta, y.data(), out.data(), x.size());
+}
+
+template <typename T>
+T DotOf(absl::Span<const T> x, absl::Span<const T> y) {
+  CheckSizes(x.size(), y.size());
+  return kernels::Dot(x.data(), y.data(), x.size());
+}
+
+}  // namespace
+
+void Axpy(double alpha, absl::Span<const double> x, absl::Span<double> y) {
+  AxpyOf(alpha, x, y);
+}
+
+void Axpy(float alpha, absl::Span<const float> x, absl::Span<float> y) {
+  AxpyOf(alpha, x, y);
+}
+
+void Axpby(double alpha, absl::Span<const double> x, double beta,
+           absl::Span<double> y) {
+  AxpbyOf<double>(alpha, x, beta, y, y);
+}
+
+void Axpby(float alpha, absl::Span<const float> x, float beta,
+           absl::Span<float> y) {
+  AxpbyOf<float>(alpha, x, beta, y, y);
+}
+
+void Axpby(double alpha, absl::Span<const double> x, double beta,
+           absl::Span<const double> y, absl::Span<double> out) {
+  AxpbyOf(alpha, x, beta, y, out);
+}
+
+void Axpby(float alpha, absl::Span<const float> x, float beta,
+           absl::Span<const float> y, absl::Span<float> out) {
+  AxpbyOf(alpha, x, beta, y, out);
+}
+
+double Dot(absl::Span<const double> x, absl::Span<const double> y) {
+  return DotOf(x, y);
+}
+
+float Dot(absl::Span<const float> x, absl::Span<const float> y) {
+  return DotOf(x, y);
+}
+
+double Nrm2(absl::Span<const double> x) {
+  return std::sqrt(kernels::SumOfSquares(x.data(), x.size()));
+}
+
+float Nrm2(absl::Span<const float> x) {
+  return std::sqrt(kernels::SumOfSquares(x.data(), x.size()));
+}
+
+void Scale(double alpha, absl::Span<double> x) {
+  kernels::Multiply(alpha, x.data(), x.data(), x.size());
+}
+
+void Scale(float alpha, absl::Span<float> x) {
+  kernels::Multiply(alpha, x.data(), x.data(), x.size());
+}
+
+}  // namespace utils
@@ -0,0 +1,46 @@
+#ifndef BLAS_H
+#define BLAS_H
+
+#include <absl/types/span.h>
+
+namespace utils {
+
+// BLAS level 1 style operations on spans of double or float. They work in
+// place, never allocate and use the FMA kernels of vector_kernels.h. A fused
+// expression such as `a * x + b * y` takes one pass over the data, where the
+// math.h operators take one pass and one allocation per operator. All spans
+// of one call must have the same size, otherwise std::invalid_argument is
+// thrown.
+
+// y = alpha * x + y
+void Axpy(double alpha, absl::Span<const double> x, absl::Span<double> y);
+void Axpy(float alpha, absl::Span<const float> x, absl::Span<float> y);
+
+// y = alpha * x + beta * y
+void Axpby(double alpha, absl::Span<const double> x, double beta,
+           absl::Span<double> y);
+void Axpby(float alpha, absl::Span<const float> x, float beta,
+           absl::Span<float> y);
+
+// out = alpha * x + beta * y. `out` may alias `x` or `y`.
+void Axpby(double alpha, absl::Span<const double> x, double beta,
+           absl::Span<const double> y, absl::Span<double> out);
+void Axpby(float alpha, absl::Span<const float> x, float beta,
+           absl::Span<const float> y, absl::Span<float> out);
+
+// Returns the dot product of x and y.
+double Dot(absl::Span<const double> x, absl::Span<const double> y);
+float Dot(absl::Span<const float> x, absl::Span<const float> y);
+
+// Returns the Euclidean norm of x. Unlike the reference BLAS it does not
+// rescale, so it overflows for elements beyond about 1e154 (1e19 for float).
+double Nrm2(absl::Span<const double> x);
+float Nrm2(absl::Span<const float> x);
+
+// x = alpha * x
+void Scale(double alpha, absl::Span<double> x);
+void Scale(float alpha, absl::Span<float> x);
+
+}  // namespace utils
+
+#endif  // BLAS_H
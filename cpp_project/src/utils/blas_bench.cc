@@ -0,0 +1,124 @@
+// Benchmarks of out = a * x + b * y, written with the eager math.h operators,
+// with the lazy math.h expressions and with Axpby.
+//
+// Besides the wall time, every benchmark reports
+//   bytes_per_element: bytes read and written per element of the result.
+//     The eager operators make one pass per operator, reading and writing
+//     the temporaries.
+//   allocs: heap allocations per evaluation.
+// and the memory throughput that bytes_per_element implies.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "testing/allocation_counter.h"
+#include "utils/blas.h"
+#include "utils/math.h"
+
+namespace utils {
+namespace {
+
+constexpr double kA = 1.3;
+constexpr double kB = -0.7;
+
+struct Operands {
+  explicit Operands(size_t size) : x(size, 1.5), y(size, 2.5), out(size) {}
+
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> out;
+};
+
+void SetCounters(benchmark::State& state, size_t bytes_per_element,
+                 size_t allocations) {
+  state.counters["bytes_per_element"] = double(bytes_per_element);
+  state.counters["allocs"] =
+      benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          bytes_per_element);
+}
+
+// kA * x and kB * y each read and write one vector, their sum reads two and
+// writes one.
+void BM_OperatorChain(benchmark::State& state) {
+  Operands operands(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    operands.out = kA * operands.x + kB * operands.y;
+    allocations += ::testing::AllocationCount() - count;
+    benchmark::DoNotOptimize(operands.out.data());
+  }
+  SetCounters(state, 7 * sizeof(double), allocations);
+}
+
+void BM_LazyExpression(benchmark::State& state) {
+  Operands operands(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    Assign(operands.out, kA * Lazy(operands.x) + kB * Lazy(operands.y));
+    allocations += ::testing::AllocationCount() - count;
+    benchmark::DoNotOptimize(operands.out.data());
+  }
+  SetCounters(state, 3 * sizeof(double), allocations);
+}
+
+void BM_Axpby(benchmark::State& state) {
+  Operands operands(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    Axpby(kA, operands.x, kB, operands.y, absl::MakeSpan(operands.out));
+    allocations += ::testing::AllocationCount() - count;
+    benchmark::DoNotOptimize(operands.out.data());
+  }
+  SetCounters(state, 3 * sizeof(double), allocations);
+}
+
+// Same as BM_Axpby, but the result overwrites y. Scaling y back keeps its
+// values bounded, which adds a pass that reads and writes y.
+void BM_AxpbyInPlace(benchmark::State& state) {
+  Operands operands(state.range(0));
+  size_t allocations = 0;
+  for (auto _ : state) {
+    const size_t count = ::testing::AllocationCount();
+    Axpby(kA, operands.x, kB, absl::MakeSpan(operands.y));
+    Scale(0.5, absl::MakeSpan(operands.y));
+    allocations += ::testing::AllocationCount() - count;
+    benchmark::DoNotOptimize(operands.y.data());
+  }
+  SetCounters(state, 5 * sizeof(double), allocations);
+}
+
+// Arguments: the number of elements and the SimdLevel.
+void SizesAndLevels(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"size", "level"})
+      ->ArgsProduct({{8, 64, 1024, 16384, 1 << 20},
+                     {static_cast<int>(SimdLevel::kScalar),
+                      static_cast<int>(SupportedSimdLevel())}});
+}
+
+// Selects the SimdLevel of the second argument before each benchmark.
+template <void (*Benchmark)(benchmark::State&)>
+void AtLevel(benchmark::State& state) {
+  SetSimdLevel(static_cast<SimdLevel>(state.range(1)));
+  Benchmark(state);
+  SetSimdLevel(SupportedSimdLevel());
+}
+
+BENCHMARK(AtLevel<BM_OperatorChain>)
+    ->Name("BM_OperatorChain")
+    ->Apply(SizesAndLevels);
+BENCHMARK(AtLevel<BM_LazyExpression>)
+    ->Name("BM_LazyExpression")
+    ->Apply(SizesAndLevels);
+BENCHMARK(AtLevel<BM_Axpby>)->Name("BM_Axpby")->Apply(SizesAndLevels);
+BENCHMARK(AtLevel<BM_AxpbyInPlace>)
+    ->Name("BM_AxpbyInPlace")
+    ->Apply(SizesAndLevels);
+
+}  // namespace
+}  // namespace utils
@@ -0,0 +1,107 @@
+#include "blas.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "vector_kernels.h"
+
+namespace utils {
+namespace {
+
+const int kSeed = 0;
+
+std::vector<double> Random(size_t size, std::default_random_engine &rng) {
+  std::uniform_real_distribution<double> distribution(-10, 10);
+  std::vector<double> values(size);
+  for (double &value : values) {
+    value = distribution(rng);
+  }
+  return values;
+}
+
+// Runs `test` at every SIMD level that the CPU supports.
+template <typename Test>
+void ForEachLevel(const Test &test) {
+  for (SimdLevel level :
+       {SimdLevel::kScalar, SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+    if (SetSimdLevel(level) == level) {
+      test(level);
+    }
+  }
+  SetSimdLevel(SupportedSimdLevel());
+}
+
+TEST(BlasTest, AxpbyMatchesFusedMultiplyAdd) {
+  std::default_random_engine rng(kSeed);
+  ForEachLevel([&rng](SimdLevel level) {
+    for (size_t size = 0; size <= 40; ++size) {
+      const std::vector<double> x = Random(size, rng);
+      const std::vector<double> y = Random(size, rng);
+      std::vector<double> axpy = y;
+      std::vector<double> axpby(size);
+      Axpy(1.3, x, absl::MakeSpan(axpy));
+      Axpby(1.3, x, -0.7, y, absl::MakeSpan(axpby));
+
+      // Every level rounds once per element after beta * y.
+      for (size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(axpy[i], std::fma(1.3, x[i], y[i])) << int(level);
+        ASSERT_EQ(axpby[i], std::fma(1.3, x[i], -0.7 * y[i])) << int(level);
+      }
+    }
+  });
+}
+
+TEST(BlasTest, AxpbyWorksInPlace) {
+  ForEachLevel([](SimdLevel) {
+    std::vector<double> x{1, 2, 3, 4, 5};
+    std::vector<double> y{5, 4, 3, 2, 1};
+    Axpby(0.5, x, 2, absl::MakeSpan(y));
+    EXPECT_THAT(y, testing::ElementsAre(10.5, 9, 7.5, 6, 4.5));
+
+    Axpby(2, x, 1, y, absl::MakeSpan(x));
+    EXPECT_THAT(x, testing::ElementsAre(12.5, 13, 13.5, 14, 14.5));
+
+    Scale(2, absl::MakeSpan(x));
+    EXPECT_THAT(x, testing::ElementsAre(25, 26, 27, 28, 29));
+  });
+}
+
+TEST(BlasTest, DotAndNrm2MatchScalarSums) {
+  std::default_random_engine rng(kSeed);
+  ForEachLevel([&rng](SimdLevel level) {
+    for (size_t size = 0; size <= 70; ++size) {
+      const std::vector<double> x = Random(size, rng);
+      const std::vector<double> y = Random(size, rng);
+      double dot = 0;
+      double sum_of_squares = 0;
+      for (size_t i = 0; i < size; ++i) {
+        dot += x[i] * y[i];
+        sum_of_squares += x[i] * x[i];
+      }
+      EXPECT_NEAR(Dot(x, y), dot, 1e-12 * sum_of_squares) << int(level);
+      EXPECT_NEAR(Nrm2(x), std::sqrt(sum_of_squares), 1e-12 * Nrm2(x))
+          << int(level);
+    }
+  });
+
+  std::vector<float> x{3, 4};
+  EXPECT_EQ(Nrm2(absl::MakeConstSpan(x)), 5);
+  EXPECT_EQ(Dot(absl::MakeConstSpan(x), absl::MakeConstSpan(x)), 25);
+}
+
+TEST(BlasTest, RejectsDifferentSizes) {
+  std::vector<double> x{1, 2, 3};
+  std::vector<double> y{1, 2};
+  EXPECT_THROW(Axpy(1.0, x, absl::MakeSpan(y)), std::invalid_argument);
+  EXPECT_THROW(Axpby(1.0, x, 1.0, absl::MakeSpan(y)), std::invalid_argument);
+  EXPECT_THROW(Dot(x, y), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace utils
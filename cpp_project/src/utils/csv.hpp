@@ -1802,14 +1802,17 @@ using shared_ummap_sink = basic_shared_mmap_sink<unsigned char>;
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <exception>
 #include <fstream>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <memory>
@@ -1843,8 +1846,35 @@ using shared_ummap_sink = basic_shared_mmap_sink<unsigned char>;
   */
 #define CSV_INLINE inline
 
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
+/** @def CSV_SSE2
+ *  Defined if SSE2 may be used unconditionally to scan for delimiters, quotes and newlines
+ *
+ *  @def CSV_AVX2_DISPATCH
+ *  Defined if an AVX2 scanner can be compiled and selected at runtime
+ *
+ *  @def CSV_NEON
+ *  Defined if NEON may be used to scan for delimiters, quotes and newlines
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define CSV_SSE2
+# include <emmintrin.h>
+# if defined(__GNUC__) || defined(__clang__)
+#  define CSV_AVX2_DISPATCH
+#  include <immintrin.h>
+# endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# define CSV_NEON
+# include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
 // Copyright 2017-2019 by Martin Moene
 //
 // string-view lite, a C++17-like string_view for C++98 and later.
@@ -4791,6 +4821,17 @@ namespace csv {
          */
         constexpr size_t ITERATION_CHUNK_SIZE = 10000000; // 10MB
 
+        /** Smallest part of a file which is parsed on its own thread */
+        constexpr size_t PARALLEL_MIN_RANGE_SIZE = 1000000; // 1MB
+
+        /** How many rows a parser hands to the reading thread at a time */
+        constexpr size_t ROW_BATCH_SIZE = 256;
+
+        /** How many batches of rows may wait for the reading thread before
+         *  the parser blocks
+         */
+        constexpr size_t ROW_QUEUE_CAPACITY = 64;
+
         template<typename T>
         inline bool is_equal(T a, T b, T epsilon = 0.001) {
             /** Returns true if two floating point values are about the same */
@@ -4905,6 +4946,20 @@ namespace csv {
         KEEP   = 1
     };
 
+    /** Determines in which order a multi-threaded CSVReader returns rows */
+    enum class RowOrder {
+        ORDERED = 0,  /**< Rows are returned in the order of the file */
+        UNORDERED = 1 /**< Rows of different parts of the file may be interleaved */
+    };
+
+    /** Types which CSVReader::read_batch() converts the values of a column to */
+    enum class ColumnType {
+        STRING = 0, /**< Text, stored in CSVColumn::data */
+        INT64 = 1,  /**< Base-10 integers, stored in CSVColumn::int64s */
+        DOUBLE = 2, /**< Floating point numbers, stored in CSVColumn::doubles */
+        DATE = 3    /**< Dates formatted as YYYY-MM-DD, stored in CSVColumn::dates */
+    };
+
     /** Stores the inferred format of a CSV file. */
     struct CSVGuessResult {
         char delim;
@@ -4985,6 +5040,28 @@ namespace csv {
             return *this;
         }
 
+        /** Sets the number of threads which parse a file concurrently
+         *
+         *  @param[in] n_threads Number of threads, or 0 for one per hardware thread
+         *  @param[in] order     Whether rows must be returned in the order of the file
+         *
+         *  @note Only used when reading files. Streams are parsed on one thread.
+         */
+        CSVFormat& parse_threads(size_t n_threads, RowOrder order = RowOrder::ORDERED) {
+            this->n_parse_threads = n_threads;
+            this->row_order = order;
+            return *this;
+        }
+
+        /** Sets the types which CSVReader::read_batch() converts columns to
+         *
+         *  @param[in] types Types by column name. Other columns are read as ColumnType::STRING.
+         */
+        CSVFormat& column_types(const std::unordered_map<std::string, ColumnType>& types) {
+            this->col_types = types;
+            return *this;
+        }
+
         #ifndef DOXYGEN_SHOULD_SKIP_THIS
         char get_delim() const {
             // This error should never be received by end users.
@@ -5001,6 +5078,12 @@ namespace csv {
         std::vector<char> get_possible_delims() const { return this->possible_delimiters; }
         std::vector<char> get_trim_chars() const { return this->trim_chars; }
         CONSTEXPR VariableColumnPolicy get_variable_column_policy() const { return this->variable_column_policy; }
+        size_t get_parse_threads() const {
+            return this->n_parse_threads > 0 ? this->n_parse_threads
+                : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+        CONSTEXPR RowOrder get_row_order() const { return this->row_order; }
+        const std::unordered_map<std::string, ColumnType>& get_column_types() const { return this->col_types; }
         #endif
         
         /** CSVFormat for guessing the delimiter */
@@ -5044,6 +5127,15 @@ namespace csv {
 
         /**< Allow variable length columns? */
         VariableColumnPolicy variable_column_policy = VariableColumnPolicy::IGNORE_ROW;
+
+        /**< Number of threads which parse a file, 0 for one per hardware thread */
+        size_t n_parse_threads = 1;
+
+        /**< Order of the rows parsed by several threads */
+        RowOrder row_order = RowOrder::ORDERED;
+
+        /**< Types of the columns read by CSVReader::read_batch() */
+        std::unordered_map<std::string, ColumnType> col_types = {};
     };
 }
 /** @file
@@ -5701,10 +5793,13 @@ namespace csv {
         }
     };
 
+    class CSVBatch;
+
     /** Data structure for representing CSV rows */
     class CSVRow {
     public:
         friend internals::IBasicCSVParser;
+        friend CSVBatch;
 
         CSVRow() = default;
         
@@ -5859,6 +5954,140 @@ inline std::ostream& operator << (std::ostream& os, csv::CSVField const& value)
     return os;
 }
 
+/** @file
+ *  Defines a column-major batch of CSV rows
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(CSV_HAS_CXX17) && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+namespace csv {
+    namespace internals {
+        /** @name Field Conversion
+         *  Convert a whole field, returning false if it is not a valid value of the type
+         */
+        ///@{
+        /** Parse a base-10 integer with an optional sign */
+        bool parse_int64(csv::string_view in, int64_t& out) noexcept;
+
+        /** Parse a decimal floating point number, like `std::from_chars()` */
+        bool parse_double(csv::string_view in, double& out) noexcept;
+
+        /** Parse a YYYY-MM-DD date into the number of days since 1970-01-01 */
+        bool parse_date(csv::string_view in, int32_t& out) noexcept;
+        ///@}
+    }
+
+    /** A column of a CSVBatch, laid out like an Arrow array
+     *
+     *  A ColumnType::STRING column stores the value in row i as
+     *  `data[offsets[i], offsets[i + 1])`. Columns of other types store row i in
+     *  element i of the vector for their type.
+     */
+    struct CSVColumn {
+        /** The type set with CSVFormat::column_types() */
+        ColumnType type = ColumnType::STRING;
+
+        /** Where each value starts in data, followed by the end of the last value */
+        std::vector<size_t> offsets = { 0 };
+
+        /** The values of all rows back to back, with escaped quotes unescaped */
+        std::string data;
+
+        /** @name Typed Values
+         *  Only the vector for `type` is filled. Empty fields are stored as 0.
+         */
+        ///@{
+        std::vector<int64_t> int64s;
+        std::vector<double> doubles;
+        std::vector<int32_t> dates; /**< Days since 1970-01-01 */
+
+        /** Whether value i is not empty. Only filled for types other than STRING. */
+        std::vector<uint8_t> valid;
+        ///@}
+
+        /** Return the number of values in this column */
+        size_t size() const noexcept {
+            return this->type == ColumnType::STRING ? this->offsets.size() - 1 : this->valid.size();
+        }
+
+        /** Return the value in row `i` of a ColumnType::STRING column
+         *
+         *  @throws  std::runtime_error if the column has another type or `i` is out of bounds
+         *  @warning This string_view is only valid until the batch is read into again.
+         */
+        csv::string_view operator[](size_t i) const {
+            if (this->type != ColumnType::STRING)
+                throw std::runtime_error("Only string columns can be indexed, use the vector for the column type.");
+            if (i + 1 >= this->offsets.size())
+                throw std::runtime_error("Index out of bounds.");
+
+            return csv::string_view(this->data).substr(this->offsets[i], this->offsets[i + 1] - this->offsets[i]);
+        }
+    };
+
+    /** CSV rows stored column by column, similar to an Arrow record batch
+     *
+     *  Batches are filled by CSVReader::read_batch(). Unlike CSVRow, a batch does not
+     *  refer to the parsed data, and reading into the same batch again reuses its
+     *  buffers, so that large reads do not allocate per row.
+     *
+     *  **Example**
+     *  @code
+     *  CSVBatch batch;
+     *  while (reader.read_batch(batch, 10000)) {
+     *      const CSVColumn& price = batch["Price"];
+     *      for (size_t i = 0; i < batch.n_rows(); i++)
+     *          ... price[i] ...
+     *  }
+     *  @endcode
+     */
+    class CSVBatch {
+    public:
+        /** Return the number of rows in this batch */
+        size_t n_rows() const noexcept { return this->_n_rows; }
+
+        /** Return the number of columns in this batch */
+        size_t n_cols() const noexcept { return this->columns.size(); }
+
+        /** Return the column names, or an empty vector if the CSV has no header */
+        std::vector<std::string> get_col_names() const;
+
+        /** @name Column Retrieval */
+        ///@{
+        const CSVColumn& operator[](size_t n) const;
+        const CSVColumn& operator[](const std::string& col_name) const;
+        ///@}
+
+    private:
+        friend class CSVReader;
+
+        internals::ColNamesPtr col_names = nullptr;
+        std::vector<CSVColumn> columns;
+        size_t _n_rows = 0;
+
+        /** Remove all rows and set the columns, keeping allocated buffers */
+        void clear(const internals::ColNamesPtr& _col_names, const std::vector<ColumnType>& types);
+
+        /** Append a row, padding it with empty values or dropping fields to fit the columns
+         *
+         *  @throws std::runtime_error if a value can't be converted to the type of its column,
+         *          in which case no field of the row is appended
+         */
+        void append(const CSVRow& row);
+
+        /** Remove the last value of each of the first `n_fields` columns */
+        void drop_fields(size_t n_fields);
+    };
+}
+
 
 namespace csv {
     namespace internals {
@@ -5925,104 +6154,237 @@ namespace csv {
         /** Read the first 500KB of a CSV file */
         CSV_INLINE std::string get_csv_head(csv::string_view filename, size_t file_size);
 
-        /** A std::deque wrapper which allows multiple read and write threads to concurrently
-         *  access it along with providing read threads the ability to wait for the deque
-         *  to become populated
+        /** A bounded ring buffer which passes items from one or more producer threads to
+         *  one consumer thread without taking locks
+         *
+         *  @par Implementation
+         *  As in Dmitry Vyukov's bounded MPMC queue, every slot carries a sequence number.
+         *  The slot is free for the producer at position `pos` if its sequence is `pos`,
+         *  and holds the item for the consumer at position `pos` if its sequence is
+         *  `pos + 1`. A single producer claims slots with a plain store, several producers
+         *  with a compare-and-swap on the tail.
          */
         template<typename T>
-        class ThreadSafeDeque {
+        class BoundedQueue {
         public:
-            ThreadSafeDeque(size_t notify_size = 100) : _notify_size(notify_size) {};
-            ThreadSafeDeque(const ThreadSafeDeque& other) {
-                this->data = other.data;
-                this->_notify_size = other._notify_size;
+            /** @param[in] capacity       Maximum number of items, rounded up to a power of two
+             *  @param[in] multi_producer Whether several threads may call try_push() concurrently
+             */
+            BoundedQueue(size_t capacity, bool multi_producer = false) :
+                _mask(round_up(capacity) - 1),
+                _slots(new Slot[_mask + 1]),
+                _multi_producer(multi_producer) {
+                for (size_t i = 0; i <= this->_mask; i++)
+                    this->_slots[i].sequence.store(i, std::memory_order_relaxed);
             }
 
-            ThreadSafeDeque(const std::deque<T>& source) : ThreadSafeDeque() {
-                this->data = source;
-            }
+            size_t capacity() const noexcept { return this->_mask + 1; }
 
-            void clear() noexcept { this->data.clear(); }
+            /** Move an item to the back of the queue unless the queue is full
+             *
+             *  @returns Whether the item was moved
+             */
+            bool try_push(T& item) {
+                size_t pos = this->_tail.load(std::memory_order_relaxed);
+                Slot* slot = nullptr;
+                while (true) {
+                    slot = &this->_slots[pos & this->_mask];
+                    const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                    const auto diff = (std::ptrdiff_t)(sequence - pos);
+
+                    if (diff < 0)
+                        // The consumer has not emptied this slot yet
+                        return false;
+                    else if (diff > 0)
+                        // Another producer claimed this slot
+                        pos = this->_tail.load(std::memory_order_relaxed);
+                    else if (!this->_multi_producer) {
+                        this->_tail.store(pos + 1, std::memory_order_relaxed);
+                        break;
+                    }
+                    else if (this->_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
 
-            bool empty() const noexcept {
-                return this->data.empty();
+                slot->item = std::move(item);
+                slot->sequence.store(pos + 1, std::memory_order_release);
+                return true;
             }
 
-            T& front() noexcept {
-                return this->data.front();
-            }
+            /** Move the item at the front of the queue unless the queue is empty.
+             *  Only one thread may call this.
+             *
+             *  @returns Whether an item was moved
+             */
+            bool try_pop(T& item) {
+                Slot& slot = this->_slots[this->_head & this->_mask];
+                if (slot.sequence.load(std::memory_order_acquire) != this->_head + 1)
+                    return false;
 
-            T& operator[](size_t n) {
-                return this->data[n];
+                item = std::move(slot.item);
+                slot.sequence.store(this->_head + this->_mask + 1, std::memory_order_release);
+                this->_head++;
+                return true;
             }
 
-            void push_back(T&& item) {
-                std::lock_guard<std::mutex> lock{ this->_lock };
-                this->data.push_back(std::move(item));
+        private:
+            struct Slot {
+                std::atomic<size_t> sequence;
+                T item;
+            };
 
-                if (this->size() >= _notify_size) {
-                    this->_cond.notify_all();
-                }
+            static size_t round_up(size_t n) noexcept {
+                size_t power = 1;
+                while (power < n) power <<= 1;
+                return power;
             }
 
-            T pop_front() noexcept {
-                std::lock_guard<std::mutex> lock{ this->_lock };
-                T item = std::move(data.front());
-                data.pop_front();
-                return item;
-            }
+            size_t _mask;
+            std::unique_ptr<Slot[]> _slots;
+            bool _multi_producer;
 
-            size_t size() const noexcept { return this->data.size(); }
+            /** Keep the positions of the consumer and the producers in separate cache lines */
+            alignas(64) size_t _head = 0;
+            alignas(64) std::atomic<size_t> _tail = { 0 };
+        };
 
-            /** Returns true if a thread is actively pushing items to this deque */
-            constexpr bool is_waitable() const noexcept { return this->_is_waitable; }
+        using RowBatch = std::vector<CSVRow>;
 
-            /** Wait for an item to become available */
-            void wait() {
-                if (!is_waitable()) {
-                    return;
-                }
+        /** Passes batches of rows from the parser to the thread which reads them
+         *
+         *  Producers block while the queue is full, so a slow reader holds back the parser
+         *  instead of letting parsed rows pile up. Batches are passed through a BoundedQueue,
+         *  and a thread only takes a lock when it has to sleep.
+         */
+        class RowQueue {
+        public:
+            /** @param[in] capacity       Maximum number of batches
+             *  @param[in] multi_producer Whether several threads may call push() concurrently
+             */
+            RowQueue(size_t capacity = ROW_QUEUE_CAPACITY, bool multi_producer = false) :
+                _batches(capacity, multi_producer) {};
 
-                std::unique_lock<std::mutex> lock{ this->_lock };
-                this->_cond.wait(lock, [this] { return this->size() >= _notify_size || !this->is_waitable(); });
-                lock.unlock();
-            }
+            /** @name Producer Side */
+            ///@{
+            /** Pass a batch of rows to the reading thread, waiting while the queue is full
+             *
+             *  @returns False if the reading thread has stopped reading and the rows were dropped
+             */
+            bool push(RowBatch&& batch);
 
-            typename std::deque<T>::iterator begin() noexcept {
-                return this->data.begin();
-            }
+            /** Tell the reading thread that no more rows will be pushed
+             *
+             *  @param[in] error If set, why the producer stopped. pop() rethrows it once
+             *                   the rows pushed before were retrieved.
+             */
+            void close(std::exception_ptr error = nullptr);
 
-            typename std::deque<T>::iterator end() noexcept {
-                return this->data.end();
-            }
+            /** Whether the reading thread has stopped reading */
+            bool cancelled() const noexcept { return this->_cancelled.load(std::memory_order_acquire); }
+            ///@}
 
-            /** Tell listeners that this deque is actively being pushed to */
-            void notify_all() {
-                std::unique_lock<std::mutex> lock{ this->_lock };
-                this->_is_waitable = true;
-                this->_cond.notify_all();
-            }
+            /** @name Consumer Side */
+            ///@{
+            /** Retrieve the next row, waiting until one is pushed
+             *
+             *  @returns False once the queue was closed and all rows were retrieved
+             *  @throws  The error passed to close(), once
+             */
+            bool pop(CSVRow& row);
 
-            /** Tell all listeners to stop */
-            void kill_all() {
-                std::unique_lock<std::mutex> lock{ this->_lock };
-                this->_is_waitable = false;
-                this->_cond.notify_all();
-            }
+            /** Stop reading and make pending and future pushes return false */
+            void cancel();
+            ///@}
 
         private:
-            bool _is_waitable = false;
-            size_t _notify_size;
+            BoundedQueue<RowBatch> _batches;
+
+            /** The batch being read and the position of its next row */
+            RowBatch _current;
+            size_t _current_pos = 0;
+
+            std::atomic<bool> _closed = { false };
+            std::atomic<bool> _cancelled = { false };
+
+            /** Set before _closed, so the consumer reads it after seeing _closed */
+            std::exception_ptr _error;
+
+            /** @name Sleeping Threads */
+            ///@{
             std::mutex _lock;
             std::condition_variable _cond;
-            std::deque<T> data;
+            std::atomic<int> _n_waiting = { 0 };
+            ///@}
+
+            /** Wait until `ready()` returns true */
+            template<typename Predicate>
+            void wait_until(Predicate ready);
+
+            /** Wake the threads which wait for the other side of the queue */
+            void notify();
         };
 
         constexpr const int UNINITIALIZED_FIELD = -1;
+
+        /** Finds the end of a run of NOT_SPECIAL characters
+         *
+         *  @par Implementation
+         *  Like simdjson, the input is classified 64 bytes at a time into a bitmask of
+         *  quote characters and a bitmask of delimiters and newlines. Both masks are
+         *  cached, so the short fields of a typical CSV cost one bit scan each rather
+         *  than one flag lookup per character. Blocks are classified with AVX2 if the
+         *  CPU supports it and with SSE2 or NEON otherwise.
+         *
+         *  The scanner is disabled on other targets and for parse flags with more than
+         *  one quote character or three delimiter and newline characters, in which
+         *  case the parser falls back to its scalar loop.
+         */
+        class StructuralScanner {
+        public:
+            /** Number of characters classified at a time */
+            static constexpr size_t BLOCK_SIZE = 64;
+
+            StructuralScanner() = default;
+
+            /** Construct a scanner for the special characters of parse_flags
+             *
+             *  @param[in] use_simd If false, the scanner is disabled
+             */
+            StructuralScanner(const ParseFlagMap& parse_flags, bool use_simd = true);
+
+            /** Whether or not find() may be used */
+            CONSTEXPR bool enabled() const noexcept { return this->_enabled; }
+
+            /** Return the position of the first character in `in` at or after `pos` which
+             *  is not NOT_SPECIAL given the quote escape state, or in.size() if there is
+             *  none. The same positions as a scalar loop over compound_parse_flag().
+             */
+            size_t find(csv::string_view in, size_t pos, bool quote_escape) noexcept;
+
+            /** Drop the cached block, e.g. because the input was replaced */
+            void reset() noexcept { this->_block = NO_BLOCK; }
+
+        private:
+            static constexpr size_t NO_BLOCK = (size_t)-1;
+
+            bool _enabled = false;
+            bool _has_quote = false;
+
+            /** The quote character followed by the delimiter and newline characters */
+            std::array<char, 4> _chars = {};
+
+            /** Offset of the cached block in the input */
+            size_t _block = NO_BLOCK;
+            uint64_t _quote_mask = 0;
+            uint64_t _other_mask = 0;
+
+            /** Classify the block of `in` which starts at `block` */
+            void load(csv::string_view in, size_t block) noexcept;
+        };
     }
 
-    /** Standard type for storing collection of rows */
-    using RowCollection = internals::ThreadSafeDeque<CSVRow>;
+    /** Standard type for passing rows between threads */
+    using RowCollection = internals::RowQueue;
 
     namespace internals {
         /** Abstract base class which provides CSV parsing logic.
@@ -6036,7 +6398,7 @@ namespace csv {
             IBasicCSVParser() = default;
             IBasicCSVParser(const CSVFormat&, const ColNamesPtr&);
             IBasicCSVParser(const ParseFlagMap& parse_flags, const WhitespaceMap& ws_flags
-            ) : _parse_flags(parse_flags), _ws_flags(ws_flags) {};
+            ) : _parse_flags(parse_flags), _ws_flags(ws_flags), _scanner(parse_flags) {};
 
             virtual ~IBasicCSVParser() {}
 
@@ -6060,7 +6422,17 @@ namespace csv {
             /** Whether or not this CSV has a UTF-8 byte order mark */
             CONSTEXPR bool utf8_bom() const { return this->_utf8_bom; }
 
-            void set_output(RowCollection& rows) { this->_records = &rows; }
+            /** Pass complete rows in batches to a reading thread */
+            void set_output(RowCollection& rows) {
+                this->_records = &rows;
+                this->_rows = nullptr;
+            }
+
+            /** Collect complete rows on this thread */
+            void set_output(RowBatch& rows) {
+                this->_rows = &rows;
+                this->_records = nullptr;
+            }
 
         protected:
             /** @name Current Parser State */
@@ -6087,6 +6459,20 @@ namespace csv {
             /** Whether or not source needs to be read in chunks */
             CONSTEXPR bool no_chunk() const { return this->source_size < ITERATION_CHUNK_SIZE; }
 
+            /** Whether or not an attempt to find Unicode BOM has been made */
+            bool unicode_bom_scan = false;
+            bool _utf8_bom = false;
+
+            /** Where complete rows should be pushed to */
+            RowCollection* _records = nullptr;
+            RowBatch* _rows = nullptr;
+
+            /** Complete rows which were not pushed to _records yet */
+            RowBatch _batch;
+
+            /** Push the current batch of rows to _records */
+            void flush_rows();
+
             /** Parse the current chunk of data *
              *
              *  @returns How many character were read that are part of complete rows
@@ -6100,19 +6486,16 @@ namespace csv {
              *  be trimmed
              */
             WhitespaceMap _ws_flags;
+
+            /** Finds the end of NOT_SPECIAL runs in parse_field() */
+            StructuralScanner _scanner;
+
             bool quote_escape = false;
             bool field_has_double_quote = false;
 
             /** Where we are in the current data block */
             size_t data_pos = 0;
 
-            /** Whether or not an attempt to find Unicode BOM has been made */
-            bool unicode_bom_scan = false;
-            bool _utf8_bom = false;
-
-            /** Where complete rows should be pushed to */
-            RowCollection* _records = nullptr;
-
             CONSTEXPR_17 bool ws_flag(const char ch) const noexcept {
                 return _ws_flags.data()[ch + 128];
             }
@@ -6138,8 +6521,6 @@ namespace csv {
          */
         template<typename TStream>
         class StreamParser: public IBasicCSVParser {
-            using RowCollection = ThreadSafeDeque<CSVRow>;
-
         public:
             StreamParser(TStream& source,
                 const CSVFormat& format,
@@ -6227,6 +6608,75 @@ namespace csv {
             std::string _filename;
             size_t mmap_pos = 0;
         };
+
+        /** Parser for one range of a memory-mapped window, used by ParallelMmapParser */
+        class RangeParser : public IBasicCSVParser {
+        public:
+            RangeParser(const CSVFormat& format, const ColNamesPtr& col_names, bool scan_utf8_bom)
+                : IBasicCSVParser(format, col_names) {
+                this->unicode_bom_scan = !scan_utf8_bom;
+            }
+
+            /** Not used: ranges are parsed with parse_range() */
+            void next(size_t) override {}
+
+            /** Parse `range`, a part of the data owned by `source`
+             *
+             *  @param[in] last Whether or not the range ends the file, in which case
+             *                  an incomplete last row is pushed as well
+             *  @returns How many characters were read that are part of complete rows
+             */
+            size_t parse_range(const std::shared_ptr<void>& source, csv::string_view range, bool last);
+        };
+
+        /** Parser for memory-mapped files which parses every window on several threads
+         *
+         *  @par Implementation
+         *  Every window of `bytes * n_threads` bytes is split into up to n_threads ranges
+         *  which start at a row boundary. Since it is not known whether a split point is
+         *  inside a quoted field, range_start() speculates it from the nearby quotes. The
+         *  ranges are parsed concurrently, and then each range is checked against the end
+         *  of the last complete row of its predecessor. A range whose start turned out to
+         *  be wrong is parsed again from there, which only happens for quoted fields with
+         *  newlines near a split point.
+         *
+         *  Range 0 pushes its rows while it is parsed. With RowOrder::ORDERED every other
+         *  range pushes its rows as one batch after its predecessor, with RowOrder::UNORDERED
+         *  as soon as its start is confirmed. The latter needs a multi-producer RowQueue.
+         */
+        class ParallelMmapParser : public IBasicCSVParser {
+        public:
+            /**
+             *  @param[in] min_range_size Ranges are not made smaller than this, so that small
+             *                            files are not split across all threads
+             */
+            ParallelMmapParser(csv::string_view filename,
+                const CSVFormat& format,
+                const ColNamesPtr& col_names = nullptr,
+                size_t min_range_size = PARALLEL_MIN_RANGE_SIZE
+            ) : IBasicCSVParser(format, col_names),
+                _format(format),
+                n_threads(format.get_parse_threads()),
+                min_range_size(std::max<size_t>(min_range_size, 1)) {
+                this->_filename = filename.data();
+                this->source_size = get_file_size(filename);
+            };
+
+            ~ParallelMmapParser() {}
+
+            /** Parse the next window, made of ranges of up to `bytes` bytes each */
+            void next(size_t bytes) override;
+
+            /** Return the start of the first row at or after `pos` in `window` */
+            size_t range_start(csv::string_view window, size_t pos) const noexcept;
+
+        private:
+            CSVFormat _format;
+            std::string _filename;
+            size_t mmap_pos = 0;
+            size_t n_threads;
+            size_t min_range_size;
+        };
     }
 }
 
@@ -6342,16 +6792,13 @@ namespace csv {
         CSVReader(const CSVReader&) = delete; // No copy constructor
         CSVReader(CSVReader&&) = default;     // Move constructor
         CSVReader& operator=(const CSVReader&) = delete; // No copy assignment
-        CSVReader& operator=(CSVReader&& other) = default;
-        ~CSVReader() {
-            if (this->read_csv_worker.joinable()) {
-                this->read_csv_worker.join();
-            }
-        }
+        CSVReader& operator=(CSVReader&& other);
+        ~CSVReader() { this->stop_reading(); }
 
         /** @name Retrieving CSV Rows */
         ///@{
         bool read_row(CSVRow &row);
+        bool read_batch(CSVBatch &batch, size_t max_rows);
         iterator begin();
         HEDLEY_CONST iterator end() const noexcept;
 
@@ -6408,14 +6855,15 @@ namespace csv {
         std::unique_ptr<internals::IBasicCSVParser> parser = nullptr;
 
         /** Queue of parsed CSV rows */
-        std::unique_ptr<RowCollection> records{new RowCollection(100)};
+        std::unique_ptr<RowCollection> records{new RowCollection()};
 
         size_t n_cols = 0;  /**< The number of columns in this CSV */
         size_t _n_rows = 0; /**< How many rows (minus header) have been read so far */
 
         /** @name Multi-Threaded File Reading Functions */
         ///@{
-        bool read_csv(size_t bytes = internals::ITERATION_CHUNK_SIZE);
+        static void read_csv(internals::IBasicCSVParser* parser, RowCollection* records,
+            size_t bytes = internals::ITERATION_CHUNK_SIZE);
         ///@}
 
         /**@}*/
@@ -6429,10 +6877,29 @@ namespace csv {
         std::thread read_csv_worker; /**< Worker thread for read_csv() */
         ///@}
 
-        /** Read initial chunk to get metadata */
+        /** Start reading and read the header */
         void initial_read() {
-            this->read_csv_worker = std::thread(&CSVReader::read_csv, this, internals::ITERATION_CHUNK_SIZE);
-            this->read_csv_worker.join();
+            // The worker only uses heap-allocated state, so that this reader can be moved
+            this->read_csv_worker = std::thread(&CSVReader::read_csv,
+                this->parser.get(), this->records.get(), internals::ITERATION_CHUNK_SIZE);
+
+            // The destructor does not run if a constructor throws
+            try {
+                this->trim_header();
+            }
+            catch (...) {
+                this->stop_reading();
+                throw;
+            }
+        }
+
+        /** Stop the worker thread and wait for it */
+        void stop_reading() {
+            if (this->records)
+                this->records->cancel();
+
+            if (this->read_csv_worker.joinable())
+                this->read_csv_worker.join();
         }
 
         void trim_header();
@@ -6971,31 +7438,313 @@ namespace csv {
         }
 
 #ifdef _MSC_VER
-#pragma region IBasicCVParser
+#pragma region StructuralScanner
+#endif
+        /** Return the index of the lowest set bit of a non-zero mask */
+        inline size_t trailing_zeros(uint64_t mask) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return index;
+#else
+            return (size_t)__builtin_ctzll(mask);
 #endif
-        CSV_INLINE IBasicCSVParser::IBasicCSVParser(
-            const CSVFormat& format,
-            const ColNamesPtr& col_names
-        ) : _col_names(col_names) {
-            if (format.no_quote) {
-                _parse_flags = internals::make_parse_flags(format.get_delim());
+        }
+
+#if defined(CSV_SSE2)
+        /** Set bit i of quote_mask if block[i] == chars[0] and bit i of other_mask
+         *  if block[i] is one of chars[1..3]
+         */
+        inline void classify_block_sse2(const char* block, const std::array<char, 4>& chars,
+            uint64_t& quote_mask, uint64_t& other_mask) noexcept {
+            const __m128i quote = _mm_set1_epi8(chars[0]);
+            const __m128i other0 = _mm_set1_epi8(chars[1]);
+            const __m128i other1 = _mm_set1_epi8(chars[2]);
+            const __m128i other2 = _mm_set1_epi8(chars[3]);
+
+            quote_mask = 0;
+            other_mask = 0;
+            for (size_t i = 0; i < StructuralScanner::BLOCK_SIZE; i += 16) {
+                const __m128i in = _mm_loadu_si128((const __m128i*)(block + i));
+                const __m128i others = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(in, other0), _mm_cmpeq_epi8(in, other1)),
+                    _mm_cmpeq_epi8(in, other2));
+                quote_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(in, quote)) << i;
+                other_mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(others) << i;
             }
-            else {
-                _parse_flags = internals::make_parse_flags(format.get_delim(), format.quote_char);
+        }
+#endif
+
+#if defined(CSV_AVX2_DISPATCH)
+        /** Same as classify_block_sse2() with 32 characters per compare */
+        __attribute__((target("avx2")))
+        inline void classify_block_avx2(const char* block, const std::array<char, 4>& chars,
+            uint64_t& quote_mask, uint64_t& other_mask) noexcept {
+            const __m256i quote = _mm256_set1_epi8(chars[0]);
+            const __m256i other0 = _mm256_set1_epi8(chars[1]);
+            const __m256i other1 = _mm256_set1_epi8(chars[2]);
+            const __m256i other2 = _mm256_set1_epi8(chars[3]);
+
+            quote_mask = 0;
+            other_mask = 0;
+            for (size_t i = 0; i < StructuralScanner::BLOCK_SIZE; i += 32) {
+                const __m256i in = _mm256_loadu_si256((const __m256i*)(block + i));
+                const __m256i others = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(in, other0), _mm256_cmpeq_epi8(in, other1)),
+                    _mm256_cmpeq_epi8(in, other2));
+                quote_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(in, quote)) << i;
+                other_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(others) << i;
             }
+        }
 
-            _ws_flags = internals::make_ws_flags(
-                format.trim_chars.data(), format.trim_chars.size()
-            );
+        /** Whether or not the running CPU supports AVX2 */
+        inline bool has_avx2() noexcept {
+            static const bool result = __builtin_cpu_supports("avx2");
+            return result;
         }
+#endif
 
-        CSV_INLINE void IBasicCSVParser::end_feed() {
-            using internals::ParseFlags;
+#if defined(CSV_NEON)
+        /** Pack the lanes of four compare results into one bit per character */
+        inline uint64_t movemask_neon(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) noexcept {
+            const uint8x16_t bits = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+            uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, bits), vandq_u8(m1, bits));
+            uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, bits), vandq_u8(m3, bits));
+            sum0 = vpaddq_u8(sum0, sum1);
+            sum0 = vpaddq_u8(sum0, sum0);
+            return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+        }
 
-            bool empty_last_field = this->data_ptr
-                && this->data_ptr->_data
-                && !this->data_ptr->data.empty()
-                && (parse_flag(this->data_ptr->data.back()) == ParseFlags::DELIMITER
+        /** Same as classify_block_sse2() for NEON */
+        inline void classify_block_neon(const char* block, const std::array<char, 4>& chars,
+            uint64_t& quote_mask, uint64_t& other_mask) noexcept {
+            const uint8x16_t quote = vdupq_n_u8((uint8_t)chars[0]);
+            const uint8x16_t other0 = vdupq_n_u8((uint8_t)chars[1]);
+            const uint8x16_t other1 = vdupq_n_u8((uint8_t)chars[2]);
+            const uint8x16_t other2 = vdupq_n_u8((uint8_t)chars[3]);
+
+            uint8x16_t quotes[4];
+            uint8x16_t others[4];
+            for (size_t i = 0; i < 4; i++) {
+                const uint8x16_t in = vld1q_u8((const uint8_t*)(block + 16 * i));
+                quotes[i] = vceqq_u8(in, quote);
+                others[i] = vorrq_u8(vorrq_u8(vceqq_u8(in, other0), vceqq_u8(in, other1)),
+                    vceqq_u8(in, other2));
+            }
+
+            quote_mask = movemask_neon(quotes[0], quotes[1], quotes[2], quotes[3]);
+            other_mask = movemask_neon(others[0], others[1], others[2], others[3]);
+        }
+#endif
+
+        /** Classify StructuralScanner::BLOCK_SIZE characters with the fastest available
+         *  instruction set
+         */
+        inline void classify_block(const char* block, const std::array<char, 4>& chars,
+            uint64_t& quote_mask, uint64_t& other_mask) noexcept {
+#if defined(CSV_AVX2_DISPATCH)
+            if (has_avx2()) {
+                classify_block_avx2(block, chars, quote_mask, other_mask);
+                return;
+            }
+#endif
+#if defined(CSV_SSE2)
+            classify_block_sse2(block, chars, quote_mask, other_mask);
+#elif defined(CSV_NEON)
+            classify_block_neon(block, chars, quote_mask, other_mask);
+#else
+            (void)block;
+            (void)chars;
+            quote_mask = 0;
+            other_mask = 0;
+#endif
+        }
+
+        CSV_INLINE StructuralScanner::StructuralScanner(const ParseFlagMap& parse_flags, bool use_simd) {
+            size_t n_quotes = 0;
+            size_t n_others = 0;
+            bool supported = true;
+
+            for (size_t i = 0; i < parse_flags.size(); i++) {
+                const char ch = (char)((int)i - 128);
+                switch (parse_flags[i]) {
+                case ParseFlags::NOT_SPECIAL:
+                    break;
+                case ParseFlags::QUOTE:
+                    if (n_quotes++ == 0) _chars[0] = ch;
+                    break;
+                case ParseFlags::DELIMITER:
+                case ParseFlags::NEWLINE:
+                    if (n_others < 3) _chars[1 + n_others] = ch;
+                    n_others++;
+                    break;
+                default:
+                    supported = false;
+                    break;
+                }
+            }
+
+            // Unused slots repeat a character, which does not change the masks
+            for (size_t i = n_others; i < 3; i++)
+                _chars[1 + i] = _chars[1];
+
+            this->_has_quote = n_quotes == 1;
+
+#if defined(CSV_SSE2) || defined(CSV_NEON)
+            this->_enabled = use_simd && supported && n_quotes <= 1 && n_others >= 1 && n_others <= 3;
+#else
+            (void)use_simd;
+            (void)supported;
+#endif
+        }
+
+        CSV_INLINE size_t StructuralScanner::find(csv::string_view in, size_t pos, bool quote_escape) noexcept {
+            for (size_t block = pos - pos % BLOCK_SIZE; block < in.size(); block += BLOCK_SIZE) {
+                if (block != this->_block)
+                    this->load(in, block);
+
+                uint64_t mask = quote_escape ? _quote_mask : _quote_mask | _other_mask;
+                if (pos > block)
+                    mask &= ~(uint64_t)0 << (pos - block);
+
+                if (mask != 0)
+                    return block + trailing_zeros(mask);
+            }
+
+            return in.size();
+        }
+
+        CSV_INLINE void StructuralScanner::load(csv::string_view in, size_t block) noexcept {
+            const size_t length = std::min(BLOCK_SIZE, in.size() - block);
+
+            if (length == BLOCK_SIZE) {
+                classify_block(in.data() + block, _chars, _quote_mask, _other_mask);
+            }
+            else {
+                // Copy the last partial block, so that the vector loads stay within the input
+                char tail[BLOCK_SIZE] = {};
+                std::memcpy(tail, in.data() + block, length);
+                classify_block(tail, _chars, _quote_mask, _other_mask);
+
+                const uint64_t valid = ((uint64_t)1 << length) - 1;
+                _quote_mask &= valid;
+                _other_mask &= valid;
+            }
+
+            if (!_has_quote)
+                _quote_mask = 0;
+
+            this->_block = block;
+        }
+#ifdef _MSC_VER
+#pragma endregion
+#endif
+
+#ifdef _MSC_VER
+#pragma region RowQueue
+#endif
+        template<typename Predicate>
+        void RowQueue::wait_until(Predicate ready) {
+            // A batch takes a while to parse or read, so the other side is either
+            // about to be done or far from it: yield a few times, then sleep
+            for (int i = 0; i < 16; i++) {
+                if (ready())
+                    return;
+
+                std::this_thread::yield();
+            }
+
+            std::unique_lock<std::mutex> guard{ this->_lock };
+            this->_n_waiting.fetch_add(1, std::memory_order_acq_rel);
+            this->_cond.wait(guard, ready);
+            this->_n_waiting.fetch_sub(1);
+        }
+
+        CSV_INLINE void RowQueue::notify() {
+            // Both this and wait_until() modify _n_waiting, so either this thread sees the
+            // waiting thread, or the waiting thread sees the change to the queue before it sleeps
+            if (this->_n_waiting.fetch_add(0, std::memory_order_acq_rel) > 0) {
+                std::lock_guard<std::mutex> guard{ this->_lock };
+                this->_cond.notify_all();
+            }
+        }
+
+        CSV_INLINE bool RowQueue::push(RowBatch&& batch) {
+            this->wait_until([&] { return this->cancelled() || this->_batches.try_push(batch); });
+            if (this->cancelled())
+                return false;
+
+            this->notify();
+            return true;
+        }
+
+        CSV_INLINE void RowQueue::close(std::exception_ptr error) {
+            this->_error = std::move(error);
+            this->_closed.store(true, std::memory_order_release);
+            this->notify();
+        }
+
+        CSV_INLINE void RowQueue::cancel() {
+            this->_cancelled.store(true, std::memory_order_release);
+            this->notify();
+        }
+
+        CSV_INLINE bool RowQueue::pop(CSVRow& row) {
+            while (this->_current_pos == this->_current.size()) {
+                bool popped = false;
+                this->wait_until([&] {
+                    // Load the flag first: batches pushed before close() are visible then
+                    const bool closed = this->_closed.load(std::memory_order_acquire);
+                    popped = this->_batches.try_pop(this->_current);
+                    return popped || closed;
+                });
+
+                if (!popped) {
+                    if (this->_error)
+                        std::rethrow_exception(std::exchange(this->_error, nullptr));
+
+                    return false;
+                }
+
+                // A producer may wait for the slot which was just emptied
+                this->_current_pos = 0;
+                this->notify();
+            }
+
+            row = std::move(this->_current[this->_current_pos++]);
+            return true;
+        }
+#ifdef _MSC_VER
+#pragma endregion
+#endif
+
+#ifdef _MSC_VER
+#pragma region IBasicCVParser
+#endif
+        CSV_INLINE IBasicCSVParser::IBasicCSVParser(
+            const CSVFormat& format,
+            const ColNamesPtr& col_names
+        ) : _col_names(col_names) {
+            if (format.no_quote) {
+                _parse_flags = internals::make_parse_flags(format.get_delim());
+            }
+            else {
+                _parse_flags = internals::make_parse_flags(format.get_delim(), format.quote_char);
+            }
+
+            _ws_flags = internals::make_ws_flags(
+                format.trim_chars.data(), format.trim_chars.size()
+            );
+            _scanner = StructuralScanner(_parse_flags);
+        }
+
+        CSV_INLINE void IBasicCSVParser::end_feed() {
+            using internals::ParseFlags;
+
+            bool empty_last_field = this->data_ptr
+                && this->data_ptr->_data
+                && !this->data_ptr->data.empty()
+                && (parse_flag(this->data_ptr->data.back()) == ParseFlags::DELIMITER
                     || parse_flag(this->data_ptr->data.back()) == ParseFlags::QUOTE);
 
             // Push field
@@ -7006,6 +7755,8 @@ namespace csv {
             // Push row
             if (this->current_row.size() > 0)
                 this->push_row();
+
+            this->flush_rows();
         }
 
         CSV_INLINE void IBasicCSVParser::parse_field() noexcept {
@@ -7022,8 +7773,13 @@ namespace csv {
             // Optimization: Since NOT_SPECIAL characters tend to occur in contiguous
             // sequences, use the loop below to avoid having to go through the outer
             // switch statement as much as possible
-            while (data_pos < in.size() && compound_parse_flag(in[data_pos]) == ParseFlags::NOT_SPECIAL)
-                data_pos++;
+            if (_scanner.enabled()) {
+                data_pos = _scanner.find(in, data_pos, quote_escape);
+            }
+            else {
+                while (data_pos < in.size() && compound_parse_flag(in[data_pos]) == ParseFlags::NOT_SPECIAL)
+                    data_pos++;
+            }
 
             field_length = data_pos - (field_start + current_row_start());
 
@@ -7067,6 +7823,7 @@ namespace csv {
             this->quote_escape = false;
             this->data_pos = 0;
             this->current_row_start() = 0;
+            this->_scanner.reset();
             this->trim_utf8_bom();
 
             auto& in = this->data_ptr->data;
@@ -7097,7 +7854,10 @@ namespace csv {
                     break;
 
                 case ParseFlags::QUOTE_ESCAPE_QUOTE:
-                    if (data_pos + 1 == in.size()) return this->current_row_start();
+                    if (data_pos + 1 == in.size()) {
+                        this->flush_rows();
+                        return this->current_row_start();
+                    }
                     else if (data_pos + 1 < in.size()) {
                         auto next_ch = parse_flag(in[data_pos + 1]);
                         if (next_ch >= ParseFlags::DELIMITER) {
@@ -7137,12 +7897,30 @@ namespace csv {
                 }
             }
 
+            this->flush_rows();
             return this->current_row_start();
         }
 
         CSV_INLINE void IBasicCSVParser::push_row() {
             current_row.row_length = fields->size() - current_row.fields_start;
-            this->_records->push_back(std::move(current_row));
+            if (this->_rows) {
+                this->_rows->push_back(std::move(current_row));
+                return;
+            }
+
+            this->_batch.push_back(std::move(current_row));
+            if (this->_batch.size() == ROW_BATCH_SIZE)
+                this->flush_rows();
+        }
+
+        CSV_INLINE void IBasicCSVParser::flush_rows() {
+            if (this->_batch.empty())
+                return;
+
+            // Rows are dropped if the reading thread has stopped reading
+            this->_records->push(std::move(this->_batch));
+            this->_batch = RowBatch();
+            this->_batch.reserve(ROW_BATCH_SIZE);
         }
 
         CSV_INLINE void IBasicCSVParser::reset_data_ptr() {
@@ -7200,6 +7978,208 @@ namespace csv {
 
             this->mmap_pos -= (length - remainder);
         }
+
+        CSV_INLINE size_t RangeParser::parse_range(const std::shared_ptr<void>& source, csv::string_view range, bool last) {
+            this->field_start = UNINITIALIZED_FIELD;
+            this->field_length = 0;
+            this->reset_data_ptr();
+            this->data_ptr->_data = source;
+            this->data_ptr->data = range;
+
+            this->current_row = CSVRow(this->data_ptr);
+            size_t remainder = this->parse();
+
+            if (last) {
+                this->_eof = true;
+                this->end_feed();
+                remainder = range.size();
+            }
+
+            return remainder;
+        }
+
+        CSV_INLINE size_t ParallelMmapParser::range_start(csv::string_view window, size_t pos) const noexcept {
+            using internals::ParseFlags;
+            auto ends_field = [&](size_t i) {
+                return i >= window.size() || parse_flag(window[i]) >= ParseFlags::DELIMITER;
+            };
+
+            // Speculate the quote state at pos from the first quote before the next
+            // newline: a quote which ends a field but does not start one closes a
+            // quoted field. Without such a quote, the next newline most likely ends a row.
+            bool quote_escape = false;
+            for (size_t i = pos; i < window.size(); i++) {
+                const ParseFlags flag = parse_flag(window[i]);
+                if (flag == ParseFlags::NEWLINE)
+                    break;
+
+                if (flag == ParseFlags::QUOTE) {
+                    const bool starts_field = i == 0 || ends_field(i - 1);
+                    quote_escape = ends_field(i + 1) && !starts_field;
+                    break;
+                }
+            }
+
+            // Find the first newline outside of quotes. Escaped quotes toggle the
+            // state twice.
+            size_t i = pos;
+            for (; i < window.size(); i++) {
+                const ParseFlags flag = parse_flag(window[i]);
+                if (flag == ParseFlags::QUOTE)
+                    quote_escape = !quote_escape;
+                else if (flag == ParseFlags::NEWLINE && !quote_escape)
+                    break;
+            }
+
+            // Like parse(), treat consecutive newlines as one
+            while (i < window.size() && parse_flag(window[i]) == ParseFlags::NEWLINE)
+                i++;
+
+            return i;
+        }
+
+        CSV_INLINE void ParallelMmapParser::next(size_t bytes = ITERATION_CHUNK_SIZE) {
+            // Create memory map
+            const size_t length = std::min(this->source_size - this->mmap_pos, bytes * this->n_threads);
+            const bool last_window = this->mmap_pos + length == this->source_size;
+            if (length == 0) {
+                this->_eof = true;
+                return;
+            }
+
+            std::error_code error;
+            auto mmap = std::make_shared<mio::basic_mmap_source<char>>(
+                mio::make_mmap_source(this->_filename, this->mmap_pos, length, error));
+            if (error) throw error;
+
+            const std::shared_ptr<void> source = mmap;
+            csv::string_view window(mmap->data(), mmap->length());
+
+            // A newline at the end may continue in the next window, so leave the
+            // last row to the next window
+            if (!last_window) {
+                while (!window.empty() && parse_flag(window.back()) == ParseFlags::NEWLINE)
+                    window.remove_suffix(1);
+            }
+
+            // Split into ranges at speculated row boundaries
+            const size_t n_ranges = std::max<size_t>(1,
+                std::min(this->n_threads, window.size() / this->min_range_size));
+            std::vector<size_t> starts = { 0 };
+            for (size_t i = 1; i < n_ranges; i++) {
+                starts.push_back(std::max(starts.back(), this->range_start(window, i * window.size() / n_ranges)));
+            }
+            starts.push_back(window.size());
+
+            // Rows are read as soon as range 0 pushes them, so detect the BOM first
+            const bool scan_utf8_bom = this->mmap_pos == 0;
+            if (scan_utf8_bom && window.size() >= 3 && window.substr(0, 3) == "\xEF\xBB\xBF")
+                this->_utf8_bom = true;
+
+            // Parse every range into its own batch, except for range 0, which
+            // is known to start at a row boundary and pushes its rows right away
+            std::vector<std::unique_ptr<RangeParser>> parsers;
+            std::vector<RowBatch> rows(n_ranges);
+            for (size_t i = 0; i < n_ranges; i++) {
+                parsers.emplace_back(new RangeParser(this->_format, this->_col_names, i == 0 && scan_utf8_bom));
+                if (i == 0)
+                    parsers[i]->set_output(*this->_records);
+                else
+                    parsers[i]->set_output(rows[i]);
+            }
+
+            // actual_starts[i] is the end of the complete rows of range i - 1, once known
+            constexpr size_t UNKNOWN = (size_t)-1;
+            std::vector<size_t> actual_starts(n_ranges + 1, UNKNOWN);
+            std::vector<bool> pushed(n_ranges, false);
+            actual_starts[0] = 0;
+            std::mutex lock;
+            std::condition_variable cond;
+
+            // The first exception of any range. Ranges which wait for a failed range
+            // give up instead, and the exception is rethrown once all have returned.
+            std::exception_ptr failure;
+            auto fail = [&](std::exception_ptr e) {
+                std::lock_guard<std::mutex> guard{ lock };
+                if (!failure)
+                    failure = std::move(e);
+                cond.notify_all();
+            };
+
+            auto parse_range = [&](size_t i) {
+                const bool last = last_window && i + 1 == n_ranges;
+                size_t end = starts[i] + parsers[i]->parse_range(
+                    source, window.substr(starts[i], starts[i + 1] - starts[i]), last);
+
+                std::unique_lock<std::mutex> guard{ lock };
+                cond.wait(guard, [&] { return actual_starts[i] != UNKNOWN || failure; });
+                if (failure)
+                    return;
+
+                const size_t actual_start = actual_starts[i];
+                guard.unlock();
+
+                if (actual_start != starts[i]) {
+                    // Misspeculated: parse again from the last complete row of range i - 1
+                    rows[i].clear();
+                    parsers[i].reset(new RangeParser(this->_format, this->_col_names, false));
+                    parsers[i]->set_output(rows[i]);
+                    end = actual_start + parsers[i]->parse_range(
+                        source, window.substr(actual_start, starts[i + 1] - actual_start), last);
+                }
+
+                guard.lock();
+                actual_starts[i + 1] = end;
+                cond.notify_all();
+                if (this->_format.get_row_order() == RowOrder::ORDERED) {
+                    cond.wait(guard, [&] { return i == 0 || pushed[i - 1] || failure; });
+                    if (failure)
+                        return;
+                }
+                guard.unlock();
+
+                if (!rows[i].empty())
+                    this->_records->push(std::move(rows[i]));
+
+                guard.lock();
+                pushed[i] = true;
+                cond.notify_all();
+            };
+
+            auto run_range = [&](size_t i) {
+                try {
+                    parse_range(i);
+                }
+                catch (...) {
+                    fail(std::current_exception());
+                }
+            };
+
+            // Every started worker is joined, even if starting the next one fails
+            std::vector<std::thread> workers;
+            try {
+                for (size_t i = 1; i < n_ranges; i++)
+                    workers.emplace_back(run_range, i);
+            }
+            catch (...) {
+                fail(std::current_exception());
+            }
+            run_range(0);
+            for (auto& worker : workers)
+                worker.join();
+
+            if (failure)
+                std::rethrow_exception(failure);
+
+            // No complete row was found, so nothing was pushed: retry with a larger window
+            if (actual_starts[n_ranges] == 0 && !last_window) {
+                this->next(2 * bytes);
+                return;
+            }
+
+            this->mmap_pos += actual_starts[n_ranges];
+            this->_eof = last_window;
+        }
 #ifdef _MSC_VER
 #pragma endregion
 #endif
@@ -7356,7 +8336,7 @@ namespace csv {
             // Parse the CSV
             auto trim_chars = format.get_trim_chars();
             std::stringstream source(head.data());
-            RowCollection rows;
+            RowBatch rows;
 
             StreamParser<std::stringstream> parser(source, format);
             parser.set_output(rows);
@@ -7374,7 +8354,7 @@ namespace csv {
 
             // Parse the CSV
             std::stringstream source(head.data());
-            RowCollection rows;
+            RowBatch rows;
 
             StreamParser<std::stringstream> parser(source, format);
             parser.set_output(rows);
@@ -7471,6 +8451,7 @@ namespace csv {
      *
      *  **Details:** Reads the first block of a CSV file synchronously to get information
      *               such as column names and delimiting character.
+     *               With CSVFormat::parse_threads(), every block is split across threads.
      *
      *  @param[in] filename  Path to CSV file
      *  @param[in] format    Format of the CSV file
@@ -7493,7 +8474,17 @@ namespace csv {
         if (!format.col_names.empty())
             this->set_col_names(format.col_names);
 
-        this->parser = std::unique_ptr<Parser>(new Parser(filename, format, this->col_names)); // For C++11
+        if (format.get_parse_threads() > 1) {
+            this->parser = std::unique_ptr<internals::ParallelMmapParser>(
+                new internals::ParallelMmapParser(filename, format, this->col_names));
+
+            // Ranges push their rows concurrently
+            if (format.get_row_order() == RowOrder::UNORDERED)
+                this->records.reset(new RowCollection(internals::ROW_QUEUE_CAPACITY, true));
+        }
+        else {
+            this->parser = std::unique_ptr<Parser>(new Parser(filename, format, this->col_names)); // For C++11
+        }
         this->initial_read();
     }
 
@@ -7530,14 +8521,27 @@ namespace csv {
         return CSV_NOT_FOUND;
     }
 
+    CSV_INLINE CSVReader& CSVReader::operator=(CSVReader&& other) {
+        // The worker of this reader still uses its parser and queue
+        this->stop_reading();
+
+        this->_format = std::move(other._format);
+        this->col_names = std::move(other.col_names);
+        this->parser = std::move(other.parser);
+        this->records = std::move(other.records);
+        this->n_cols = other.n_cols;
+        this->_n_rows = other._n_rows;
+        this->header_trimmed = other.header_trimmed;
+        this->read_csv_worker = std::move(other.read_csv_worker);
+        return *this;
+    }
+
     CSV_INLINE void CSVReader::trim_header() {
         if (!this->header_trimmed) {
-            for (int i = 0; i <= this->_format.header && !this->records->empty(); i++) {
+            CSVRow row;
+            for (int i = 0; i <= this->_format.header && this->records->pop(row); i++) {
                 if (i == this->_format.header && this->col_names->empty()) {
-                    this->set_col_names(this->records->pop_front());
-                }
-                else {
-                    this->records->pop_front();
+                    this->set_col_names(row);
                 }
             }
 
@@ -7555,31 +8559,31 @@ namespace csv {
     }
 
     /**
-     * Read a chunk of CSV data.
+     * Read CSV data until the end of the source or until the reader stops reading.
      *
-     * @note This method is meant to be run on its own thread. Only one `read_csv()` thread
-     *       should be active at a time.
+     * @note This method is meant to be run on its own thread. It waits whenever
+     *       `records` is full, so it parses ahead of read_row() by at most the
+     *       capacity of `records` plus one chunk.
      *
-     * @param[in] bytes Number of bytes to read.
+     * @param[in] bytes Number of bytes to read at a time.
      *
      * @see CSVReader::read_csv_worker
      * @see CSVReader::read_row()
      */
-    CSV_INLINE bool CSVReader::read_csv(size_t bytes) {
-        // Tell read_row() to listen for CSV rows
-        this->records->notify_all();
-
-        this->parser->set_output(*this->records);
-        this->parser->next(bytes);
-
-        if (!this->header_trimmed) {
-            this->trim_header();
+    CSV_INLINE void CSVReader::read_csv(internals::IBasicCSVParser* parser, RowCollection* records, size_t bytes) {
+        try {
+            parser->set_output(*records);
+            while (!parser->eof() && !records->cancelled())
+                parser->next(bytes);
+        }
+        catch (...) {
+            // read_row() rethrows it after the rows parsed so far
+            records->close(std::current_exception());
+            return;
         }
 
         // Tell read_row() to stop waiting
-        this->records->kill_all();
-
-        return true;
+        records->close();
     }
 
     /**
@@ -7597,35 +8601,18 @@ namespace csv {
      *
      */
     CSV_INLINE bool CSVReader::read_row(CSVRow &row) {
-        while (true) {
-            if (this->records->empty()) {
-                if (this->records->is_waitable())
-                    // Reading thread is currently active => wait for it to populate records
-                    this->records->wait();
-                else if (this->parser->eof())
-                    // End of file and no more records
-                    return false;
-                else {
-                    // Reading thread is not active => start another one
-                    if (this->read_csv_worker.joinable())
-                        this->read_csv_worker.join();
-
-                    this->read_csv_worker = std::thread(&CSVReader::read_csv, this, internals::ITERATION_CHUNK_SIZE);
-                }
-            }
-            else if (this->records->front().size() != this->n_cols &&
+        // Waits for the reading thread, and returns false at the end of the source
+        while (this->records->pop(row)) {
+            if (row.size() != this->n_cols &&
                 this->_format.variable_column_policy != VariableColumnPolicy::KEEP) {
-                auto errored_row = this->records->pop_front();
-
                 if (this->_format.variable_column_policy == VariableColumnPolicy::THROW) {
-                    if (errored_row.size() < this->n_cols)
-                        throw std::runtime_error("Line too short " + internals::format_row(errored_row));
+                    if (row.size() < this->n_cols)
+                        throw std::runtime_error("Line too short " + internals::format_row(row));
 
-                    throw std::runtime_error("Line too long " + internals::format_row(errored_row));
+                    throw std::runtime_error("Line too long " + internals::format_row(row));
                 }
             }
             else {
-                row = this->records->pop_front();
                 this->_n_rows++;
                 return true;
             }
@@ -7633,6 +8620,51 @@ namespace csv {
 
         return false;
     }
+
+    /**
+     * Retrieve up to `max_rows` rows column by column, returning true if any rows were read.
+     *
+     * @par Performance Notes
+     *  - Field values are copied once into the buffers of `batch`, which are reused
+     *    when `batch` is passed again
+     *  - Columns with a type set by CSVFormat::column_types() are converted straight from
+     *    the parsed text, so their values are neither copied as text nor type-checked
+     *    again like CSVField::get()
+     *  - Rows are checked against the number of columns like in read_row(). If the CSV
+     *    has no header, the first row of each batch determines the number of columns.
+     *    Shorter rows are padded with empty values and extra fields are dropped.
+     *
+     * @throws std::runtime_error if a column type names an unknown column or a value
+     *         can't be converted to the type of its column. `batch` then holds the rows
+     *         before the one with that value.
+     *
+     * @param[out] batch    The batch where the rows will be stored
+     * @param[in]  max_rows Maximum number of rows to read
+     * @see CSVBatch
+     */
+    CSV_INLINE bool CSVReader::read_batch(CSVBatch &batch, size_t max_rows) {
+        // Resolve CSVFormat::column_types() by column name
+        std::vector<ColumnType> types(this->n_cols, ColumnType::STRING);
+        for (auto& type : this->_format.get_column_types()) {
+            auto col_pos = this->col_names->index_of(type.first);
+            if (col_pos == CSV_NOT_FOUND)
+                throw std::runtime_error("Can't find a column named " + type.first);
+
+            types[col_pos] = type.second;
+        }
+
+        batch.clear(this->col_names, types);
+
+        CSVRow row;
+        while (batch.n_rows() < max_rows && this->read_row(row)) {
+            if (batch.n_rows() == 0 && this->n_cols == 0)
+                batch.clear(this->col_names, std::vector<ColumnType>(row.size(), ColumnType::STRING));
+
+            batch.append(row);
+        }
+
+        return batch.n_rows() > 0;
+    }
 }
 
 /** @file
@@ -7643,16 +8675,11 @@ namespace csv {
 namespace csv {
     /** Return an iterator to the first row in the reader */
     CSV_INLINE CSVReader::iterator CSVReader::begin() {
-        if (this->records->empty()) {
-            this->read_csv_worker = std::thread(&CSVReader::read_csv, this, internals::ITERATION_CHUNK_SIZE);
-            this->read_csv_worker.join();
-
-            // Still empty => return end iterator
-            if (this->records->empty()) return this->end();
-        }
+        CSVRow row;
+        if (!this->records->pop(row)) return this->end();
 
         this->_n_rows++;
-        CSVReader::iterator ret(this, this->records->pop_front());
+        CSVReader::iterator ret(this, std::move(row));
         return ret;
     }
 
@@ -7974,6 +9001,275 @@ namespace csv {
 #endif
 }
 
+/** @file
+ *  Implements CSVBatch
+ */
+
+#include <cerrno>
+#include <cstdlib>
+
+namespace csv {
+    namespace internals {
+        CSV_INLINE bool parse_int64(csv::string_view in, int64_t& out) noexcept {
+            size_t i = 0;
+            const bool negative = !in.empty() && in[0] == '-';
+            if (!in.empty() && (in[0] == '-' || in[0] == '+'))
+                i++;
+
+            if (i == in.size())
+                return false;
+
+            // Skip leading zeros, so that up to 19 significant digits fit in an unsigned
+            // 64-bit integer without checking for overflow after every digit
+            while (i + 1 < in.size() && in[i] == '0')
+                i++;
+
+            if (in.size() - i > 19)
+                return false;
+
+            uint64_t value = 0;
+            for (; i < in.size(); i++) {
+                const unsigned digit = (unsigned)(in[i] - '0');
+                if (digit > 9)
+                    return false;
+
+                value = value * 10 + digit;
+            }
+
+            if (value > (uint64_t)INT64_MAX + negative)
+                return false;
+
+            out = negative ? -(int64_t)(value - 1) - 1 : (int64_t)value;
+            return true;
+        }
+
+        CSV_INLINE bool parse_double(csv::string_view in, double& out) noexcept {
+            // Unlike strtod(), from_chars() does not allow a leading plus sign
+            if (!in.empty() && in[0] == '+') {
+                in.remove_prefix(1);
+                if (!in.empty() && in[0] == '-')
+                    return false;
+            }
+
+            if (in.empty())
+                return false;
+
+#if defined(__cpp_lib_to_chars)
+            const auto result = std::from_chars(in.data(), in.data() + in.size(), out);
+            return result.ec == std::errc() && result.ptr == in.data() + in.size();
+#else
+            // Unlike from_chars(), strtod() needs a terminated string and skips whitespace
+            char buffer[64];
+            if (in.size() >= sizeof(buffer) || std::isspace((unsigned char)in[0]))
+                return false;
+
+            std::memcpy(buffer, in.data(), in.size());
+            buffer[in.size()] = '\0';
+
+            char* end = nullptr;
+            errno = 0;
+            out = std::strtod(buffer, &end);
+            return end == buffer + in.size() && errno != ERANGE;
+#endif
+        }
+
+        CSV_INLINE bool parse_date(csv::string_view in, int32_t& out) noexcept {
+            if (in.size() != 10 || in[4] != '-' || in[7] != '-')
+                return false;
+
+            int parts[3] = { 0, 0, 0 };
+            const size_t starts[3] = { 0, 5, 8 }, lengths[3] = { 4, 2, 2 };
+            for (size_t part = 0; part < 3; part++) {
+                for (size_t i = starts[part]; i < starts[part] + lengths[part]; i++) {
+                    const unsigned digit = (unsigned)(in[i] - '0');
+                    if (digit > 9)
+                        return false;
+
+                    parts[part] = parts[part] * 10 + (int)digit;
+                }
+            }
+
+            const int year = parts[0], month = parts[1], day = parts[2];
+            const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+            const int month_days[12] = { 31, leap ? 29 : 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+            if (month < 1 || month > 12 || day < 1 || day > month_days[month - 1])
+                return false;
+
+            // Days from civil date, from Howard Hinnant's date algorithms
+            const int y = month <= 2 ? year - 1 : year;
+            const int era = (y >= 0 ? y : y - 399) / 400;
+            const int year_of_era = y - era * 400;
+            const int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            const int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+            out = era * 146097 + day_of_era - 719468;
+            return true;
+        }
+    }
+
+    CSV_INLINE std::vector<std::string> CSVBatch::get_col_names() const {
+        if (this->col_names) {
+            return this->col_names->get_col_names();
+        }
+
+        return std::vector<std::string>();
+    }
+
+    CSV_INLINE const CSVColumn& CSVBatch::operator[](size_t n) const {
+        if (n >= this->n_cols())
+            throw std::runtime_error("Index out of bounds.");
+
+        return this->columns[n];
+    }
+
+    CSV_INLINE const CSVColumn& CSVBatch::operator[](const std::string& col_name) const {
+        auto col_pos = this->col_names ? this->col_names->index_of(col_name) : CSV_NOT_FOUND;
+        if (col_pos > -1) {
+            return this->operator[](col_pos);
+        }
+
+        throw std::runtime_error("Can't find a column named " + col_name);
+    }
+
+    CSV_INLINE void CSVBatch::clear(const internals::ColNamesPtr& _col_names, const std::vector<ColumnType>& types) {
+        this->col_names = _col_names;
+        this->columns.resize(types.size());
+        for (size_t i = 0; i < types.size(); i++) {
+            CSVColumn& column = this->columns[i];
+            column.type = types[i];
+            column.offsets.resize(1);
+            column.data.clear();
+            column.int64s.clear();
+            column.doubles.clear();
+            column.dates.clear();
+            column.valid.clear();
+        }
+
+        this->_n_rows = 0;
+    }
+
+    CSV_INLINE void CSVBatch::append(const CSVRow& row) {
+        using internals::ParseFlags;
+
+        const auto& raw = *row.data;
+        const char* row_data = raw.data.data() + row.data_start;
+        const size_t n_fields = std::min(row.size(), this->n_cols());
+        for (size_t i = 0; i < n_fields; i++) {
+            const auto& field = raw.fields[row.fields_start + i];
+            const char* value = row_data + field.start;
+            CSVColumn& column = this->columns[i];
+
+            if (column.type != ColumnType::STRING) {
+                // Convert straight from the parsed text, which is not copied
+                const csv::string_view text(value, field.length);
+                const bool valid = !text.empty();
+                int64_t int64 = 0;
+                double number = 0;
+                int32_t date = 0;
+                bool converted = !valid;
+                switch (column.type) {
+                case ColumnType::INT64:
+                    converted = converted || internals::parse_int64(text, int64);
+                    break;
+                case ColumnType::DOUBLE:
+                    converted = converted || internals::parse_double(text, number);
+                    break;
+                default:
+                    converted = converted || internals::parse_date(text, date);
+                    break;
+                }
+
+                if (!converted) {
+                    // Keep every column at the same number of rows
+                    this->drop_fields(i);
+                    throw std::runtime_error("Can't convert \"" + std::string(text) +
+                        "\" in column " + std::to_string(i) + " to the column type.");
+                }
+
+                switch (column.type) {
+                case ColumnType::INT64:
+                    column.int64s.push_back(int64);
+                    break;
+                case ColumnType::DOUBLE:
+                    column.doubles.push_back(number);
+                    break;
+                default:
+                    column.dates.push_back(date);
+                    break;
+                }
+
+                column.valid.push_back(valid);
+                continue;
+            }
+
+            std::string& data = column.data;
+            if (!field.has_double_quote) {
+                data.append(value, field.length);
+            }
+            else {
+                // Unescape like CSVRow::get_field(), without caching the value
+                bool prev_ch_quote = false;
+                for (size_t j = 0; j < field.length; j++) {
+                    if (raw.parse_flags[value[j] + 128] == ParseFlags::QUOTE) {
+                        prev_ch_quote = !prev_ch_quote;
+                        if (!prev_ch_quote)
+                            continue;
+                    }
+
+                    data += value[j];
+                }
+            }
+
+            column.offsets.push_back(data.size());
+        }
+
+        // Pad short rows
+        for (size_t i = n_fields; i < this->n_cols(); i++) {
+            CSVColumn& column = this->columns[i];
+            switch (column.type) {
+            case ColumnType::STRING:
+                column.offsets.push_back(column.data.size());
+                continue;
+            case ColumnType::INT64:
+                column.int64s.push_back(0);
+                break;
+            case ColumnType::DOUBLE:
+                column.doubles.push_back(0);
+                break;
+            default:
+                column.dates.push_back(0);
+                break;
+            }
+
+            column.valid.push_back(false);
+        }
+
+        this->_n_rows++;
+    }
+
+    CSV_INLINE void CSVBatch::drop_fields(size_t n_fields) {
+        for (size_t i = 0; i < n_fields; i++) {
+            CSVColumn& column = this->columns[i];
+            switch (column.type) {
+            case ColumnType::STRING:
+                column.offsets.pop_back();
+                column.data.resize(column.offsets.back());
+                continue;
+            case ColumnType::INT64:
+                column.int64s.pop_back();
+                break;
+            case ColumnType::DOUBLE:
+                column.doubles.pop_back();
+                break;
+            default:
+                column.dates.pop_back();
+                break;
+            }
+
+            column.valid.pop_back();
+        }
+    }
+}
+
 /** @file
  *  Implements JSON serialization abilities
  */
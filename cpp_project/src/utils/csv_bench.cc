@@ -0,0 +1,191 @@
+// Benchmarks of the CSV parser in csv.hpp on generated in-memory tables.
+//
+// The argument is the length of every field. BM_Parse has unquoted fields,
+// BM_ParseQuoted quotes every field and puts a delimiter into each, so the
+// parser spends the time in quote-escaped mode. BM_ScanRows and BM_ScanBatches
+// read every value of the unquoted table with CSVReader::read_row and
+// CSVReader::read_batch. BM_SumRows and BM_SumBatches add up a table of
+// decimal numbers with CSVField::get<double> and with DOUBLE columns of
+// CSVReader::read_batch, without an argument. BM_ParseFile reads a file of 16
+// byte fields with the number of threads given by the argument. The parser
+// runs on worker threads, so the benchmarks measure wall time.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "utils/csv.hpp"
+
+namespace csv {
+namespace {
+
+// Size of the generated in-memory tables, below internals::ITERATION_CHUNK_SIZE
+// so that every table is parsed in one chunk.
+constexpr size_t kTableBytes = 8 << 20;
+constexpr size_t kColumns = 8;
+
+// Rows per CSVReader::read_batch call.
+constexpr size_t kBatchRows = 4096;
+
+// Size of the file read by BM_ParseFile, large enough for several chunks.
+constexpr size_t kFileBytes = 64 << 20;
+
+std::string MakeTable(size_t field_length, bool quoted,
+                      size_t bytes = kTableBytes) {
+  std::string field(field_length, 'x');
+  if (quoted) {
+    field[field_length / 2] = ',';
+    field = "\"" + field + "\"";
+  }
+  std::string text;
+  while (text.size() < bytes) {
+    for (size_t j = 0; j < kColumns; ++j) {
+      text += field;
+      text += j + 1 < kColumns ? ',' : '\n';
+    }
+  }
+  return text;
+}
+
+// Table with a header of column names "c0", "c1", ... and random decimal
+// numbers with up to 6 digits after the point.
+std::string MakeNumberTable() {
+  std::default_random_engine rng(0);
+  std::uniform_real_distribution<double> number(-1e6, 1e6);
+  std::string text;
+  for (size_t j = 0; j < kColumns; ++j) {
+    text += "c" + std::to_string(j) + (j + 1 < kColumns ? "," : "\n");
+  }
+  while (text.size() < kTableBytes) {
+    for (size_t j = 0; j < kColumns; ++j) {
+      text += std::to_string(number(rng));
+      text += j + 1 < kColumns ? ',' : '\n';
+    }
+  }
+  return text;
+}
+
+void Parse(benchmark::State &state, bool quoted) {
+  const std::string text = MakeTable(state.range(0), quoted);
+  for (auto _ : state) {
+    size_t rows = 0;
+    for (CSVRow &row : parse_no_header(text)) {
+      rows += row.size();
+    }
+    benchmark::DoNotOptimize(rows);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_Parse(benchmark::State &state) { Parse(state, false); }
+BENCHMARK(BM_Parse)->Arg(4)->Arg(16)->Arg(64)->Arg(256)->UseRealTime();
+
+void BM_ParseQuoted(benchmark::State &state) { Parse(state, true); }
+BENCHMARK(BM_ParseQuoted)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(256)
+    ->UseRealTime();
+
+void BM_ScanRows(benchmark::State &state) {
+  const std::string text = MakeTable(state.range(0), false);
+  for (auto _ : state) {
+    size_t bytes = 0;
+    for (CSVRow &row : parse_no_header(text)) {
+      for (size_t j = 0; j < row.size(); ++j) {
+        bytes += row[j].get<csv::string_view>().size();
+      }
+    }
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ScanRows)->Arg(4)->Arg(16)->Arg(64)->UseRealTime();
+
+void BM_ScanBatches(benchmark::State &state) {
+  const std::string text = MakeTable(state.range(0), false);
+  CSVBatch batch;
+  for (auto _ : state) {
+    size_t bytes = 0;
+    CSVReader reader = parse_no_header(text);
+    while (reader.read_batch(batch, kBatchRows)) {
+      for (size_t j = 0; j < batch.n_cols(); ++j) {
+        const CSVColumn &column = batch[j];
+        for (size_t i = 0; i < column.size(); ++i) {
+          bytes += column[i].size();
+        }
+      }
+    }
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ScanBatches)->Arg(4)->Arg(16)->Arg(64)->UseRealTime();
+
+void BM_SumRows(benchmark::State &state) {
+  const std::string text = MakeNumberTable();
+  for (auto _ : state) {
+    double sum = 0;
+    for (CSVRow &row : parse(text)) {
+      for (size_t j = 0; j < row.size(); ++j) {
+        sum += row[j].get<double>();
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_SumRows)->UseRealTime();
+
+void BM_SumBatches(benchmark::State &state) {
+  const std::string text = MakeNumberTable();
+  std::unordered_map<std::string, ColumnType> types;
+  for (size_t j = 0; j < kColumns; ++j) {
+    types["c" + std::to_string(j)] = ColumnType::DOUBLE;
+  }
+  const CSVFormat format = CSVFormat().column_types(types);
+
+  CSVBatch batch;
+  for (auto _ : state) {
+    double sum = 0;
+    CSVReader reader = parse(text, format);
+    while (reader.read_batch(batch, kBatchRows)) {
+      for (size_t j = 0; j < batch.n_cols(); ++j) {
+        for (double value : batch[j].doubles) {
+          sum += value;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_SumBatches)->UseRealTime();
+
+void BM_ParseFile(benchmark::State &state) {
+  const std::string path = "csv_bench_table.csv";
+  const std::string text = MakeTable(16, false, kFileBytes);
+  std::ofstream(path, std::ios::binary) << text;
+
+  const CSVFormat format =
+      CSVFormat().no_header().parse_threads(state.range(0));
+  for (auto _ : state) {
+    size_t rows = 0;
+    for (CSVRow &row : CSVReader(path, format)) {
+      rows += row.size();
+    }
+    benchmark::DoNotOptimize(rows);
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  std::remove(path.c_str());
+}
+BENCHMARK(BM_ParseFile)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+}  // namespace
+}  // namespace csv
@@ -0,0 +1,531 @@
+#include "csv.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace csv {
+namespace {
+
+const int kSeed = 0;
+
+// Whether the structural scanner is compiled for this target.
+#if defined(CSV_SSE2) || defined(CSV_NEON)
+const bool kHasScanner = true;
+#else
+const bool kHasScanner = false;
+#endif
+
+using internals::BoundedQueue;
+using internals::ParallelMmapParser;
+using internals::ParseFlagMap;
+using internals::ParseFlags;
+using internals::RowBatch;
+using internals::StructuralScanner;
+
+// The loop that StructuralScanner::find replaces.
+size_t FindScalar(const ParseFlagMap &flags, csv::string_view in, size_t pos,
+                  bool quote_escape) {
+  while (pos < in.size() &&
+         internals::quote_escape_flag(flags[in[pos] + 128], quote_escape) ==
+             ParseFlags::NOT_SPECIAL) {
+    pos++;
+  }
+  return pos;
+}
+
+// Random text that mostly consists of one special character, so that both
+// short and long runs of NOT_SPECIAL characters occur.
+std::string RandomText(std::default_random_engine &rng, size_t size,
+                       const std::string &alphabet) {
+  std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+  std::string text(size, ' ');
+  for (char &ch : text) {
+    ch = alphabet[pick(rng)];
+  }
+  return text;
+}
+
+// Random field that may contain quotes, delimiters and newlines.
+std::string RandomField(std::default_random_engine &rng) {
+  std::uniform_int_distribution<size_t> size(0, 150);
+  return RandomText(rng, size(rng), "abcdefghij0123456789 ,,\"\n");
+}
+
+// Writes `field` quoted if it contains special characters, with quotes
+// escaped as two quotes.
+std::string Quote(const std::string &field) {
+  if (field.find_first_of(",\"\r\n") == std::string::npos) {
+    return field;
+  }
+  std::string quoted = "\"";
+  for (char ch : field) {
+    quoted += ch;
+    if (ch == '"') {
+      quoted += '"';
+    }
+  }
+  return quoted + "\"";
+}
+
+using Table = std::vector<std::vector<std::string>>;
+
+Table RandomTable(std::default_random_engine &rng, size_t n_rows,
+                  size_t n_cols) {
+  Table table(n_rows);
+  for (auto &row : table) {
+    for (size_t j = 0; j < n_cols; ++j) {
+      row.push_back(RandomField(rng));
+    }
+  }
+  return table;
+}
+
+std::string ToCsv(const Table &table) {
+  std::string text;
+  for (const auto &row : table) {
+    for (size_t j = 0; j < row.size(); ++j) {
+      text += Quote(row[j]) + (j + 1 < row.size() ? "," : "\r\n");
+    }
+  }
+  return text;
+}
+
+std::vector<std::string> Fields(CSVRow &row) {
+  std::vector<std::string> fields;
+  for (size_t j = 0; j < row.size(); ++j) {
+    fields.push_back(row[j].get<std::string>());
+  }
+  return fields;
+}
+
+// Rows of a one column CSV with the fields "0" to "n_rows - 1".
+RowBatch NumberRows(size_t n_rows) {
+  std::stringstream text;
+  for (size_t i = 0; i < n_rows; ++i) {
+    text << i << "\n";
+  }
+  RowBatch rows;
+  internals::StreamParser<std::stringstream> parser(text, CSVFormat());
+  parser.set_output(rows);
+  parser.next();
+  return rows;
+}
+
+std::string WriteFile(const std::string &name, const std::string &text) {
+  const std::string path = testing::TempDir() + "/" + name;
+  std::ofstream(path, std::ios::binary) << text;
+  return path;
+}
+
+TEST(StructuralScannerTest, FindMatchesScalarLoop) {
+  if (!kHasScanner) {
+    GTEST_SKIP() << "No structural scanner for this target.";
+  }
+  std::default_random_engine rng(kSeed);
+  const ParseFlagMap flags = internals::make_parse_flags(',', '"');
+  StructuralScanner scanner(flags);
+  ASSERT_TRUE(scanner.enabled());
+
+  const std::string long_runs(20, 'a');
+  for (const std::string &alphabet :
+       {std::string("ab,\"\r\n"), long_runs + ",", long_runs + "\"",
+        std::string("\x80\xff\x7f,")}) {
+    for (size_t size = 0; size <= 3 * StructuralScanner::BLOCK_SIZE + 1;
+         ++size) {
+      const std::string text = RandomText(rng, size, alphabet);
+      scanner.reset();
+      for (bool quote_escape : {false, true}) {
+        for (size_t pos = 0; pos <= size; ++pos) {
+          ASSERT_EQ(scanner.find(text, pos, quote_escape),
+                    FindScalar(flags, text, pos, quote_escape))
+              << size << " " << pos << " " << quote_escape;
+        }
+      }
+    }
+  }
+}
+
+TEST(StructuralScannerTest, IsDisabledForUnsupportedFlags) {
+  EXPECT_EQ(StructuralScanner(internals::make_parse_flags(';')).enabled(),
+            kHasScanner);
+  const ParseFlagMap flags = internals::make_parse_flags(',', '"');
+  EXPECT_FALSE(StructuralScanner(flags, false).enabled());
+
+  ParseFlagMap many_delimiters = flags;
+  for (char ch : {';', '|', '\t'}) {
+    many_delimiters[ch + 128] = ParseFlags::DELIMITER;
+  }
+  EXPECT_FALSE(StructuralScanner(many_delimiters).enabled());
+}
+
+TEST(CsvParserTest, ParsesFieldsAcrossBlocks) {
+  std::default_random_engine rng(kSeed);
+  const Table table = RandomTable(rng, 200, 5);
+
+  Table parsed;
+  for (CSVRow &row : parse("a,b,c,d,e\r\n" + ToCsv(table))) {
+    parsed.push_back(Fields(row));
+  }
+  EXPECT_EQ(parsed, table);
+}
+
+TEST(ParallelMmapParserTest, RangeStartSkipsQuotedNewlines) {
+  const std::string window = "a,\"x\ny\",b\r\nc,d\n";
+  ParallelMmapParser parser(WriteFile("range_start.csv", window),
+                            CSVFormat().parse_threads(2));
+  const size_t second_row = window.find('c');
+
+  EXPECT_EQ(parser.range_start(window, 0), second_row);
+  // Inside the quoted field, the quote after "y" closes it.
+  EXPECT_EQ(parser.range_start(window, window.find('y')), second_row);
+  // Between CR and LF.
+  EXPECT_EQ(parser.range_start(window, second_row - 1), second_row);
+  EXPECT_EQ(parser.range_start(window, second_row + 1), window.size());
+}
+
+// Quoted fields with newlines make some of the speculated range starts wrong,
+// which must not change the rows.
+TEST(ParallelMmapParserTest, MatchesTableForAllSplits) {
+  std::default_random_engine rng(kSeed);
+  const Table table = RandomTable(rng, 300, 4);
+  const std::string path = WriteFile("parallel.csv", ToCsv(table));
+
+  Table sorted_table = table;
+  std::sort(sorted_table.begin(), sorted_table.end());
+
+  for (RowOrder order : {RowOrder::ORDERED, RowOrder::UNORDERED}) {
+    for (size_t n_threads : {2, 3, 8}) {
+      for (size_t bytes : {256, 4096, 1 << 20}) {
+        ParallelMmapParser parser(
+            path, CSVFormat().parse_threads(n_threads, order), nullptr, 16);
+        // Large enough for all rows, since nothing reads them concurrently.
+        RowCollection rows(1 << 13, order == RowOrder::UNORDERED);
+        parser.set_output(rows);
+        while (!parser.eof()) {
+          parser.next(bytes);
+        }
+        rows.close();
+
+        Table parsed;
+        CSVRow row;
+        while (rows.pop(row)) {
+          parsed.push_back(Fields(row));
+        }
+        ASSERT_EQ(parsed.size(), table.size()) << n_threads << " " << bytes;
+        if (order == RowOrder::UNORDERED) {
+          std::sort(parsed.begin(), parsed.end());
+          EXPECT_EQ(parsed, sorted_table) << n_threads << " " << bytes;
+        } else {
+          EXPECT_EQ(parsed, table) << n_threads << " " << bytes;
+        }
+      }
+    }
+  }
+}
+
+TEST(BoundedQueueTest, IsFirstInFirstOut) {
+  BoundedQueue<int> queue(3);
+  ASSERT_EQ(queue.capacity(), 4u);
+
+  int item = 0;
+  EXPECT_FALSE(queue.try_pop(item));
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      item = i;
+      EXPECT_TRUE(queue.try_push(item));
+    }
+    EXPECT_FALSE(queue.try_push(item));
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(queue.try_pop(item));
+      EXPECT_EQ(item, i);
+    }
+    EXPECT_FALSE(queue.try_pop(item));
+  }
+}
+
+// Every producer pushes increasing numbers, which the consumer must receive
+// in order for each producer.
+TEST(BoundedQueueTest, PassesItemsFromEveryProducer) {
+  constexpr size_t kItems = 20000;
+  for (size_t n_producers : {1, 4}) {
+    BoundedQueue<std::pair<size_t, size_t>> queue(8, n_producers > 1);
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < n_producers; ++p) {
+      producers.emplace_back([&queue, p] {
+        for (size_t i = 0; i < kItems; ++i) {
+          std::pair<size_t, size_t> item(p, i);
+          while (!queue.try_push(item)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    std::vector<size_t> next(n_producers, 0);
+    std::pair<size_t, size_t> item;
+    for (size_t n = 0; n < n_producers * kItems;) {
+      if (!queue.try_pop(item)) {
+        std::this_thread::yield();
+        continue;
+      }
+      ASSERT_EQ(item.second, next[item.first]++) << n_producers;
+      ++n;
+    }
+    for (auto &producer : producers) {
+      producer.join();
+    }
+    EXPECT_FALSE(queue.try_pop(item));
+  }
+}
+
+TEST(RowQueueTest, PassesRowsUntilClosed) {
+  const RowBatch rows = NumberRows(1000);
+  RowCollection queue(2);
+  std::thread producer([&] {
+    for (size_t i = 0; i < rows.size(); i += 7) {
+      const size_t end = std::min(i + 7, rows.size());
+      ASSERT_TRUE(queue.push(RowBatch(rows.begin() + i, rows.begin() + end)));
+    }
+    queue.close();
+  });
+
+  CSVRow row;
+  size_t n_rows = 0;
+  while (queue.pop(row)) {
+    ASSERT_EQ(row[0].get<size_t>(), n_rows);
+    ++n_rows;
+  }
+  producer.join();
+  EXPECT_EQ(n_rows, rows.size());
+  EXPECT_FALSE(queue.pop(row));
+}
+
+TEST(RowQueueTest, RethrowsErrorAfterRows) {
+  RowCollection queue(2);
+  ASSERT_TRUE(queue.push(NumberRows(3)));
+  queue.close(std::make_exception_ptr(std::runtime_error("parse failed")));
+
+  CSVRow row;
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_TRUE(queue.pop(row));
+  }
+  EXPECT_THROW(queue.pop(row), std::runtime_error);
+  EXPECT_FALSE(queue.pop(row));
+}
+
+TEST(RowQueueTest, CancelReleasesBlockedProducer) {
+  RowCollection queue(1);
+  ASSERT_TRUE(queue.push(NumberRows(3)));
+  // Blocks, since the queue is full and nothing reads it.
+  std::thread producer([&] { EXPECT_FALSE(queue.push(NumberRows(3))); });
+  queue.cancel();
+  producer.join();
+  EXPECT_FALSE(queue.push(NumberRows(3)));
+}
+
+// A reader which stops early must not wait for the rest of the file.
+TEST(CsvReaderTest, StopsParsingWhenDestroyed) {
+  std::default_random_engine rng(kSeed);
+  const std::string path =
+      WriteFile("stop.csv", ToCsv(RandomTable(rng, 20000, 3)));
+
+  CSVReader reader(path, CSVFormat().no_header());
+  CSVRow row;
+  ASSERT_TRUE(reader.read_row(row));
+  CSVReader other = std::move(reader);
+  EXPECT_TRUE(other.read_row(row));
+  other = CSVReader(path, CSVFormat().no_header());
+  EXPECT_TRUE(other.read_row(row));
+}
+
+TEST(CsvReaderTest, ReadBatchStoresColumns) {
+  std::default_random_engine rng(kSeed);
+  const Table table = RandomTable(rng, 100, 3);
+  const std::string path =
+      WriteFile("batch.csv", "a,b,c\r\n" + ToCsv(table));
+
+  CSVReader reader(path);
+  CSVBatch batch;
+  Table parsed;
+  while (reader.read_batch(batch, 7)) {
+    ASSERT_LE(batch.n_rows(), 7u);
+    ASSERT_EQ(batch.n_cols(), 3u);
+    EXPECT_EQ(batch.get_col_names(), std::vector<std::string>({"a", "b", "c"}));
+    EXPECT_EQ(&batch["c"], &batch[2]);
+    for (size_t i = 0; i < batch.n_rows(); ++i) {
+      parsed.emplace_back();
+      for (size_t j = 0; j < batch.n_cols(); ++j) {
+        ASSERT_EQ(batch[j].size(), batch.n_rows());
+        parsed.back().emplace_back(batch[j][i]);
+      }
+    }
+  }
+  EXPECT_EQ(parsed, table);
+  EXPECT_EQ(reader.n_rows(), table.size());
+  EXPECT_THROW(batch["d"], std::runtime_error);
+}
+
+TEST(CsvReaderTest, ReadBatchFitsRowsToColumns) {
+  CSVReader reader = parse_no_header("1,2\n3\n4,5,6\n");
+  CSVBatch batch;
+  ASSERT_TRUE(reader.read_batch(batch, 10));
+  ASSERT_EQ(batch.n_rows(), 3u);
+  ASSERT_EQ(batch.n_cols(), 2u);
+  EXPECT_EQ(batch[0][2], "4");
+  EXPECT_EQ(batch[1][0], "2");
+  EXPECT_EQ(batch[1][1], "");
+  EXPECT_EQ(batch[1][2], "5");
+  EXPECT_TRUE(batch.get_col_names().empty());
+  EXPECT_FALSE(reader.read_batch(batch, 10));
+  EXPECT_EQ(batch.n_rows(), 0u);
+}
+
+TEST(FieldConversionTest, ParsesInt64) {
+  int64_t value = 0;
+  for (auto test : std::vector<std::pair<std::string, int64_t>>{
+           {"0", 0},
+           {"-0", 0},
+           {"+42", 42},
+           {"-17", -17},
+           {"000000000000000000000123", 123},
+           {"9223372036854775807", INT64_MAX},
+           {"-9223372036854775808", INT64_MIN}}) {
+    ASSERT_TRUE(internals::parse_int64(test.first, value)) << test.first;
+    EXPECT_EQ(value, test.second) << test.first;
+  }
+  for (const char *text : {"", "-", "+", "1a", " 1", "1.0", "--1",
+                           "9223372036854775808", "-9223372036854775809",
+                           "99999999999999999999"}) {
+    EXPECT_FALSE(internals::parse_int64(text, value)) << text;
+  }
+}
+
+TEST(FieldConversionTest, ParsesDouble) {
+  double value = 0;
+  for (auto test : std::vector<std::pair<std::string, double>>{
+           {"0", 0},
+           {"1.5", 1.5},
+           {"-2.25", -2.25},
+           {"+3", 3},
+           {"1e3", 1000},
+           {".5", 0.5},
+           {"0.1", 0.1}}) {
+    ASSERT_TRUE(internals::parse_double(test.first, value)) << test.first;
+    EXPECT_EQ(value, test.second) << test.first;
+  }
+  for (const char *text : {"", "+", "+-1", "abc", "1.5x", " 1", "1e400", ".",
+                           "1e", "1e+", "--1"}) {
+    EXPECT_FALSE(internals::parse_double(text, value)) << text;
+  }
+}
+
+TEST(FieldConversionTest, ParsesDate) {
+  int32_t value = 0;
+  for (auto test : std::vector<std::pair<std::string, int32_t>>{
+           {"1970-01-01", 0},
+           {"1969-12-31", -1},
+           {"2000-03-01", 11017},
+           {"2024-02-29", 19782},
+           {"0000-03-01", -719468}}) {
+    ASSERT_TRUE(internals::parse_date(test.first, value)) << test.first;
+    EXPECT_EQ(value, test.second) << test.first;
+  }
+  for (const char *text : {"", "2023-02-29", "1900-02-29", "2024-13-01",
+                           "2024-00-10", "2024-01-32", "2024/01/01",
+                           "24-01-01", "2024-1-01x"}) {
+    EXPECT_FALSE(internals::parse_date(text, value)) << text;
+  }
+}
+
+TEST(CsvReaderTest, ReadBatchConvertsColumnTypes) {
+  const std::string text =
+      "id,price,day,name\n"
+      "1,2.5,2024-01-02,a\n"
+      "-3,,1970-01-01,\"b,c\"\n"
+      ",1e2,,\n"
+      "4,-0.5\n";
+  CSVReader reader = parse(text, CSVFormat().column_types(
+                                     {{"id", ColumnType::INT64},
+                                      {"price", ColumnType::DOUBLE},
+                                      {"day", ColumnType::DATE}}));
+  CSVBatch batch;
+  // The short last row is ignored by the default column policy.
+  ASSERT_TRUE(reader.read_batch(batch, 10));
+  ASSERT_EQ(batch.n_rows(), 3u);
+
+  const CSVColumn &id = batch["id"];
+  EXPECT_EQ(id.type, ColumnType::INT64);
+  EXPECT_EQ(id.size(), 3u);
+  EXPECT_EQ(id.int64s, std::vector<int64_t>({1, -3, 0}));
+  EXPECT_EQ(id.valid, std::vector<uint8_t>({1, 1, 0}));
+  EXPECT_TRUE(id.data.empty());
+
+  const CSVColumn &price = batch["price"];
+  EXPECT_EQ(price.doubles, std::vector<double>({2.5, 0, 100}));
+  EXPECT_EQ(price.valid, std::vector<uint8_t>({1, 0, 1}));
+
+  const CSVColumn &day = batch["day"];
+  EXPECT_EQ(day.dates, std::vector<int32_t>({19724, 0, 0}));
+  EXPECT_EQ(day.valid, std::vector<uint8_t>({1, 1, 0}));
+
+  const CSVColumn &name = batch["name"];
+  EXPECT_EQ(name.type, ColumnType::STRING);
+  EXPECT_EQ(name.size(), 3u);
+  EXPECT_EQ(name[1], "b,c");
+  EXPECT_TRUE(name.valid.empty());
+  EXPECT_THROW(name[3], std::runtime_error);
+  EXPECT_THROW(price[0], std::runtime_error);
+}
+
+TEST(CsvReaderTest, ReadBatchRejectsInvalidValues) {
+  CSVReader reader = parse(
+      "a,b,c\nx,1,2\ny,3,z\n",
+      CSVFormat().column_types(
+          {{"b", ColumnType::INT64}, {"c", ColumnType::INT64}}));
+  CSVBatch batch;
+  EXPECT_THROW(reader.read_batch(batch, 10), std::runtime_error);
+
+  // The fields of the invalid row before the invalid value are dropped.
+  EXPECT_EQ(batch.n_rows(), 1u);
+  EXPECT_EQ(batch["a"].size(), 1u);
+  EXPECT_EQ(batch["a"][0], "x");
+  EXPECT_EQ(batch["b"].int64s, std::vector<int64_t>({1}));
+  EXPECT_EQ(batch["b"].valid, std::vector<uint8_t>({1}));
+  EXPECT_EQ(batch["c"].int64s, std::vector<int64_t>({2}));
+
+  CSVReader unknown = parse(
+      "a,b\n1,2\n",
+      CSVFormat().column_types({{"c", ColumnType::INT64}}));
+  EXPECT_THROW(unknown.read_batch(batch, 10), std::runtime_error);
+}
+
+TEST(CsvReaderTest, ParseThreadsReadsFile) {
+  std::default_random_engine rng(kSeed);
+  const Table table = RandomTable(rng, 50, 3);
+  const std::string path =
+      WriteFile("reader.csv", "a,b,c\r\n" + ToCsv(table));
+
+  CSVReader reader(path, CSVFormat().parse_threads(0));
+  Table parsed;
+  for (CSVRow &row : reader) {
+    parsed.push_back(Fields(row));
+  }
+  EXPECT_EQ(reader.get_col_names(), std::vector<std::string>({"a", "b", "c"}));
+  EXPECT_EQ(parsed, table);
+}
+
+}  // namespace
+}  // namespace csv
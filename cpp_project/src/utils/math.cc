@@ -2,11 +2,17 @@
 
 #include "math.h"
 
+#include <absl/types/span.h>
+
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <numeric>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -26,19 +32,144 @@ double erfinv(double x) {
   return std::copysign(std::sqrt(-part1 + std::sqrt(part1 * part1 - part2)), x);
 }
 
+// The order shared by the argsort family: by value, then by index.
+struct ArgLess {
+  bool operator()(size_t i1, size_t i2) const {
+    return values[i1] < values[i2] || (values[i1] == values[i2] && i1 < i2);
+  }
+
+  absl::Span<const double> values;
+};
+
+void CheckArgsortSizes(absl::Span<const double> values,
+                       absl::Span<size_t> indices) {
+  if (values.size() != indices.size()) {
+    throw std::invalid_argument(
+        "Values and indices must be of the same size to argsort.");
+  }
+}
+
+// Maps a double to an unsigned integer with the same order. Negative numbers
+// have all bits flipped, positive numbers only the sign bit. -0 is mapped
+// like +0, because the two compare equal.
+uint64_t RadixKey(double value) {
+  if (value == 0) {
+    value = 0;
+  }
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  constexpr uint64_t kSignBit = uint64_t{1} << 63;
+  return bits & kSignBit ? ~bits : bits | kSignBit;
+}
+
 }  // namespace
 
 std::vector<size_t> argsort(const std::vector<double> &vec) {
-  // Create an index vector with the same size as the input vector
   std::vector<size_t> indices(vec.size());
-  // Fill it with 0, 1, ..., vec.size() - 1
+  Argsort(vec, absl::MakeSpan(indices));
+  return indices;
+}
+
+void Argsort(absl::Span<const double> values, absl::Span<size_t> indices) {
+  CheckArgsortSizes(values, indices);
+  if (values.size() >= kRadixArgsortMinSize) {
+    RadixArgsort(values, indices);
+    return;
+  }
+  std::iota(indices.begin(), indices.end(), 0);
+  std::sort(indices.begin(), indices.end(), ArgLess{values});
+}
+
+void PartialArgsort(absl::Span<const double> values, size_t k,
+                    absl::Span<size_t> indices) {
+  CheckArgsortSizes(values, indices);
   std::iota(indices.begin(), indices.end(), 0);
+  k = std::min(k, indices.size());
+  std::partial_sort(indices.begin(), indices.begin() + k, indices.end(),
+                    ArgLess{values});
+}
 
-  // Sort the index vector based on the values in vec
-  std::sort(indices.begin(), indices.end(),
-            [&vec](size_t i1, size_t i2) { return vec[i1] < vec[i2]; });
+void ArgNthElement(absl::Span<const double> values, size_t n,
+                   absl::Span<size_t> indices) {
+  CheckArgsortSizes(values, indices);
+  std::iota(indices.begin(), indices.end(), 0);
+  if (n >= indices.size()) {
+    return;
+  }
+  std::nth_element(indices.begin(), indices.begin() + n, indices.end(),
+                   ArgLess{values});
+}
 
-  return indices;
+void ArgsortUpdate(absl::Span<const double> values, size_t position,
+                   absl::Span<size_t> indices) {
+  CheckArgsortSizes(values, indices);
+  SPDLOG_CHECK(position < indices.size(),
+               fmt::format("position({}) must be smaller than the size({}).",
+                           position, indices.size()));
+  const ArgLess less{values};
+  const size_t changed = indices[position];
+  size_t k = position;
+  while (k > 0 && less(changed, indices[k - 1])) {
+    indices[k] = indices[k - 1];
+    --k;
+  }
+  while (k + 1 < indices.size() && less(indices[k + 1], changed)) {
+    indices[k] = indices[k + 1];
+    ++k;
+  }
+  indices[k] = changed;
+}
+
+void RadixArgsort(absl::Span<const double> values, absl::Span<size_t> indices) {
+  CheckArgsortSizes(values, indices);
+  const size_t n = values.size();
+
+  // 6 passes over 11 bit digits. Each pass is stable, so equal keys keep
+  // the index order of the initial iota.
+  constexpr int kDigitBits = 11;
+  constexpr int kNumPasses = (64 + kDigitBits - 1) / kDigitBits;
+  constexpr size_t kNumBuckets = size_t{1} << kDigitBits;
+  std::vector<uint64_t> keys(2 * n);
+  std::vector<size_t> scratch(n);
+  std::vector<std::array<size_t, kNumBuckets>> counts(kNumPasses);
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t key = RadixKey(values[i]);
+    keys[i] = key;
+    for (int pass = 0; pass < kNumPasses; ++pass) {
+      counts[pass][(key >> (pass * kDigitBits)) & (kNumBuckets - 1)] += 1;
+    }
+  }
+  std::iota(indices.begin(), indices.end(), 0);
+
+  uint64_t *keys_in = keys.data();
+  uint64_t *keys_out = keys.data() + n;
+  size_t *indices_in = indices.data();
+  size_t *indices_out = scratch.data();
+  for (int pass = 0; pass < kNumPasses; ++pass) {
+    std::array<size_t, kNumBuckets> &count = counts[pass];
+    // A digit that is the same for all keys does not change the order.
+    if (n == 0 || count[(keys_in[0] >> (pass * kDigitBits)) &
+                        (kNumBuckets - 1)] == n) {
+      continue;
+    }
+    size_t offset = 0;
+    for (size_t &c : count) {
+      offset += c;
+      c = offset - c;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      const size_t bucket = (keys_in[i] >> (pass * kDigitBits)) &
+                            (kNumBuckets - 1);
+      const size_t target = count[bucket]++;
+      keys_out[target] = keys_in[i];
+      indices_out[target] = indices_in[i];
+    }
+    std::swap(keys_in, keys_out);
+    std::swap(indices_in, indices_out);
+  }
+  if (indices_in != indices.data()) {
+    std::copy(indices_in, indices_in + n, indices.data());
+  }
 }
 
 double PercentileFromSigma(double x) {
@@ -1,12 +1,19 @@
 #ifndef MATH_H
 #define MATH_H
 
+#include <absl/types/span.h>
+
 #include <cmath>
 #include <cstddef>
 #include <stdexcept>
 #include <vector>
 
+#include "vector_kernels.h"
+
 namespace utils {
+// The operators below use the SIMD kernels of vector_kernels.h for double and
+// float, and plain loops for other element types.
+
 // Template function to overload the addition operator for two std::vector<T>
 template <typename T>
 std::vector<T> operator+(const std::vector<T> &a, const std::vector<T> &b) {
@@ -15,8 +22,12 @@ std::vector<T> operator+(const std::vector<T> &a, const std::vector<T> &b) {
   }
 
   std::vector<T> result(a.size());
-  for (size_t i = 0; i < a.size(); ++i) {
-    result[i] = a[i] + b[i];
+  if constexpr (kHasVectorKernels<T>) {
+    kernels::Add(a.data(), b.data(), result.data(), a.size());
+  } else {
+    for (size_t i = 0; i < a.size(); ++i) {
+      result[i] = a[i] + b[i];
+    }
   }
 
   return result;
@@ -30,8 +41,12 @@ std::vector<T> operator-(const std::vector<T> &a, const std::vector<T> &b) {
   }
 
   std::vector<T> result(a.size());
-  for (size_t i = 0; i < a.size(); ++i) {
-    result[i] = a[i] - b[i];
+  if constexpr (kHasVectorKernels<T>) {
+    kernels::Subtract(a.data(), b.data(), result.data(), a.size());
+  } else {
+    for (size_t i = 0; i < a.size(); ++i) {
+      result[i] = a[i] - b[i];
+    }
   }
 
   return result;
@@ -42,8 +57,12 @@ std::vector<T> operator-(const std::vector<T> &a, const std::vector<T> &b) {
 template <typename T>
 std::vector<T> operator*(T scalar, const std::vector<T> &vec) {
   std::vector<T> result(vec.size());
-  for (size_t i = 0; i < vec.size(); ++i) {
-    result[i] = scalar * vec[i];
+  if constexpr (kHasVectorKernels<T>) {
+    kernels::Multiply(scalar, vec.data(), result.data(), vec.size());
+  } else {
+    for (size_t i = 0; i < vec.size(); ++i) {
+      result[i] = scalar * vec[i];
+    }
   }
   return result;
 }
@@ -52,8 +71,12 @@ std::vector<T> operator*(T scalar, const std::vector<T> &vec) {
 // std::vector<T> and a scalar
 template <typename T>
 std::vector<T> &operator*=(std::vector<T> &vec, T scalar) {
-  for (size_t i = 0; i < vec.size(); ++i) {
-    vec[i] *= scalar;
+  if constexpr (kHasVectorKernels<T>) {
+    kernels::Multiply(scalar, vec.data(), vec.data(), vec.size());
+  } else {
+    for (size_t i = 0; i < vec.size(); ++i) {
+      vec[i] *= scalar;
+    }
   }
   return vec;
 }
@@ -63,8 +86,12 @@ std::vector<T> &operator*=(std::vector<T> &vec, T scalar) {
 template <typename T>
 std::vector<T> operator/(const std::vector<T> &vec, T scalar) {
   std::vector<T> result(vec.size());
-  for (size_t i = 0; i < vec.size(); ++i) {
-    result[i] = vec[i] / scalar;
+  if constexpr (kHasVectorKernels<T>) {
+    kernels::Divide(vec.data(), scalar, result.data(), vec.size());
+  } else {
+    for (size_t i = 0; i < vec.size(); ++i) {
+      result[i] = vec[i] / scalar;
+    }
   }
   return result;
 }
@@ -73,26 +100,249 @@ std::vector<T> operator/(const std::vector<T> &vec, T scalar) {
 // std::vector<T> and a scalar
 template <typename T>
 std::vector<T> &operator/=(std::vector<T> &vec, T scalar) {
-  for (size_t i = 0; i < vec.size(); ++i) {
-    vec[i] /= scalar;
+  if constexpr (kHasVectorKernels<T>) {
+    kernels::Divide(vec.data(), scalar, vec.data(), vec.size());
+  } else {
+    for (size_t i = 0; i < vec.size(); ++i) {
+      vec[i] /= scalar;
+    }
   }
   return vec;
 }
 
-// Template function to overload the in-place division operator for
-// std::vector<T> and a scalar
+// Euclidean norm of the elements of `vec` from index `start` on.
 template <typename T>
 double norm(const std::vector<T> &vec, size_t start = 0) {
-  T value = 0;
-  for (size_t i = start; i < vec.size(); ++i) {
-    value += (vec[i] * vec[i]);
+  if (start >= vec.size()) {
+    return 0;
+  }
+  if constexpr (kHasVectorKernels<T>) {
+    return std::sqrt(
+        kernels::SumOfSquares(vec.data() + start, vec.size() - start));
+  } else {
+    T value = 0;
+    for (size_t i = start; i < vec.size(); ++i) {
+      value += (vec[i] * vec[i]);
+    }
+    return std::sqrt(value);
+  }
+}
+
+// Lazy vector expressions.
+//
+// Every operator above allocates a new vector for its result, so an
+// expression like `a * x + b * y` allocates one vector per operation. The
+// expression templates below instead build a small expression tree that is
+// evaluated element by element in one fused pass when it is assigned to
+// preallocated storage:
+//
+//   Assign(xr, (1 + rho) * Lazy(xbar) - rho * Lazy(worst, n_dims));
+//
+// Expressions refer to their operands, which must outlive the expression.
+// Element i of the result only depends on element i of the operands, so the
+// output may alias any of the operands.
+template <typename E>
+struct VectorExpression {
+  const E &derived() const { return static_cast<const E &>(*this); }
+};
+
+// Leaf of an expression that refers to existing storage.
+template <typename T>
+class VectorView : public VectorExpression<VectorView<T>> {
+ public:
+  using value_type = T;
+
+  VectorView(const T *data, size_t size) : data_(data), size_(size) {}
+
+  size_t size() const { return size_; }
+  T operator[](size_t i) const { return data_[i]; }
+
+ private:
+  const T *data_;
+  size_t size_;
+};
+
+namespace internal {
+
+struct Plus {
+  template <typename T>
+  static T Apply(T a, T b) {
+    return a + b;
+  }
+};
+
+struct Minus {
+  template <typename T>
+  static T Apply(T a, T b) {
+    return a - b;
+  }
+};
+
+struct Multiplies {
+  template <typename T>
+  static T Apply(T a, T b) {
+    return a * b;
+  }
+};
+
+struct Divides {
+  template <typename T>
+  static T Apply(T a, T b) {
+    return a / b;
+  }
+};
+
+}  // namespace internal
+
+// Element-wise operation on two expressions of the same size.
+template <typename L, typename R, typename Op>
+class BinaryExpression : public VectorExpression<BinaryExpression<L, R, Op>> {
+ public:
+  using value_type = typename L::value_type;
+
+  BinaryExpression(const L &lhs, const R &rhs) : lhs_(lhs), rhs_(rhs) {
+    if (lhs.size() != rhs.size()) {
+      throw std::invalid_argument(
+          "Vector expressions must be of the same size.");
+    }
+  }
+
+  size_t size() const { return lhs_.size(); }
+  value_type operator[](size_t i) const { return Op::Apply(lhs_[i], rhs_[i]); }
+
+ private:
+  L lhs_;
+  R rhs_;
+};
+
+// Element-wise operation between an expression and a scalar. The scalar is
+// the left operand of Op if `kScalarFirst` is true.
+template <typename E, typename Op, bool kScalarFirst>
+class ScalarExpression
+    : public VectorExpression<ScalarExpression<E, Op, kScalarFirst>> {
+ public:
+  using value_type = typename E::value_type;
+
+  ScalarExpression(value_type scalar, const E &expr)
+      : scalar_(scalar), expr_(expr) {}
+
+  size_t size() const { return expr_.size(); }
+  value_type operator[](size_t i) const {
+    return kScalarFirst ? Op::Apply(scalar_, expr_[i])
+                        : Op::Apply(expr_[i], scalar_);
+  }
+
+ private:
+  value_type scalar_;
+  E expr_;
+};
+
+// Wraps a std::vector<T> as the leaf of a lazy expression.
+template <typename T>
+VectorView<T> Lazy(const std::vector<T> &vec) {
+  return VectorView<T>(vec.data(), vec.size());
+}
+
+// Wraps `size` contiguous elements starting at `data` as the leaf of a lazy
+// expression.
+template <typename T>
+VectorView<T> Lazy(const T *data, size_t size) {
+  return VectorView<T>(data, size);
+}
+
+template <typename L, typename R>
+BinaryExpression<L, R, internal::Plus> operator+(
+    const VectorExpression<L> &a, const VectorExpression<R> &b) {
+  return {a.derived(), b.derived()};
+}
+
+template <typename L, typename R>
+BinaryExpression<L, R, internal::Minus> operator-(
+    const VectorExpression<L> &a, const VectorExpression<R> &b) {
+  return {a.derived(), b.derived()};
+}
+
+template <typename E>
+ScalarExpression<E, internal::Multiplies, true> operator*(
+    typename E::value_type scalar, const VectorExpression<E> &expr) {
+  return {scalar, expr.derived()};
+}
+
+template <typename E>
+ScalarExpression<E, internal::Multiplies, false> operator*(
+    const VectorExpression<E> &expr, typename E::value_type scalar) {
+  return {scalar, expr.derived()};
+}
+
+template <typename E>
+ScalarExpression<E, internal::Divides, false> operator/(
+    const VectorExpression<E> &expr, typename E::value_type scalar) {
+  return {scalar, expr.derived()};
+}
+
+// Evaluates `expr` in a single pass into `out`, which must hold expr.size()
+// elements.
+template <typename T, typename E>
+void Assign(T *out, const VectorExpression<E> &expr) {
+  const E &e = expr.derived();
+  const size_t size = e.size();
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = e[i];
   }
-  return std::sqrt(value);
+}
+
+// Evaluates `expr` in a single pass into `out`. `out` is only reallocated if
+// its capacity is too small.
+template <typename T, typename E>
+void Assign(std::vector<T> &out, const VectorExpression<E> &expr) {
+  out.resize(expr.derived().size());
+  Assign(out.data(), expr);
 }
 
 // Function to perform argsort on a std::vector<double>
 std::vector<size_t> argsort(const std::vector<double> &vec);
 
+// Argsort family working on caller-provided index buffers.
+//
+// All of them order index i before index j if values[i] < values[j], or if
+// the values are equal and i < j. This is a strict total order, so every
+// variant yields the same indices as a stable sort, independent of the
+// previous content of the buffer. NaN values are not supported. `indices`
+// must have the same size as `values`, otherwise std::invalid_argument is
+// thrown. They do not allocate, except for RadixArgsort and thereby Argsort
+// on large arrays.
+
+// Writes the indices that sort `values` in ascending order to `indices`.
+// Uses RadixArgsort for arrays of at least kRadixArgsortMinSize elements.
+void Argsort(absl::Span<const double> values, absl::Span<size_t> indices);
+
+// Same as Argsort, but only the first `k` entries of `indices` are sorted.
+// The others hold the remaining indices in unspecified order. Costs
+// O(n log k).
+void PartialArgsort(absl::Span<const double> values, size_t k,
+                    absl::Span<size_t> indices);
+
+// Writes the index of the n-th smallest value to indices[n], like
+// std::nth_element. The entries before n have smaller values and the entries
+// after n larger ones, in unspecified order. Costs O(n) on average.
+void ArgNthElement(absl::Span<const double> values, size_t n,
+                   absl::Span<size_t> indices);
+
+// Restores the order of `indices` after the value of index
+// indices[position] changed, while all other entries are still sorted.
+// Moves the entry by insertion, which costs O(distance moved), e.g. O(n)
+// instead of O(n log n) when the worst point of a simplex is replaced.
+void ArgsortUpdate(absl::Span<const double> values, size_t position,
+                   absl::Span<size_t> indices);
+
+// Same as Argsort, but sorts with a least significant digit radix sort over
+// the bits of the values in O(n). Allocates 3 n words of scratch space, so it
+// only pays off for large arrays.
+void RadixArgsort(absl::Span<const double> values, absl::Span<size_t> indices);
+
+// Size from which Argsort sorts with RadixArgsort.
+constexpr size_t kRadixArgsortMinSize = 4096;
+
 // Calculates Percentile point from sigma value `x`.
 // This is equivalent to 100 * CDF(x) for normal distribution N(0, 1)
 // Output value is in range [0, 100].
@@ -1,5 +1,6 @@
 #include "math.h"
 
+#include <absl/types/span.h>
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 #include <gmock/gmock.h>
@@ -9,6 +10,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <limits>
+#include <numeric>
 #include <random>
 #include <vector>
 
@@ -32,6 +35,110 @@ TEST(MathTest, TestNormFunction) {
   EXPECT_NEAR(norm(vec), 2 * std::sqrt(2), 1e-8);
 };
 
+TEST(MathTest, LazyExpressionMatchesEagerOperators) {
+  std::vector<double> x{1, 2, 3};
+  std::vector<double> y{-4, 0.5, 7};
+  double rho = 0.3;
+
+  std::vector<double> eager = (1 + rho) * x - rho * y;
+  std::vector<double> lazy;
+  Assign(lazy, (1 + rho) * Lazy(x) - rho * Lazy(y));
+  EXPECT_EQ(lazy, eager);
+
+  eager = x + 0.5 * (y - x) / 2.0;
+  Assign(lazy, Lazy(x) + 0.5 * (Lazy(y) - Lazy(x)) / 2.0);
+  EXPECT_EQ(lazy, eager);
+}
+
+TEST(MathTest, LazyExpressionCanAliasItsOutput) {
+  std::vector<double> x{1, 2, 3};
+  std::vector<double> best{1, 1, 1};
+
+  Assign(x.data(), Lazy(best) + 0.5 * (Lazy(x) - Lazy(best)));
+
+  EXPECT_THAT(x, testing::ElementsAre(1, 1.5, 2));
+}
+
+TEST(MathTest, LazyExpressionRejectsDifferentSizes) {
+  std::vector<double> x{1, 2, 3};
+  std::vector<double> y{1, 2};
+
+  EXPECT_THROW(Lazy(x) + Lazy(y), std::invalid_argument);
+}
+
+// Values with many ties and both zeros, in random order.
+std::vector<double> ValuesWithTies(size_t size,
+                                   std::default_random_engine &rng) {
+  std::uniform_int_distribution<int> distribution(-20, 20);
+  std::vector<double> values(size);
+  for (double &value : values) {
+    const int k = distribution(rng);
+    value = k == 0 ? -0.0 : k * 0.25;
+  }
+  return values;
+}
+
+std::vector<size_t> StableArgsort(const std::vector<double> &values) {
+  std::vector<size_t> indices(values.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  std::stable_sort(indices.begin(), indices.end(), [&](size_t i1, size_t i2) {
+    return values[i1] < values[i2];
+  });
+  return indices;
+}
+
+TEST(MathTest, ArgsortVariantsMatchStableSort) {
+  std::default_random_engine rng(kSeed);
+  for (size_t size : {0, 1, 3, 17, 1000, 70000}) {
+    const std::vector<double> values = ValuesWithTies(size, rng);
+    const std::vector<size_t> expected = StableArgsort(values);
+    std::vector<size_t> indices(size, 7);
+
+    Argsort(values, absl::MakeSpan(indices));
+    EXPECT_EQ(indices, expected) << size;
+    EXPECT_EQ(argsort(values), expected) << size;
+    RadixArgsort(values, absl::MakeSpan(indices));
+    EXPECT_EQ(indices, expected) << size;
+
+    const size_t k = std::min<size_t>(size, 3);
+    PartialArgsort(values, k, absl::MakeSpan(indices));
+    EXPECT_TRUE(std::equal(indices.begin(), indices.begin() + k,
+                           expected.begin()))
+        << size;
+
+    if (size > 0) {
+      const size_t n = size / 2;
+      ArgNthElement(values, n, absl::MakeSpan(indices));
+      EXPECT_EQ(indices[n], expected[n]) << size;
+    }
+  }
+}
+
+TEST(MathTest, RadixArgsortOrdersSignsAndMagnitudes) {
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<double> values{3, -inf, 0.0, -1e-300, inf, -0.0, -2.5, 1e300};
+  std::vector<size_t> indices(values.size());
+  RadixArgsort(values, absl::MakeSpan(indices));
+  EXPECT_THAT(indices, testing::ElementsAre(1, 6, 3, 2, 5, 0, 7, 4));
+}
+
+TEST(MathTest, ArgsortUpdateRestoresOrder) {
+  std::default_random_engine rng(kSeed);
+  std::vector<double> values = ValuesWithTies(50, rng);
+  std::vector<size_t> indices(values.size());
+  Argsort(values, absl::MakeSpan(indices));
+
+  std::uniform_int_distribution<size_t> positions(0, values.size() - 1);
+  for (int i = 0; i < 200; ++i) {
+    const size_t position = positions(rng);
+    values[indices[position]] = ValuesWithTies(1, rng)[0];
+    ArgsortUpdate(values, position, absl::MakeSpan(indices));
+    ASSERT_EQ(indices, StableArgsort(values)) << i;
+  }
+  EXPECT_THROW(Argsort(values, absl::MakeSpan(indices).subspan(1)),
+               std::invalid_argument);
+}
+
 TEST(MathTest, SphericalToCartesianNormality) {
   std::default_random_engine rng(kSeed);
 
@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+// Fixed size pool of worker threads.
+class ThreadPool {
+ public:
+  // Creates a pool with `num_threads` workers. If `num_threads` is 0, the
+  // number of hardware threads is used.
+  explicit ThreadPool(size_t num_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Number of worker threads.
+  size_t size() const { return workers_.size(); }
+
+  // Calls fn(i) for every i in [0, n) on at most size() threads and returns
+  // once all calls finished. The calling thread takes part in the work and
+  // counts as one of these threads, so it is safe to call
+  // ParallelFor from inside a task that runs on the same pool. If any call
+  // throws, the first exception is rethrown after all calls finished.
+  void ParallelFor(size_t n, const std::function<void(size_t)> &fn);
+
+ private:
+  void Schedule(std::function<void()> task);
+
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+};
+
+}  // namespace utils
+
+#endif  // THREAD_POOL_H
@@ -0,0 +1,58 @@
+#include "thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace utils {
+namespace {
+
+TEST(ThreadPoolTest, ParallelForVisitsEveryIndexOnce) {
+  ThreadPool pool(4);
+  std::vector<std::atomic<int>> visits(1000);
+
+  pool.ParallelFor(visits.size(), [&visits](size_t i) { visits[i] += 1; });
+
+  for (const auto &v : visits) {
+    EXPECT_EQ(v.load(), 1);
+  }
+}
+
+TEST(ThreadPoolTest, ParallelForWithZeroItemsReturns) {
+  ThreadPool pool(2);
+  bool called = false;
+  pool.ParallelFor(0, [&called](size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ThreadPoolTest, NestedParallelForDoesNotDeadlock) {
+  ThreadPool pool(2);
+  std::atomic<size_t> count{0};
+
+  pool.ParallelFor(8, [&pool, &count](size_t) {
+    pool.ParallelFor(8, [&count](size_t) { count += 1; });
+  });
+
+  EXPECT_EQ(count.load(), 64);
+}
+
+TEST(ThreadPoolTest, ParallelForRethrowsException) {
+  ThreadPool pool(4);
+  std::atomic<size_t> count{0};
+
+  EXPECT_THROW(pool.ParallelFor(100,
+                                [&count](size_t i) {
+                                  count += 1;
+                                  if (i == 42) {
+                                    throw std::runtime_error("failure");
+                                  }
+                                }),
+               std::runtime_error);
+  EXPECT_EQ(count.load(), 100);
+}
+
+}  // namespace
+}  // namespace utils
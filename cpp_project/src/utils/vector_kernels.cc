@@ -0,0 +1,476 @@
+#include "vector_kernels.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// The vector levels are compiled with per-function target attributes, so the
+// rest of the build keeps its baseline instruction set and the level is
+// selected at runtime. Both vector levels enable FMA. Axpy and Axpby call
+// std::fma explicitly at every level, so they round the same way whether or
+// not the compiler would fuse a plain multiply-add.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define UTILS_X86_VECTOR_KERNELS 1
+#endif
+
+namespace utils {
+namespace {
+
+std::atomic<SimdLevel> &Level() {
+  static std::atomic<SimdLevel> level(SupportedSimdLevel());
+  return level;
+}
+
+struct AddOp {
+  template <typename T>
+  [[gnu::always_inline]] static void Apply(const T &a, const T &b, T &out) {
+    out = a + b;
+  }
+};
+
+struct SubtractOp {
+  template <typename T>
+  [[gnu::always_inline]] static void Apply(const T &a, const T &b, T &out) {
+    out = a - b;
+  }
+};
+
+struct MultiplyOp {
+  template <typename T>
+  [[gnu::always_inline]] static void Apply(const T &a, const T &b, T &out) {
+    out = a * b;
+  }
+};
+
+struct DivideOp {
+  template <typename T>
+  [[gnu::always_inline]] static void Apply(const T &a, const T &b, T &out) {
+    out = a / b;
+  }
+};
+
+// Portable loops of the kScalar level.
+
+template <typename Op, typename T>
+void ScalarBinary(const T *a, const T *b, T *out, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    Op::Apply(a[i], b[i], out[i]);
+  }
+}
+
+// Computes Op(a[i], scalar), or Op(scalar, a[i]) if `kScalarFirst` is true.
+template <typename Op, bool kScalarFirst, typename T>
+void ScalarWithScalar(const T *a, T scalar, T *out, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    if (kScalarFirst) {
+      Op::Apply(scalar, a[i], out[i]);
+    } else {
+      Op::Apply(a[i], scalar, out[i]);
+    }
+  }
+}
+
+template <typename T>
+T ScalarSumOfSquares(const T *a, size_t size) {
+  T sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += a[i] * a[i];
+  }
+  return sum;
+}
+
+// Computes fma(alpha, x[i], beta * y[i]), or fma(alpha, x[i], y[i]) if
+// `kUnitBeta` is true. Without FMA instructions std::fma is emulated in
+// software, which is exact but slow.
+template <bool kUnitBeta, typename T>
+void ScalarAxpby(T alpha, const T *x, T beta, const T *y, T *out,
+                 size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = std::fma(alpha, x[i], kUnitBeta ? y[i] : beta * y[i]);
+  }
+}
+
+template <typename T>
+T ScalarDot(const T *x, const T *y, size_t size) {
+  T sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+// Vector loops on `kBytes` wide vectors of the compiler's vector extension.
+// They are always inlined into the callers below, whose target attribute
+// selects the instructions. The remaining size % kWidth elements are handled
+// by the scalar loops. Loads and stores go through memcpy, so the arrays need
+// no alignment and `out` may alias the inputs.
+
+template <typename T, size_t kBytes>
+struct Vector {
+  typedef T Type __attribute__((vector_size(kBytes)));
+  static constexpr size_t kWidth = kBytes / sizeof(T);
+};
+
+template <typename Op, typename T, size_t kBytes>
+[[gnu::always_inline]] inline void VectorBinary(const T *a, const T *b, T *out,
+                                                size_t size) {
+  using V = Vector<T, kBytes>;
+  size_t i = 0;
+  for (; i + V::kWidth <= size; i += V::kWidth) {
+    typename V::Type va, vb;
+    std::memcpy(&va, a + i, kBytes);
+    std::memcpy(&vb, b + i, kBytes);
+    Op::Apply(va, vb, va);
+    std::memcpy(out + i, &va, kBytes);
+  }
+  ScalarBinary<Op>(a + i, b + i, out + i, size - i);
+}
+
+template <typename Op, bool kScalarFirst, typename T, size_t kBytes>
+[[gnu::always_inline]] inline void VectorWithScalar(const T *a, T scalar,
+                                                    T *out, size_t size) {
+  using V = Vector<T, kBytes>;
+  const typename V::Type vs = typename V::Type{} + scalar;
+  size_t i = 0;
+  for (; i + V::kWidth <= size; i += V::kWidth) {
+    typename V::Type va;
+    std::memcpy(&va, a + i, kBytes);
+    if (kScalarFirst) {
+      Op::Apply(vs, va, va);
+    } else {
+      Op::Apply(va, vs, va);
+    }
+    std::memcpy(out + i, &va, kBytes);
+  }
+  ScalarWithScalar<Op, kScalarFirst>(a + i, scalar, out + i, size - i);
+}
+
+// Sums into four independent vectors, so consecutive additions do not wait
+// for each other.
+template <typename T, size_t kBytes>
+[[gnu::always_inline]] inline T VectorSumOfSquares(const T *a, size_t size) {
+  using V = Vector<T, kBytes>;
+  constexpr size_t kUnroll = 4;
+  typename V::Type sums[kUnroll] = {};
+  size_t i = 0;
+  for (; i + kUnroll * V::kWidth <= size; i += kUnroll * V::kWidth) {
+    for (size_t k = 0; k < kUnroll; ++k) {
+      typename V::Type va;
+      std::memcpy(&va, a + i + k * V::kWidth, kBytes);
+      sums[k] += va * va;
+    }
+  }
+  for (; i + V::kWidth <= size; i += V::kWidth) {
+    typename V::Type va;
+    std::memcpy(&va, a + i, kBytes);
+    sums[0] += va * va;
+  }
+  const typename V::Type total = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+  T sum = 0;
+  for (size_t k = 0; k < V::kWidth; ++k) {
+    sum += total[k];
+  }
+  return sum + ScalarSumOfSquares(a + i, size - i);
+}
+
+// Returns fma(a[k], b[k], c[k]) for every lane k. Once inlined into a function
+// with FMA enabled, the lanes are compiled into one vector FMA instruction.
+template <typename V>
+[[gnu::always_inline]] inline V Fma(V a, const V &b, const V &c) {
+  for (size_t k = 0; k < sizeof(V) / sizeof(a[0]); ++k) {
+    a[k] = std::fma(a[k], b[k], c[k]);
+  }
+  return a;
+}
+
+// The remaining elements are handled inline, not by ScalarAxpby, so that
+// std::fma is compiled into FMA instructions here as well.
+template <bool kUnitBeta, typename T, size_t kBytes>
+[[gnu::always_inline]] inline void VectorAxpby(T alpha, const T *x, T beta,
+                                               const T *y, T *out,
+                                               size_t size) {
+  using V = Vector<T, kBytes>;
+  const typename V::Type valpha = typename V::Type{} + alpha;
+  const typename V::Type vbeta = typename V::Type{} + beta;
+  size_t i = 0;
+  for (; i + V::kWidth <= size; i += V::kWidth) {
+    typename V::Type vx, vy;
+    std::memcpy(&vx, x + i, kBytes);
+    std::memcpy(&vy, y + i, kBytes);
+    vy = Fma(valpha, vx, kUnitBeta ? vy : vbeta * vy);
+    std::memcpy(out + i, &vy, kBytes);
+  }
+  for (; i < size; ++i) {
+    out[i] = std::fma(alpha, x[i], kUnitBeta ? y[i] : beta * y[i]);
+  }
+}
+
+template <typename T, size_t kBytes>
+[[gnu::always_inline]] inline T VectorDot(const T *x, const T *y,
+                                          size_t size) {
+  using V = Vector<T, kBytes>;
+  constexpr size_t kUnroll = 4;
+  typename V::Type sums[kUnroll] = {};
+  size_t i = 0;
+  for (; i + kUnroll * V::kWidth <= size; i += kUnroll * V::kWidth) {
+    for (size_t k = 0; k < kUnroll; ++k) {
+      typename V::Type vx, vy;
+      std::memcpy(&vx, x + i + k * V::kWidth, kBytes);
+      std::memcpy(&vy, y + i + k * V::kWidth, kBytes);
+      sums[k] = vx * vy + sums[k];
+    }
+  }
+  for (; i + V::kWidth <= size; i += V::kWidth) {
+    typename V::Type vx, vy;
+    std::memcpy(&vx, x + i, kBytes);
+    std::memcpy(&vy, y + i, kBytes);
+    sums[0] = vx * vy + sums[0];
+  }
+  const typename V::Type total = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+  T sum = 0;
+  for (size_t k = 0; k < V::kWidth; ++k) {
+    sum += total[k];
+  }
+  for (; i < size; ++i) {
+    sum = x[i] * y[i] + sum;
+  }
+  return sum;
+}
+
+#ifdef UTILS_X86_VECTOR_KERNELS
+
+template <typename Op, typename T>
+__attribute__((target("avx2,fma"))) void Avx2Binary(const T *a, const T *b,
+                                                    T *out, size_t size) {
+  VectorBinary<Op, T, 32>(a, b, out, size);
+}
+
+template <typename Op, bool kScalarFirst, typename T>
+__attribute__((target("avx2,fma"))) void Avx2WithScalar(const T *a,
+                                                        T scalar, T *out,
+                                                        size_t size) {
+  VectorWithScalar<Op, kScalarFirst, T, 32>(a, scalar, out, size);
+}
+
+template <typename T>
+__attribute__((target("avx2,fma"))) T Avx2SumOfSquares(const T *a,
+                                                       size_t size) {
+  return VectorSumOfSquares<T, 32>(a, size);
+}
+
+template <bool kUnitBeta, typename T>
+__attribute__((target("avx2,fma"))) void Avx2Axpby(T alpha, const T *x, T beta,
+                                                   const T *y, T *out,
+                                                   size_t size) {
+  VectorAxpby<kUnitBeta, T, 32>(alpha, x, beta, y, out, size);
+}
+
+template <typename T>
+__attribute__((target("avx2,fma"))) T Avx2Dot(const T *x, const T *y,
+                                              size_t size) {
+  return VectorDot<T, 32>(x, y, size);
+}
+
+template <typename Op, typename T>
+__attribute__((target("avx512f"))) void Avx512Binary(const T *a, const T *b,
+                                                     T *out, size_t size) {
+  VectorBinary<Op, T, 64>(a, b, out, size);
+}
+
+template <typename Op, bool kScalarFirst, typename T>
+__attribute__((target("avx512f"))) void Avx512WithScalar(const T *a, T scalar,
+                                                         T *out, size_t size) {
+  VectorWithScalar<Op, kScalarFirst, T, 64>(a, scalar, out, size);
+}
+
+template <typename T>
+__attribute__((target("avx512f"))) T Avx512SumOfSquares(const T *a,
+                                                        size_t size) {
+  return VectorSumOfSquares<T, 64>(a, size);
+}
+
+template <bool kUnitBeta, typename T>
+__attribute__((target("avx512f"))) void Avx512Axpby(T alpha, const T *x,
+                                                    T beta, const T *y, T *out,
+                                                    size_t size) {
+  VectorAxpby<kUnitBeta, T, 64>(alpha, x, beta, y, out, size);
+}
+
+template <typename T>
+__attribute__((target("avx512f"))) T Avx512Dot(const T *x, const T *y,
+                                               size_t size) {
+  return VectorDot<T, 64>(x, y, size);
+}
+
+#endif  // UTILS_X86_VECTOR_KERNELS
+
+// Dispatchers to the active level.
+
+template <typename Op, typename T>
+void Binary(const T *a, const T *b, T *out, size_t size) {
+  switch (Level().load(std::memory_order_relaxed)) {
+#ifdef UTILS_X86_VECTOR_KERNELS
+    case SimdLevel::kAvx512:
+      return Avx512Binary<Op>(a, b, out, size);
+    case SimdLevel::kAvx2:
+      return Avx2Binary<Op>(a, b, out, size);
+#endif
+    default:
+      return ScalarBinary<Op>(a, b, out, size);
+  }
+}
+
+template <typename Op, bool kScalarFirst, typename T>
+void WithScalar(const T *a, T scalar, T *out, size_t size) {
+  switch (Level().load(std::memory_order_relaxed)) {
+#ifdef UTILS_X86_VECTOR_KERNELS
+    case SimdLevel::kAvx512:
+      return Avx512WithScalar<Op, kScalarFirst>(a, scalar, out, size);
+    case SimdLevel::kAvx2:
+      return Avx2WithScalar<Op, kScalarFirst>(a, scalar, out, size);
+#endif
+    default:
+      return ScalarWithScalar<Op, kScalarFirst>(a, scalar, out, size);
+  }
+}
+
+template <typename T>
+T SumOfSquaresOf(const T *a, size_t size) {
+  switch (Level().load(std::memory_order_relaxed)) {
+#ifdef UTILS_X86_VECTOR_KERNELS
+    case SimdLevel::kAvx512:
+      return Avx512SumOfSquares(a, size);
+    case SimdLevel::kAvx2:
+      return Avx2SumOfSquares(a, size);
+#endif
+    default:
+      return ScalarSumOfSquares(a, size);
+  }
+}
+
+template <bool kUnitBeta, typename T>
+void AxpbyOf(T alpha, const T *x, T beta, const T *y, T *out, size_t size) {
+  switch (Level().load(std::memory_order_relaxed)) {
+#ifdef UTILS_X86_VECTOR_KERNELS
+    case SimdLevel::kAvx512:
+      return Avx512Axpby<kUnitBeta>(alpha, x, beta, y, out, size);
+    case SimdLevel::kAvx2:
+      return Avx2Axpby<kUnitBeta>(alpha, x, beta, y, out, size);
+#endif
+    default:
+      return ScalarAxpby<kUnitBeta>(alpha, x, beta, y, out, size);
+  }
+}
+
+template <typename T>
+T DotOf(const T *x, const T *y, size_t size) {
+  switch (Level().load(std::memory_order_relaxed)) {
+#ifdef UTILS_X86_VECTOR_KERNELS
+    case SimdLevel::kAvx512:
+      return Avx512Dot(x, y, size);
+    case SimdLevel::kAvx2:
+      return Avx2Dot(x, y, size);
+#endif
+    default:
+      return ScalarDot(x, y, size);
+  }
+}
+
+}  // namespace
+
+SimdLevel SupportedSimdLevel() {
+#ifdef UTILS_X86_VECTOR_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SimdLevel::kAvx2;
+  }
+#endif
+  return SimdLevel::kScalar;
+}
+
+SimdLevel ActiveSimdLevel() { return Level().load(); }
+
+SimdLevel SetSimdLevel(SimdLevel level) {
+  const SimdLevel supported = SupportedSimdLevel();
+  if (static_cast<int>(level) > static_cast<int>(supported)) {
+    level = supported;
+  }
+  Level().store(level);
+  return level;
+}
+
+namespace kernels {
+
+void Add(const double *a, const double *b, double *out, size_t size) {
+  Binary<AddOp>(a, b, out, size);
+}
+
+void Add(const float *a, const float *b, float *out, size_t size) {
+  Binary<AddOp>(a, b, out, size);
+}
+
+void Subtract(const double *a, const double *b, double *out, size_t size) {
+  Binary<SubtractOp>(a, b, out, size);
+}
+
+void Subtract(const float *a, const float *b, float *out, size_t size) {
+  Binary<SubtractOp>(a, b, out, size);
+}
+
+void Multiply(double scalar, const double *a, double *out, size_t size) {
+  WithScalar<MultiplyOp, true>(a, scalar, out, size);
+}
+
+void Multiply(float scalar, const float *a, float *out, size_t size) {
+  WithScalar<MultiplyOp, true>(a, scalar, out, size);
+}
+
+void Divide(const double *a, double scalar, double *out, size_t size) {
+  WithScalar<DivideOp, false>(a, scalar, out, size);
+}
+
+void Divide(const float *a, float scalar, float *out, size_t size) {
+  WithScalar<DivideOp, false>(a, scalar, out, size);
+}
+
+double SumOfSquares(const double *a, size_t size) {
+  return SumOfSquaresOf(a, size);
+}
+
+float SumOfSquares(const float *a, size_t size) {
+  return SumOfSquaresOf(a, size);
+}
+
+void Axpy(double alpha, const double *x, double *y, size_t size) {
+  AxpbyOf<true>(alpha, x, 1.0, y, y, size);
+}
+
+void Axpy(float alpha, const float *x, float *y, size_t size) {
+  AxpbyOf<true>(alpha, x, 1.0f, y, y, size);
+}
+
+void Axpby(double alpha, const double *x, double beta, const double *y,
+           double *out, size_t size) {
+  AxpbyOf<false>(alpha, x, beta, y, out, size);
+}
+
+void Axpby(float alpha, const float *x, float beta, const float *y,
+           float *out, size_t size) {
+  AxpbyOf<false>(alpha, x, beta, y, out, size);
+}
+
+double Dot(const double *x, const double *y, size_t size) {
+  return DotOf(x, y, size);
+}
+
+float Dot(const float *x, const float *y, size_t size) {
+  return DotOf(x, y, size);
+}
+
+}  // namespace kernels
+}  // namespace utils
@@ -0,0 +1,86 @@
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include <cstddef>
+#include <type_traits>
+
+namespace utils {
+
+// Instruction sets of the element-wise kernels below, from the slowest to the
+// fastest.
+enum class SimdLevel {
+  // Portable loop, vectorized by the compiler for the baseline target only.
+  kScalar,
+  // 256 bit vectors and FMA.
+  kAvx2,
+  // 512 bit vectors and FMA.
+  kAvx512,
+};
+
+// Returns the fastest level that this build and the running CPU support.
+SimdLevel SupportedSimdLevel();
+
+// Returns the level used by the kernels. It is SupportedSimdLevel() unless
+// changed by SetSimdLevel.
+SimdLevel ActiveSimdLevel();
+
+// Selects the level used by the kernels, e.g. to compare the levels in tests
+// and benchmarks. Levels above SupportedSimdLevel() are lowered to it. Returns
+// the selected level.
+SimdLevel SetSimdLevel(SimdLevel level);
+
+// Element types that the kernels are implemented for.
+template <typename T>
+constexpr bool kHasVectorKernels =
+    std::is_same_v<T, double> || std::is_same_v<T, float>;
+
+namespace kernels {
+
+// Element-wise kernels on arrays of `size` elements. `out` may alias any of
+// the inputs. Every element is computed with one IEEE operation, so the
+// results do not depend on the SIMD level.
+
+// out[i] = a[i] + b[i]
+void Add(const double *a, const double *b, double *out, size_t size);
+void Add(const float *a, const float *b, float *out, size_t size);
+
+// out[i] = a[i] - b[i]
+void Subtract(const double *a, const double *b, double *out, size_t size);
+void Subtract(const float *a, const float *b, float *out, size_t size);
+
+// out[i] = scalar * a[i]
+void Multiply(double scalar, const double *a, double *out, size_t size);
+void Multiply(float scalar, const float *a, float *out, size_t size);
+
+// out[i] = a[i] / scalar
+void Divide(const double *a, double scalar, double *out, size_t size);
+void Divide(const float *a, float scalar, float *out, size_t size);
+
+// Returns the sum of a[i] * a[i]. The vector levels sum in a different order
+// than kScalar, so the results may differ in the last bits.
+double SumOfSquares(const double *a, size_t size);
+float SumOfSquares(const float *a, size_t size);
+
+// The kernels below compute every element with one fused multiply-add,
+// std::fma, at every level. kScalar emulates it in software on CPUs without
+// FMA instructions.
+
+// y[i] = fma(alpha, x[i], y[i])
+void Axpy(double alpha, const double *x, double *y, size_t size);
+void Axpy(float alpha, const float *x, float *y, size_t size);
+
+// out[i] = fma(alpha, x[i], beta * y[i])
+void Axpby(double alpha, const double *x, double beta, const double *y,
+           double *out, size_t size);
+void Axpby(float alpha, const float *x, float beta, const float *y,
+           float *out, size_t size);
+
+// Returns the sum of x[i] * y[i]. Like SumOfSquares, the levels sum in
+// different orders, and the vector levels may fuse the multiply-adds.
+double Dot(const double *x, const double *y, size_t size);
+float Dot(const float *x, const float *y, size_t size);
+
+}  // namespace kernels
+}  // namespace utils
+
+#endif  // VECTOR_KERNELS_H
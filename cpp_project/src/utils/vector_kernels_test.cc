@@ -0,0 +1,144 @@
+#include "vector_kernels.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "math.h"
+
+namespace utils {
+namespace {
+
+const int kSeed = 0;
+
+// Sizes that cover empty arrays, partial vectors and several full vectors
+// with a tail for both the 256 and the 512 bit levels.
+constexpr size_t kMaxSize = 70;
+
+// Runs every test at each level that the CPU supports and restores the
+// default level afterwards.
+template <typename T>
+class VectorKernelsTest : public testing::Test {
+ protected:
+  void TearDown() override { SetSimdLevel(SupportedSimdLevel()); }
+
+  // Random values with one extra element, so that the arrays can start at an
+  // unaligned offset.
+  std::vector<T> Random(size_t size) {
+    std::uniform_real_distribution<T> distribution(-10, 10);
+    std::vector<T> values(size + 1);
+    for (T &value : values) {
+      value = distribution(rng_);
+    }
+    return values;
+  }
+
+  static std::vector<SimdLevel> Levels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level :
+         {SimdLevel::kScalar, SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+      if (SetSimdLevel(level) == level) {
+        levels.push_back(level);
+      }
+    }
+    return levels;
+  }
+
+ private:
+  std::default_random_engine rng_{kSeed};
+};
+
+using ElementTypes = testing::Types<double, float>;
+TYPED_TEST_SUITE(VectorKernelsTest, ElementTypes);
+
+TYPED_TEST(VectorKernelsTest, ElementWiseKernelsMatchScalarLoops) {
+  using T = TypeParam;
+  const T scalar = T(1.7);
+  for (SimdLevel level : this->Levels()) {
+    ASSERT_EQ(SetSimdLevel(level), level);
+    for (size_t size = 0; size <= kMaxSize; ++size) {
+      for (size_t offset = 0; offset <= 1; ++offset) {
+        const std::vector<T> a = this->Random(size);
+        const std::vector<T> b = this->Random(size);
+        const T *pa = a.data() + offset;
+        const T *pb = b.data() + offset;
+        std::vector<T> sum(size + 1), difference(size + 1), product(size + 1),
+            quotient(size + 1);
+        kernels::Add(pa, pb, sum.data() + offset, size);
+        kernels::Subtract(pa, pb, difference.data() + offset, size);
+        kernels::Multiply(scalar, pa, product.data() + offset, size);
+        kernels::Divide(pa, scalar, quotient.data() + offset, size);
+
+        // Every element is one IEEE operation, so the results are exact.
+        for (size_t i = 0; i < size; ++i) {
+          const size_t j = i + offset;
+          ASSERT_EQ(sum[j], pa[i] + pb[i]) << int(level) << " " << size;
+          ASSERT_EQ(difference[j], pa[i] - pb[i]) << int(level) << " " << size;
+          ASSERT_EQ(product[j], scalar * pa[i]) << int(level) << " " << size;
+          ASSERT_EQ(quotient[j], pa[i] / scalar) << int(level) << " " << size;
+        }
+      }
+    }
+  }
+}
+
+TYPED_TEST(VectorKernelsTest, SumOfSquaresMatchesScalarLoop) {
+  using T = TypeParam;
+  for (SimdLevel level : this->Levels()) {
+    ASSERT_EQ(SetSimdLevel(level), level);
+    for (size_t size = 0; size <= kMaxSize; ++size) {
+      const std::vector<T> a = this->Random(size);
+      double expected = 0;
+      for (size_t i = 1; i <= size; ++i) {
+        expected += double(a[i]) * double(a[i]);
+      }
+      const double tolerance = 8 * size * std::numeric_limits<T>::epsilon();
+      EXPECT_NEAR(kernels::SumOfSquares(a.data() + 1, size), expected,
+                  tolerance * expected)
+          << int(level) << " " << size;
+    }
+  }
+}
+
+TYPED_TEST(VectorKernelsTest, OutputMayAliasInput) {
+  using T = TypeParam;
+  for (SimdLevel level : this->Levels()) {
+    ASSERT_EQ(SetSimdLevel(level), level);
+    std::vector<T> a = this->Random(kMaxSize);
+    const std::vector<T> original = a;
+    kernels::Add(a.data(), a.data(), a.data(), a.size());
+    kernels::Divide(a.data(), T(2), a.data(), a.size());
+    EXPECT_EQ(a, original) << int(level);
+  }
+}
+
+TYPED_TEST(VectorKernelsTest, OperatorsMatchScalarLevel) {
+  using T = TypeParam;
+  const std::vector<T> a = this->Random(kMaxSize);
+  const std::vector<T> b = this->Random(kMaxSize);
+  const T scalar = T(0.3);
+
+  ASSERT_EQ(SetSimdLevel(SimdLevel::kScalar), SimdLevel::kScalar);
+  const std::vector<T> expected = (scalar * (a + b) - a) / scalar;
+  const double expected_norm = norm(a, 3);
+
+  for (SimdLevel level : this->Levels()) {
+    ASSERT_EQ(SetSimdLevel(level), level);
+    EXPECT_EQ((scalar * (a + b) - a) / scalar, expected) << int(level);
+    std::vector<T> in_place = a + b;
+    in_place *= scalar;
+    in_place /= scalar;
+    EXPECT_EQ(in_place, (scalar * (a + b)) / scalar) << int(level);
+    EXPECT_NEAR(norm(a, 3), expected_norm, 1e-5 * expected_norm);
+    EXPECT_EQ(norm(a, a.size()), 0);
+  }
+  EXPECT_THROW(a + std::vector<T>(3), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace utils